@@ -26,6 +26,7 @@ topLevelStatement
     | uniformStatement
     | pushConstantsStatement
     | constantStatement
+    | userFunction
     | stageFunction
     ;
 
@@ -63,6 +64,17 @@ constantStatement
     : 'const' ('(' Index=INTEGER_LITERAL ')')? variableDeclaration '=' Value=atom ';'
     ;
 
+// User functions
+userFunction
+    : Attr=functionAttribute? RType=IDENTIFIER Name=IDENTIFIER
+        '(' (Params+=variableDeclaration (',' Params+=variableDeclaration)*)? ')' block
+    ;
+
+// Function inlining attributes ([[inline]] or [[noinline]])
+functionAttribute
+    : '[' '[' Name=IDENTIFIER ']' ']'
+    ;
+
 // Stage functions
 stageFunction
     : '@vert' block     # vertFunction
@@ -111,7 +123,7 @@ lvalue
 
 // If statement
 ifStatement
-    : 'if' '(' Cond=expression ')' (statement|block) (Elifs+=elifStatement)* Else=elseStatement?
+    : Attr=branchAttribute? 'if' '(' Cond=expression ')' (statement|block) (Elifs+=elifStatement)* Else=elseStatement?
     ;
 elifStatement
     : 'elif' '(' Cond=expression ')' (statement|block)
@@ -120,17 +132,22 @@ elseStatement
     : 'else' (statement|block)
     ;
 
+// Branch flattening attributes ([[branch]] or [[flatten]])
+branchAttribute
+    : '[' '[' Name=IDENTIFIER ']' ']'
+    ;
+
 // While/do-while
 whileLoop
-    : 'while' '(' Cond=expression ')' (statement|block)
+    : Attr=loopAttribute? 'while' '(' Cond=expression ')' (statement|block)
     ;
 doLoop
-    : 'do' (statement|block) 'while' '(' Cond=expression ')' ';'
+    : Attr=loopAttribute? 'do' (statement|block) 'while' '(' Cond=expression ')' ';'
     ;
 
 // For loop
 forLoop
-    : 'for' '(' Init=variableDefinition ';' Cond=expression ';' Updates+=forLoopUpdate (',' Updates+=forLoopUpdate)* ')'
+    : Attr=loopAttribute? 'for' '(' Init=variableDefinition ';' Cond=expression ';' Updates+=forLoopUpdate (',' Updates+=forLoopUpdate)* ')'
         (statement|block)
     ;
 forLoopUpdate
@@ -138,11 +155,17 @@ forLoopUpdate
     | LVal=lvalue Op=('--'|'++')
     ;
 
+// Loop unrolling attributes ([[unroll]] or [[loop]])
+loopAttribute
+    : '[' '[' Name=IDENTIFIER ']' ']'
+    ;
+
 // Statements that affect the flow of the program
 controlStatement
     : 'break' ';'
     | 'continue' ';'
     | 'discard' ';'
+    | 'return' Value=expression ';'
     ;
 
 
@@ -28,6 +28,7 @@ KW_GRAPHICS     : 'graphics' ;
 KW_IF           : 'if' ;
 KW_LOCAL        : 'local' ;
 KW_PUSH         : 'push' ;
+KW_RETURN       : 'return' ;
 KW_SHADER       : 'shader' ;
 KW_UNIF         : 'unif' ;
 KW_WHILE        : 'while' ;
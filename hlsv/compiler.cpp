@@ -6,7 +6,9 @@
  * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
  */
 
-// This file implements the Compiler class.
+// This file implements the Compiler and CompilerOptions classes. The compiler parses the file (either whole, or one
+//    top-level statement at a time when streaming), optionally collecting the ANTLR decision profile for the parse,
+//    and then writes the reflection file and the generated GLSL files.
 
 #include "config.hpp"
 #include "error_listener.hpp"
@@ -14,11 +16,17 @@
 #include "reflect/io.hpp"
 #include "fs/path.h"
 #include "antlr/ANTLRInputStream.h"
+#include "antlr/UnbufferedCharStream.h"
 #include "antlr/CommonTokenStream.h"
+#include "antlr/CommonTokenFactory.h"
+#include "antlr/atn/ParseInfo.h"
+#include "antlr/atn/DecisionState.h"
 #include "../generated/HLSVLexer.h"
 #include "../generated/HLSV.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <memory>
 
 #ifdef HLSV_COMPILER_MSVC
 	// It never sees reflect_ change, so it complains about dereferencing a null pointer that isnt actually null
@@ -31,6 +39,33 @@
 namespace hlsv
 {
 
+// ====================================================================================================================
+// The runtime does not implement toString() for unbuffered char streams, since the full text is never available
+class StreamCharStream final :
+	public antlr4::UnbufferedCharStream
+{
+public:
+	StreamCharStream(std::wistream& input) :
+		antlr4::UnbufferedCharStream(input)
+	{ }
+
+	std::string toString() const override { return ""; }
+}; // class StreamCharStream
+
+// ====================================================================================================================
+// Lexer that can optionally copy the text into the tokens, which is required when using an unbuffered char stream
+class StreamLexer final :
+	public grammar::HLSVLexer
+{
+public:
+	StreamLexer(antlr4::CharStream* input, bool copyText) :
+		grammar::HLSVLexer(input)
+	{
+		if (copyText)
+			_factory = std::make_shared<antlr4::CommonTokenFactory>(true);
+	}
+}; // class StreamLexer
+
 // ====================================================================================================================
 string CompilerError::get_rule_stack_str() const
 {
@@ -52,6 +87,18 @@ CompilerOptions::CompilerOptions() :
 	generate_reflection_file{ false },
 	use_binary_reflection{ false },
 	keep_intermediate{ false },
+	profile_parser{ false },
+	stream_parse{ false },
+	reflect_only{ false },
+	optimize{ true },
+	fast_math{ false },
+	hoist_vertex{ false },
+	pack_locals{ false },
+	strip_attributes{ false },
+	preshader{ false },
+	minify{ false },
+	lint{ false },
+	profile{ false },
 	limits{ DEFAULT_LIMITS }
 {
 
@@ -67,6 +114,9 @@ CompilerOptions::~CompilerOptions()
 Compiler::Compiler() :
 	last_error_{ CompilerError::ES_NONE, "" },
 	reflect_{ nullptr },
+	parser_profile_{ },
+	glsl_sizes_{ },
+	warnings_{ },
 	paths_{}
 {
 
@@ -88,21 +138,33 @@ bool Compiler::compile(const string& file, const CompilerOptions& options)
 	if (!preparePaths(file))
 		return false;
 		
-	// Read in the contents of the file
-	std::ifstream infile{ paths_.input_path, std::ios::in };
-	if (!infile.is_open()) {
-		SET_ERR(ES_FILEIO, "Input file does not exist, or cannot be opened.");
-		return false;
+	// Open the input, streaming reads the source as it is lexed instead of loading it all at once
+	std::unique_ptr<antlr4::CharStream> inputStream{};
+	std::wifstream winfile{};
+	if (options.stream_parse) {
+		winfile.open(paths_.input_path, std::ios::in);
+		if (!winfile.is_open()) {
+			SET_ERR(ES_FILEIO, "Input file does not exist, or cannot be opened.");
+			return false;
+		}
+		inputStream.reset(new StreamCharStream{ winfile });
+	}
+	else {
+		std::ifstream infile{ paths_.input_path, std::ios::in };
+		if (!infile.is_open()) {
+			SET_ERR(ES_FILEIO, "Input file does not exist, or cannot be opened.");
+			return false;
+		}
+		const string source = ([](std::ifstream& f) {
+			std::stringstream ss;
+			ss << f.rdbuf();
+			return ss.str();
+		})(infile);
+		inputStream.reset(new antlr4::ANTLRInputStream{ source });
 	}
-	const string source = ([](std::ifstream& f) {
-		std::stringstream ss;
-		ss << f.rdbuf();
-		return ss.str();
-	})(infile);
 
 	// Create the base ANTLR input objects
-	antlr4::ANTLRInputStream inputStream{ source };
-	grammar::HLSVLexer lexer{ &inputStream };
+	StreamLexer lexer{ inputStream.get(), options.stream_parse };
 	antlr4::CommonTokenStream tokens{ &lexer };
 	grammar::HLSV parser{ &tokens };
 
@@ -113,27 +175,31 @@ bool Compiler::compile(const string& file, const CompilerOptions& options)
 	lexer.addErrorListener(&listener);
 	parser.addErrorListener(&listener);
 
-	// Perform the lexing and parsing, report any error
-	auto fileCtx = parser.file();
-	if (listener.has_error()) {
-		last_error_ = listener.last_error;
-		return false;
+	// Clear the potential previous reflection and profiling info before populating it again
+	if (reflect_) {
+		delete reflect_;
+		reflect_ = nullptr;
 	}
+	parser_profile_.clear();
+	glsl_sizes_.clear();
+	warnings_.clear();
+	if (options.profile_parser)
+		parser.setProfile(true);
 
-	// Visit the tree (this is the generator step)
+	// Perform the lexing, parsing, and visiting (this is the generator step)
 	Visitor visitor{ &tokens, &reflect_, &options };
+	bool parsed = false;
 	try
 	{
-		// Clear the potential previous reflection info before populating it again
-		if (reflect_) {
-			delete reflect_;
-			reflect_ = nullptr;
-		}
-		auto any = visitor.visit(fileCtx);
+		parsed = options.stream_parse ? parseStreaming(&parser, &visitor, &listener) : parseFull(&parser, &visitor, &listener);
 	}
 	catch (const VisitError& ve)
 	{
 		last_error_ = ve.error;
+	}
+	if (options.profile_parser)
+		collectParserProfile(&parser);
+	if (!parsed) {
 		// Clear the reflection info on error
 		if (reflect_) {
 			delete reflect_;
@@ -141,9 +207,10 @@ bool Compiler::compile(const string& file, const CompilerOptions& options)
 		}
 		return false;
 	}
+	warnings_ = visitor.get_warnings();
 
 	// Generate the reflection info file
-	if (options.generate_reflection_file) {
+	if (options.generate_reflection_file || options.reflect_only) {
 		auto writer = options.use_binary_reflection ? ReflWriter::WriteBinary : ReflWriter::WriteText;
 		string err{};
 		if (!writer(paths_.reflection_path, *reflect_, err)) {
@@ -152,6 +219,12 @@ bool Compiler::compile(const string& file, const CompilerOptions& options)
 		}
 	}
 
+	// Reflection-only compiles do not generate any code
+	if (options.reflect_only) {
+		SET_ERR(ES_NONE, "");
+		return true;
+	}
+
 	// Write the glsl files
 	if (!writeGLSL(&visitor.get_generator())) {
 		cleanGLSL();
@@ -201,6 +274,92 @@ bool Compiler::preparePaths(const string& file)
 	return true;
 }
 
+// ====================================================================================================================
+bool Compiler::parseFull(void* parser, void* visitor, void* listener)
+{
+	grammar::HLSV* hlsv = static_cast<grammar::HLSV*>(parser);
+	Visitor* vis = static_cast<Visitor*>(visitor);
+	ErrorListener* lst = static_cast<ErrorListener*>(listener);
+
+	// Parse the entire file at once, then visit it
+	auto fileCtx = hlsv->file();
+	if (lst->has_error()) {
+		last_error_ = lst->last_error;
+		return false;
+	}
+	vis->visit(fileCtx);
+
+	return true;
+}
+
+// ====================================================================================================================
+bool Compiler::parseStreaming(void* parser, void* visitor, void* listener)
+{
+	grammar::HLSV* hlsv = static_cast<grammar::HLSV*>(parser);
+	Visitor* vis = static_cast<Visitor*>(visitor);
+	ErrorListener* lst = static_cast<ErrorListener*>(listener);
+	auto tokens = hlsv->getTokenStream();
+	auto& tracker = hlsv->getTreeTracker();
+
+	// Parse and visit the version statement
+	auto verCtx = hlsv->shaderVersionStatement();
+	if (lst->has_error()) {
+		last_error_ = lst->last_error;
+		return false;
+	}
+	vis->visit(verCtx);
+	auto firstToken = tokens->get(0);
+	tracker.reset();
+
+	// Parse and visit each top-level statement, freeing the parse tree after each one. The token stream still keeps
+	//    every token of the file, as the errors look up their tokens by index, so only the parse trees are freed.
+	while (tokens->LA(1) != antlr4::Token::EOF) {
+		auto tlsCtx = hlsv->topLevelStatement();
+		if (lst->has_error()) {
+			last_error_ = lst->last_error;
+			return false;
+		}
+		vis->visit(tlsCtx);
+		tracker.reset();
+	}
+
+	// Finish the shader
+	vis->finalize(firstToken);
+
+	return true;
+}
+
+// ====================================================================================================================
+void Compiler::collectParserProfile(void* parser)
+{
+	grammar::HLSV* hlsv = static_cast<grammar::HLSV*>(parser);
+	const auto& atn = hlsv->getATN();
+	const auto& rules = hlsv->getRuleNames();
+
+	for (const auto& di : hlsv->getParseInfo().getDecisionInfo()) {
+		if (di.invocations == 0)
+			continue;
+		auto ds = atn.getDecisionState(di.decision);
+		DecisionProfile dp{};
+		dp.decision = (uint32)di.decision;
+		dp.rule_name = (ds && ds->ruleIndex < rules.size()) ? rules[ds->ruleIndex] : "unknown";
+		dp.invocations = (uint64)di.invocations;
+		dp.time = (uint64)di.timeInPrediction;
+		dp.sll_lookahead = (uint64)di.SLL_TotalLook;
+		dp.sll_max_lookahead = (uint64)di.SLL_MaxLook;
+		dp.ll_lookahead = (uint64)di.LL_TotalLook;
+		dp.ll_max_lookahead = (uint64)di.LL_MaxLook;
+		dp.ll_fallbacks = (uint64)di.LL_Fallback;
+		dp.ambiguities = (uint64)di.ambiguities.size();
+		parser_profile_.push_back(dp);
+	}
+
+	// Sort with the most expensive decisions first
+	std::sort(parser_profile_.begin(), parser_profile_.end(), [](const DecisionProfile& l, const DecisionProfile& r) {
+		return (l.time == r.time) ? l.decision < r.decision : l.time > r.time;
+	});
+}
+
 // ====================================================================================================================
 bool Compiler::writeGLSL(void* gen)
 {
@@ -213,7 +372,10 @@ bool Compiler::writeGLSL(void* gen)
 			SET_ERR(ES_FILEIO, "Unable to write intermediate glsl file.");
 			return false;
 		}
-		file << glsl->vert_str();
+		auto src = glsl->vert_str();
+		file << src;
+		if (glsl->is_minified())
+			glsl_sizes_.push_back({ "vert", (uint32)glsl->stage_str(ShaderStages::Vertex, false).size(), (uint32)src.size() });
 	}
 
 	// Write fragment
@@ -223,7 +385,10 @@ bool Compiler::writeGLSL(void* gen)
 			SET_ERR(ES_FILEIO, "Unable to write intermediate glsl file.");
 			return false;
 		}
-		file << glsl->frag_str();
+		auto src = glsl->frag_str();
+		file << src;
+		if (glsl->is_minified())
+			glsl_sizes_.push_back({ "frag", (uint32)glsl->stage_str(ShaderStages::Fragment, false).size(), (uint32)src.size() });
 	}
 
 	return true;
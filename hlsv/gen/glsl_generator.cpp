@@ -10,10 +10,13 @@
 
 #include "glsl_generator.hpp"
 #include "../type/typehelper.hpp"
-#include "../visitor/visitor.hpp"
-#include <numeric>
-
-#define CSTAGE (*stage_funcs_.at(vis_->current_stage_))
+#include "../type/functions.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
 
 static const std::string VERSION_STR = "#version 450";
 static const std::string VERSION_CMT = "// Generated with hlsvc version ";
@@ -21,17 +24,57 @@ static const std::string EXTENSION_STR = "#extension %s : require\n";
 static const std::string EXTENSIONS [] = {
 	"GL_EXT_scalar_block_layout"
 };
+static const std::string FLOW_ATTR_EXTENSION = "GL_EXT_control_flow_attributes";
+static const char* const LOOP_HINT_STRS[] = { "", "[[unroll]] ", "[[dont_unroll]] " };
+static const char* const BRANCH_HINT_STRS[] = { "", "[[flatten]] ", "[[dont_flatten]] " };
 static const std::ios_base::openmode DOM = std::ios_base::out | std::ios_base::ate;
+// Keywords that are short enough to be generated as minified names
+static const std::set<std::string> SHORT_KEYWORDS = { "do", "if", "in" };
 
 
 namespace hlsv
 {
 
+// GLSL operator precedences, where larger values bind tighter
+static const uint32 PREC_TERNARY = 3;
+static const uint32 PREC_PREFIX = 15;
+static const uint32 PREC_POSTFIX = 16;
+static const uint32 PREC_PRIMARY = 17;
+
+// ====================================================================================================================
+static uint32 expr_precedence(const ir::Expr* expr)
+{
+	switch (expr->kind)
+	{
+	case ir::ExprKind::Unary:
+		return (expr->op == ir::Op::PostInc || expr->op == ir::Op::PostDec) ? PREC_POSTFIX : PREC_PREFIX;
+	case ir::ExprKind::Ternary: return PREC_TERNARY;
+	case ir::ExprKind::Binary: {
+		switch (expr->op)
+		{
+		case ir::Op::Mul: case ir::Op::Div: case ir::Op::Mod: return 14;
+		case ir::Op::Add: case ir::Op::Sub: return 13;
+		case ir::Op::Shl: case ir::Op::Shr: return 12;
+		case ir::Op::Lt: case ir::Op::Gt: case ir::Op::Le: case ir::Op::Ge: return 11;
+		case ir::Op::Eq: case ir::Op::Ne: return 10;
+		case ir::Op::BitAnd: return 9;
+		case ir::Op::BitXor: return 8;
+		case ir::Op::BitOr: return 7;
+		case ir::Op::LogAnd: return 6;
+		case ir::Op::LogOr: return 4; // Logical xor (5) is not generated
+		default: return PREC_TERNARY + 1;
+		}
+	}
+	default: return PREC_PRIMARY;
+	}
+}
+
 // ====================================================================================================================
-GLSLGenerator::GLSLGenerator(Visitor* vis) :
+GLSLGenerator::GLSLGenerator(Visitor* vis, bool minify) :
 	vis_{ vis },
-	vert_vars_{ },
-	frag_vars_{ },
+	decls_{ },
+	open_block_{ },
+	resource_stages_{ },
 	stage_funcs_{
 		{ ShaderStages::Vertex, new sstream{ "// Vertex stage\nvoid vert_main() {\n", DOM } },
 		{ ShaderStages::TessControl, new sstream{ "// TessControl stage\nvoid tesc_main() {\n", DOM } },
@@ -39,17 +82,15 @@ GLSLGenerator::GLSLGenerator(Visitor* vis) :
 		{ ShaderStages::Geometry, new sstream{ "// Geometry stage\nvoid geom_main() {\n", DOM } },
 		{ ShaderStages::Fragment, new sstream{ "// Fragment stage\nvoid frag_main() {\n", DOM } }
 	},
-	indent_str_{ "" }
+	min_funcs_{ },
+	attr_stages_{ ShaderStages::None },
+	minify_{ minify },
+	internal_names_{ }
 {
-	vert_vars_ << VERSION_CMT << HLSV_VERSION << '\n' << VERSION_STR << '\n';
-	frag_vars_ << VERSION_CMT << HLSV_VERSION << '\n' << VERSION_STR << '\n';
-	for (const auto& ext : EXTENSIONS) {
-		string estr = strarg(EXTENSION_STR.c_str(), ext.c_str());
-		vert_vars_ << estr;
-		frag_vars_ << estr;
+	if (minify_) {
+		for (const auto& pair : stage_funcs_)
+			min_funcs_[pair.first] = new sstream{ pair.second->str(), DOM };
 	}
-	vert_vars_ << '\n';
-	frag_vars_ << '\n';
 }
 
 // ====================================================================================================================
@@ -58,35 +99,77 @@ GLSLGenerator::~GLSLGenerator()
 	for (auto pair : stage_funcs_)
 		delete pair.second;
 	stage_funcs_.clear();
+	for (auto pair : min_funcs_)
+		delete pair.second;
+	min_funcs_.clear();
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_attribute(const Attribute& attr)
+string GLSLGenerator::header_str(ShaderStages stage) const
+{
+	// The extensions are only known after the stage functions are emitted, so the header is built last
+	sstream out{};
+	out << VERSION_CMT << HLSV_VERSION << '\n' << VERSION_STR << '\n';
+	for (const auto& ext : EXTENSIONS)
+		out << strarg(EXTENSION_STR.c_str(), ext.c_str());
+	if (attr_stages_ & stage)
+		out << strarg(EXTENSION_STR.c_str(), FLOW_ATTR_EXTENSION.c_str());
+	out << '\n';
+	return out.str();
+}
+
+// ====================================================================================================================
+string GLSLGenerator::stage_str(ShaderStages stage, bool minified) const
+{
+	if (!minified) {
+		return header_str(stage) + vars_str(stage, false) + '\n' + stage_funcs_.at(stage)->str();
+	}
+	return MinifyStr(header_str(stage) + vars_str(stage, true) + min_funcs_.at(stage)->str(), internal_names_);
+}
+
+// ====================================================================================================================
+string GLSLGenerator::vars_str(ShaderStages stage, bool minified) const
 {
-	vert_vars_ << "layout(location = " << (uint32)attr.location << ") in " << TypeHelper::GetGLSLStr(attr.type.type) 
-		       << ' ' << attr.name;
-	if (attr.type.is_array) {
-		vert_vars_ << '[' << (uint32)attr.type.count << ']';
+	sstream out{};
+	for (const auto& decl : decls_) {
+		if (!(decl.stages & stage))
+			continue;
+		if (!decl.resource.empty()) {
+			auto it = resource_stages_.find(decl.resource);
+			if (it != resource_stages_.end() && !(it->second & stage))
+				continue;
+		}
+		out << ((minified && !decl.min_text.empty()) ? decl.min_text : decl.text);
 	}
-	vert_vars_ << ";\n";
+	return out.str();
+}
+
+// ====================================================================================================================
+void GLSLGenerator::emit_attribute(const Attribute& attr)
+{
+	string varstr = strarg("layout(location = %u) in %s %s%s;\n", (uint32)attr.location,
+		TypeHelper::GetGLSLStr(attr.type.type).c_str(), attr.name.c_str(),
+		attr.type.is_array ? strarg("[%u]", (uint32)attr.type.count).c_str() : "");
+	add_decl(varstr, ShaderStages::Vertex, attr.name);
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_output(const Output& output)
 {
-	frag_vars_ << "layout(location = " << (uint32)output.location << ") out " << TypeHelper::GetGLSLStr(output.type.type)
-		       << ' ' << output.name << ";\n";
+	add_decl(strarg("layout(location = %u) out %s %s;\n", (uint32)output.location,
+		TypeHelper::GetGLSLStr(output.type.type).c_str(), output.name.c_str()), ShaderStages::Fragment);
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_local(const Variable& vrbl, uint32 loc)
+void GLSLGenerator::emit_local(const Variable& vrbl, uint32 loc, uint32 comp)
 {
-	string locstr = strarg("layout(location = %u) %s", loc, vrbl.local.is_flat ? "flat " : "");
+	string compstr = (comp != UINT32_MAX) ? strarg(", component = %u", comp) : "";
+	string locstr = strarg("layout(location = %u%s) %s", loc, compstr.c_str(), vrbl.local.is_flat ? "flat " : "");
 	string varstr = strarg(" %s %s%s;", TypeHelper::GetGLSLStr(vrbl.type.type).c_str(), vrbl.name.c_str(),
 		vrbl.type.is_array ? strarg("[%u]", vrbl.type.count).c_str() : "");
 
-	vert_vars_ << locstr << "out" << varstr << '\n';
-	frag_vars_ << locstr << "in" << varstr << '\n';
+	add_decl(locstr + "out" + varstr + '\n', ShaderStages::Vertex);
+	add_decl(locstr + "in" + varstr + '\n', ShaderStages::Fragment);
 }
 
 // ====================================================================================================================
@@ -98,25 +181,24 @@ void GLSLGenerator::emit_handle_uniform(const Uniform& uni)
 	string locstr = strarg("layout(set = %u, binding = %u%s)", (uint32)uni.set, (uint32)uni.binding, targstr.c_str());
 	string varstr = strarg(" uniform %s %s;", TypeHelper::GetGLSLStr(uni.type.type).c_str(), uni.name.c_str());
 
-	if (uni.type != HLSVType::SubpassInput) { // Error to have subpass inputs specified in any stage except fragment
-		vert_vars_ << locstr << varstr << '\n';
-	}
-	frag_vars_ << locstr << varstr << '\n';
+	// Error to have subpass inputs specified in any stage except fragment
+	auto stages = (uni.type != HLSVType::SubpassInput) ? ShaderStages::AllGraphics : ShaderStages::Fragment;
+	add_decl(locstr + varstr + '\n', stages, uni.name);
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_uniform_block_header(uint32 s, uint32 b)
 {
-	string head = strarg("layout(set = %u, binding = %u, scalar) uniform Block_%u_%u {", s, b, s, b);
-	vert_vars_ << head << '\n';
-	frag_vars_ << head << '\n';
+	open_block_ = BlockName(s, b);
+	add_decl(strarg("layout(set = %u, binding = %u, scalar) uniform %s {\n", s, b, open_block_.c_str()),
+		ShaderStages::AllGraphics, open_block_);
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_block_close()
 {
-	vert_vars_ << "};\n";
-	frag_vars_ << "};\n";
+	add_decl("};\n", ShaderStages::AllGraphics, open_block_);
+	open_block_.clear();
 }
 
 // ====================================================================================================================
@@ -125,26 +207,26 @@ void GLSLGenerator::emit_value_uniform(const Uniform& uni)
 	string varstr = strarg("\t%s %s%s;", TypeHelper::GetGLSLStr(uni.type.type).c_str(), uni.name.c_str(),
 		(uni.type.is_array ? strarg("[%u]", uni.type.count) : "").c_str());
 	string cmtstr = strarg(" // Offset: %u, Size: %u\n", uni.block.offset, uni.block.size);
-	vert_vars_ << varstr << cmtstr;
-	frag_vars_ << varstr << cmtstr;
+	add_decl(varstr + cmtstr, ShaderStages::AllGraphics, open_block_); // Blocks are emitted whole to keep the layout
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_push_constant_block_header()
 {
-	static const string HEADER = "layout(push_constant, scalar) uniform PushConstants {\n";
-	vert_vars_ << HEADER;
-	frag_vars_ << HEADER;
+	open_block_ = PushBlockName();
+	add_decl(strarg("layout(push_constant, scalar) uniform %s {\n", open_block_.c_str()), ShaderStages::AllGraphics,
+		open_block_);
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_push_constant(const PushConstant& pc)
 {
-	string varstr = strarg("\t%s %s%s;", TypeHelper::GetGLSLStr(pc.type.type).c_str(), pc.name.c_str(),
+	// Each stage only declares the members it uses, so the offsets are explicit to keep the layout
+	string varstr = strarg("\tlayout(offset = %u) %s %s%s;", (uint32)pc.offset,
+		TypeHelper::GetGLSLStr(pc.type.type).c_str(), pc.name.c_str(),
 		(pc.type.is_array ? strarg("[%u]", pc.type.count) : "").c_str());
-	string cmtstr = strarg(" // Offset: %u, Size: %u\n", pc.offset, pc.size);
-	vert_vars_ << varstr << cmtstr;
-	frag_vars_ << varstr << cmtstr;
+	string cmtstr = strarg(" // Size: %u\n", pc.size);
+	add_decl(varstr + cmtstr, ShaderStages::AllGraphics, pc.name);
 }
 
 // ====================================================================================================================
@@ -152,95 +234,372 @@ void GLSLGenerator::emit_spec_constant(const SpecConstant& sc, const Expr& expr)
 {
 	string locstr = strarg("layout(constant_id = %u)", (uint32)sc.index);
 	string varstr = strarg(" const %s %s = %s;\n", TypeHelper::GetGLSLStr(sc.type.type).c_str(), sc.name.c_str(),
-		expr.text.c_str());
-	vert_vars_ << locstr << varstr;
-	frag_vars_ << locstr << varstr;
+		ExprStr(expr.node).c_str());
+	add_decl(locstr + varstr, ShaderStages::AllGraphics, sc.name);
 }
 
 // ====================================================================================================================
 void GLSLGenerator::emit_global_constant(const Variable& vrbl, const Expr& expr)
 {
 	string varstr = strarg("%s %s%s = %s;\n", TypeHelper::GetGLSLStr(vrbl.type.type).c_str(), vrbl.name.c_str(),
-		vrbl.type.is_array ? strarg("[%u]", vrbl.type.count).c_str() : "", expr.text.c_str());
-	vert_vars_ << varstr;
-	frag_vars_ << varstr;
+		vrbl.type.is_array ? strarg("[%u]", vrbl.type.count).c_str() : "", ExprStr(expr.node).c_str());
+	add_decl(varstr, ShaderStages::AllGraphics);
+	if (minify_)
+		internal_names_.insert(vrbl.name); // Global constants are not part of the reflection info
+}
+
+// ====================================================================================================================
+void GLSLGenerator::emit_profile_buffer(uint32 s, uint32 b, const ir::Symbol& counters, uint32 count)
+{
+	string name = ProfileBlockName();
+	add_decl(strarg("layout(set = %u, binding = %u, std430) buffer %s {\n\tuint %s[%u];\n};\n", s, b, name.c_str(),
+		counters.name, count), ShaderStages::AllGraphics, name);
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_func_block_close()
+void GLSLGenerator::emit_function(const ir::Function& func)
 {
-	CSTAGE << indent_str_ << "}\n";
+	auto& out = *stage_funcs_.at(func.stage);
+	if (HasFlowHints(func.body))
+		attr_stages_ |= func.stage;
+	emit_block(out, func.body, 1, false);
+	out << "}\n";
+	if (minify_) {
+		auto& mout = *min_funcs_.at(func.stage);
+		emit_block(mout, func.body, 1, true);
+		mout << "}\n";
+	}
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_variable_declaration(const Variable& vrbl, Expr* value)
+void GLSLGenerator::emit_user_function(const ir::Function& func)
 {
-	string varstr = TypeHelper::GetGLSLStr(vrbl.type.type) + ' ' + vrbl.name;
-	CSTAGE << indent_str_ << varstr;
-	if (value)
-		CSTAGE << " = " << value->text;
-	CSTAGE << ";\n";
+	auto func_str = [this, &func](bool minify) -> string {
+		sstream out{};
+		out << '\n' << TypeHelper::GetGLSLStr(func.return_type.type) << ' ' << func.name << '(';
+		for (uint32 i = 0; i < func.param_count; ++i) {
+			auto param = func.params[i];
+			out << ((i == 0) ? "" : ", ") << TypeHelper::GetGLSLStr(param->type.type) << ' ' << param->name;
+		}
+		out << ") {\n";
+		emit_block(out, func.body, 1, minify);
+		out << "}\n";
+		return out.str();
+	};
+
+	if (HasFlowHints(func.body))
+		attr_stages_ |= func.stage;
+	decls_.push_back({ func_str(false), func.stage, "", minify_ ? func_str(true) : "" });
+	if (minify_) {
+		internal_names_.insert(func.name);
+		for (uint32 i = 0; i < func.param_count; ++i)
+			internal_names_.insert(func.params[i]->name);
+	}
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_assignment(const string& vrbl, const string& op, const Expr& value)
+void GLSLGenerator::emit_block(sstream& out, const ir::Block& block, uint32 depth, bool minify)
 {
-	CSTAGE << indent_str_ << vrbl << ' ' << op << ' ' << value.text << ";\n";
+	string indent(depth, '\t');
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		switch (stmt->kind)
+		{
+		case ir::StmtKind::If: {
+			out << indent << BRANCH_HINT_STRS[(uint8)stmt->branch_hint] << "if (" << ExprStr(stmt->value, minify) << ") {\n";
+			emit_block(out, stmt->body, depth + 1, minify);
+			out << indent << "}\n";
+			auto els = stmt;
+			while (els->else_body.first && els->else_body.first->is_elif) { // Flatten the elif chain
+				els = els->else_body.first;
+				out << indent << "else if (" << ExprStr(els->value, minify) << ") {\n";
+				emit_block(out, els->body, depth + 1, minify);
+				out << indent << "}\n";
+			}
+			if (!els->else_body.empty()) {
+				out << indent << "else {\n";
+				emit_block(out, els->else_body, depth + 1, minify);
+				out << indent << "}\n";
+			}
+		} break;
+		case ir::StmtKind::While: {
+			out << indent << LOOP_HINT_STRS[(uint8)stmt->hint] << "while (" << ExprStr(stmt->value, minify) << ") {\n";
+			emit_block(out, stmt->body, depth + 1, minify);
+			out << indent << "}\n";
+		} break;
+		case ir::StmtKind::DoWhile: {
+			out << indent << LOOP_HINT_STRS[(uint8)stmt->hint] << "do {\n";
+			emit_block(out, stmt->body, depth + 1, minify);
+			out << indent << "} while (" << ExprStr(stmt->value, minify) << ");\n";
+		} break;
+		case ir::StmtKind::For: {
+			if (minify)
+				internal_names_.insert(stmt->symbol->name);
+			out << indent << LOOP_HINT_STRS[(uint8)stmt->hint] << "for (" << TypeHelper::GetGLSLStr(stmt->symbol->type.type) << ' ' << stmt->symbol->name
+				<< " = " << ExprStr(stmt->init, minify) << "; " << ExprStr(stmt->value, minify) << ';';
+			for (auto up = stmt->updates.first; up; up = up->next)
+				out << ((up == stmt->updates.first) ? " " : ", ") << StmtStr(up, minify);
+			out << ") {\n";
+			emit_block(out, stmt->body, depth + 1, minify);
+			out << indent << "}\n";
+		} break;
+		default:
+			if (minify && stmt->kind == ir::StmtKind::Declare)
+				internal_names_.insert(stmt->symbol->name);
+			out << indent << StmtStr(stmt, minify) << ";\n";
+			break;
+		}
+	}
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_if_statement(const Expr& cond)
+/* static */ bool GLSLGenerator::HasFlowHints(const ir::Block& block)
 {
-	CSTAGE << indent_str_ << "if (" << cond.text << ") {\n";
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->hint != ir::LoopHint::None || stmt->branch_hint != ir::BranchHint::None)
+			return true;
+		if (HasFlowHints(stmt->body) || HasFlowHints(stmt->else_body))
+			return true;
+	}
+	return false;
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_elif_statement(const Expr& cond)
+/* static */ string GLSLGenerator::StmtStr(const ir::Stmt* stmt, bool minify)
 {
-	CSTAGE << indent_str_ << "else if (" << cond.text << ") {\n";
+	switch (stmt->kind)
+	{
+	case ir::StmtKind::Declare: {
+		string decl = TypeHelper::GetGLSLStr(stmt->symbol->type.type) + ' ' + stmt->symbol->name;
+		return stmt->value ? (decl + " = " + ExprStr(stmt->value, minify)) : decl;
+	}
+	case ir::StmtKind::Assign:
+		return strarg("%s %s= %s", ExprStr(stmt->target, minify).c_str(), ir::GetOpStr(stmt->op),
+			ExprStr(stmt->value, minify).c_str());
+	case ir::StmtKind::Eval: return ExprStr(stmt->value, minify);
+	case ir::StmtKind::Break: return "break";
+	case ir::StmtKind::Continue: return "continue";
+	case ir::StmtKind::Discard: return "discard";
+	case ir::StmtKind::Return: return "return " + ExprStr(stmt->value, minify);
+	default: return "";
+	}
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_else_statement()
+/* static */ string GLSLGenerator::FloatStr(float f)
 {
-	CSTAGE << indent_str_ << "else {\n";
+	// Use the shortest representation that reads back as the exact same value
+	char buf[32];
+	for (int prec = 6; prec <= 9; ++prec) {
+		std::snprintf(buf, sizeof(buf), "%.*g", prec, f);
+		if (std::strtof(buf, nullptr) == f)
+			break;
+	}
+	string str{ buf };
+	if (str.find_first_of(".e") == string::npos)
+		str += ".0"; // Must be recognized as a float literal
+	return str;
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_while_loop(const Expr& cond)
+/* static */ string GLSLGenerator::ExprStr(const ir::Expr* expr, bool minify)
 {
-	CSTAGE << indent_str_ << "while (" << cond.text << ") {\n";
+	// Joins the argument list of an expression
+	auto join_args = [minify](const ir::Expr* ex) -> string {
+		string str{};
+		for (uint32 i = 0; i < ex->arg_count; ++i) {
+			if (i != 0) str += ", ";
+			str += ExprStr(ex->args[i], minify);
+		}
+		return str;
+	};
+	// Gets the string for an operand, wrapped in parentheses if it binds looser than the required precedence
+	auto operand = [minify](const ir::Expr* ex, uint32 prec) -> string {
+		auto str = ExprStr(ex, minify);
+		return (minify && (expr_precedence(ex) < prec)) ? ('(' + str + ')') : str;
+	};
+
+	switch (expr->kind)
+	{
+	case ir::ExprKind::Literal: {
+		switch (expr->type.type)
+		{
+		case HLSVType::Bool: return expr->value.ui ? "true" : "false";
+		case HLSVType::Float: return FloatStr(expr->value.f);
+		case HLSVType::Int: return strarg("%d", expr->value.si);
+		default: return strarg("%uu", expr->value.ui);
+		}
+	}
+	case ir::ExprKind::Variable: return expr->symbol->name;
+	case ir::ExprKind::Unary: {
+		auto val = operand(expr->args[0], PREC_PREFIX);
+		if (expr->args[0]->kind == ir::ExprKind::Unary || val[0] == '-') // Stop '-' from merging into '--'
+			val = '(' + val + ')';
+		return (expr->op == ir::Op::PostInc || expr->op == ir::Op::PostDec) ? (val + ir::GetOpStr(expr->op)) :
+			(ir::GetOpStr(expr->op) + val);
+	}
+	case ir::ExprKind::Binary: {
+		// Operators are left associative, so the right operand also needs parentheses at the same precedence
+		auto prec = expr_precedence(expr);
+		auto str = strarg("%s %s %s", operand(expr->args[0], prec).c_str(), ir::GetOpStr(expr->op),
+			operand(expr->args[1], prec + 1).c_str());
+		return minify ? str : ('(' + str + ')');
+	}
+	case ir::ExprKind::Ternary: {
+		auto str = strarg("%s ? %s : %s", operand(expr->args[0], PREC_TERNARY + 1).c_str(),
+			ExprStr(expr->args[1], minify).c_str(), ExprStr(expr->args[2], minify).c_str());
+		return minify ? str : ('(' + str + ')');
+	}
+	case ir::ExprKind::Index:
+		return operand(expr->args[0], PREC_POSTFIX) + '[' + ExprStr(expr->args[1], minify) + ']';
+	case ir::ExprKind::Swizzle: {
+		string str = operand(expr->args[0], PREC_POSTFIX) + '.';
+		for (uint8 i = 0; i < expr->swizzle_count; ++i)
+			str += "xyzw"[expr->swizzle[i]];
+		return str;
+	}
+	case ir::ExprKind::Construct: return TypeHelper::GetGLSLStr(expr->type.type) + "( " + join_args(expr) + " )";
+	case ir::ExprKind::InitList:
+		return HLSVType::IsScalarType(expr->type.type) ? ("{ " + join_args(expr) + " }") :
+			(TypeHelper::GetGLSLStr(expr->type.type) + "[]( " + join_args(expr) + " )");
+	case ir::ExprKind::Call: return string(expr->out_name) + "( " + join_args(expr) + " )";
+	default: return "";
+	}
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_do_loop()
+static inline bool is_word_char(char c)
 {
-	CSTAGE << indent_str_ << "do {\n";
+	return std::isalnum((unsigned char)c) || (c == '_');
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_do_loop_close(const Expr& cond)
+// Gets the length of the operator token at the position, matching the longest multi-character operator first
+static size_t op_length(const string& src, size_t pos)
 {
-	CSTAGE << indent_str_ << "} while (" << cond.text << ");\n";
+	static const char* const MULTI_OPS[] = {
+		"<<=", ">>=", "++", "--", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<", ">>", "<=", ">=", "==", "!=",
+		"&&", "||", "^^"
+	};
+	for (auto op : MULTI_OPS) {
+		auto len = std::strlen(op);
+		if (src.compare(pos, len, op) == 0)
+			return len;
+	}
+	return 1;
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_for_loop(const Variable& var, const Expr& init, const Expr& cond, const std::vector<string>& updates)
+// Gets the name for the index, with the first 52 names being a single letter
+static string short_name(uint32 idx)
 {
-	auto itxt = strarg("%s %s = (%s)", TypeHelper::GetGLSLStr(var.type.type).c_str(), var.name.c_str(), init.text.c_str());
-	string utxt = "";
-	if (updates.size() > 0) {
-		utxt = std::accumulate(updates.begin() + 1, updates.end(), updates[0], [](const string& acc, const string& str) {
-			return acc + ", " + str;
-		});
+	static const char* const CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+	string name(1, CHARS[idx % 52]);
+	idx /= 52;
+	while (idx > 0) {
+		--idx;
+		name += CHARS[idx % 62];
+		idx /= 62;
 	}
-	CSTAGE << indent_str_ << "for (" << itxt << "; " << cond.text << "; " << utxt << ") {\n";
+	return name;
 }
 
 // ====================================================================================================================
-void GLSLGenerator::emit_control_statement(const string& stat)
+/* static */ string GLSLGenerator::MinifyStr(const string& src, const std::set<string>& names)
 {
-	CSTAGE << indent_str_ << stat << ";\n";
+	// A source token, where preprocessor directives are kept as a single token for the whole line
+	struct Token
+	{
+		string text;
+		bool directive;
+		bool renamed; // If the token is one of the names to rename (member and swizzle names are never renamed)
+	};
+
+	// Split the source into tokens, dropping all whitespace and comments
+	std::vector<Token> tokens{};
+	std::set<string> used{}; // The new names cannot collide with any existing identifier
+	std::unordered_map<string, uint32> counts{};
+	bool line_start = true;
+	for (size_t i = 0; i < src.size(); ) {
+		char c = src[i];
+		if (c == '\n' || std::isspace((unsigned char)c)) {
+			line_start = line_start || (c == '\n');
+			++i;
+		}
+		else if (c == '#' && line_start) {
+			auto end = std::min(src.find('\n', i), src.size());
+			tokens.push_back({ src.substr(i, end - i), true, false });
+			i = end;
+		}
+		else if (src.compare(i, 2, "//") == 0) {
+			i = std::min(src.find('\n', i), src.size());
+		}
+		else if (is_word_char(c)) {
+			size_t end = i;
+			while (end < src.size() && is_word_char(src[end]))
+				++end;
+			Token tok{ src.substr(i, end - i), false, false };
+			if (!std::isdigit((unsigned char)c)) {
+				used.insert(tok.text);
+				bool member = !tokens.empty() && (tokens.back().text == ".");
+				tok.renamed = !member && names.count(tok.text) && !FunctionRegistry::IsBuiltinFunction(tok.text);
+				if (tok.renamed)
+					++counts[tok.text];
+			}
+			tokens.push_back(tok);
+			line_start = false;
+			i = end;
+		}
+		else {
+			auto len = op_length(src, i);
+			tokens.push_back({ src.substr(i, len), false, false });
+			line_start = false;
+			i += len;
+		}
+	}
+
+	// The most used names get the shortest new names
+	std::vector<std::pair<string, uint32>> order{ counts.begin(), counts.end() };
+	std::sort(order.begin(), order.end(), [](const std::pair<string, uint32>& l, const std::pair<string, uint32>& r) {
+		return (l.second == r.second) ? (l.first < r.first) : (l.second > r.second);
+	});
+	std::unordered_map<string, string> renames{};
+	uint32 next = 0;
+	for (const auto& pair : order) {
+		string name{};
+		do {
+			name = short_name(next++);
+		} while (used.count(name) || SHORT_KEYWORDS.count(name));
+		renames[pair.first] = (name.size() < pair.first.size()) ? name : pair.first;
+	}
+
+	// Join the tokens, only adding spaces where the tokens would otherwise merge
+	string out{};
+	out.reserve(src.size());
+	const string* last = nullptr; // The last operator token, if it ends the output
+	for (const auto& tok : tokens) {
+		if (tok.directive) {
+			if (!out.empty() && out.back() != '\n')
+				out += '\n';
+			out += tok.text + '\n';
+			last = nullptr;
+			continue;
+		}
+		const string& text = tok.renamed ? renames.at(tok.text) : tok.text;
+		if (!out.empty()) {
+			bool space = is_word_char(out.back()) && is_word_char(text[0]);
+			if (last && !is_word_char(text[0])) { // Operators merge if they would lex as a longer operator or comment
+				string joined = *last + text;
+				auto edge = joined.substr(last->size() - 1, 2);
+				space = (op_length(joined, 0) > last->size()) || (edge == "//") || (edge == "/*");
+			}
+			if (space)
+				out += ' ';
+		}
+		out += text;
+		last = is_word_char(text[0]) ? nullptr : &text;
+	}
+	out += '\n';
+	return out;
 }
 
 } // namespace hlsv
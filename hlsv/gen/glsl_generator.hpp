@@ -13,8 +13,10 @@
 #include "../config.hpp"
 #include "../type/variable.hpp"
 #include "../visitor/expr.hpp"
+#include "../ir/ir.hpp"
 #include <sstream>
 #include <map>
+#include <set>
 
 
 namespace hlsv
@@ -22,32 +24,49 @@ namespace hlsv
 
 class Visitor;
 
-// Generates GLSL source by emitting operations one at a time
+// Generates GLSL source by emitting global declarations one at a time, and printing the IR for stage functions
 class GLSLGenerator final
 {
 	using sstream = std::ostringstream;
 
+	// A global declaration, which is only emitted into the stages that use the resource it belongs to (if any)
+	struct Declaration
+	{
+		string text;
+		ShaderStages stages;
+		string resource;
+		string min_text; // The text with minimal parentheses, if it is different from text
+	};
+
 private:
 	Visitor* vis_;
-	sstream vert_vars_;
-	sstream frag_vars_;
+	std::vector<Declaration> decls_;
+	string open_block_; // The resource name of the block that is currently being declared
+	std::map<string, ShaderStages> resource_stages_; // Resources not in the map are emitted into all stages
 	std::map<ShaderStages, sstream*> stage_funcs_;
-	string indent_str_;
+	std::map<ShaderStages, sstream*> min_funcs_; // The stage functions with minimal parentheses, if minifying
+	ShaderStages attr_stages_; // The stages that use the control flow attributes
+	bool minify_;
+	std::set<string> internal_names_; // The names that are not visible to the application, and can be renamed
 
 public:
-	GLSLGenerator(Visitor* vis);
+	GLSLGenerator(Visitor* vis, bool minify);
 	~GLSLGenerator();
 	
-	inline string vert_str() const {
-		return vert_vars_.str() + '\n' + stage_funcs_.at(ShaderStages::Vertex)->str();
-	}
-	inline string frag_str() const {
-		return frag_vars_.str() + '\n' + stage_funcs_.at(ShaderStages::Fragment)->str();
-	}
+	inline bool is_minified() const { return minify_; }
+	inline string vert_str() const { return stage_str(ShaderStages::Vertex, minify_); }
+	inline string frag_str() const { return stage_str(ShaderStages::Fragment, minify_); }
+	string stage_str(ShaderStages stage, bool minified) const; // Minified source is only available when minifying
+
+	// Sets the stages that use the resource (uniform, uniform block, push constant, or spec constant name)
+	inline void set_resource_stages(const string& name, ShaderStages stages) { resource_stages_[name] = stages; }
+	static string BlockName(uint32 s, uint32 b) { return strarg("Block_%u_%u", s, b); }
+	static string PushBlockName() { return "PushConstants"; }
+	static string ProfileBlockName() { return "ProfileCounters"; }
 
 	void emit_attribute(const Attribute& attr);
 	void emit_output(const Output& output);
-	void emit_local(const Variable& vrbl, uint32 loc);
+	void emit_local(const Variable& vrbl, uint32 loc, uint32 comp = UINT32_MAX); // No component qualifier by default
 	void emit_handle_uniform(const Uniform& uni);
 	void emit_uniform_block_header(uint32 s, uint32 b);
 	void emit_block_close();
@@ -56,21 +75,24 @@ public:
 	void emit_push_constant(const PushConstant& pc);
 	void emit_spec_constant(const SpecConstant& sc, const Expr& expr);
 	void emit_global_constant(const Variable& vrbl, const Expr& expr);
+	void emit_profile_buffer(uint32 s, uint32 b, const ir::Symbol& counters, uint32 count);
 
-	inline void push_indent() { indent_str_ += '\t'; }
-	inline void pop_indent() { indent_str_ = indent_str_.substr(1); }
-	void emit_func_block_close();
-	void emit_variable_declaration(const Variable& vrbl, Expr* value);
-	void emit_assignment(const string& vrbl, const string& op, const Expr& value);
-
-	void emit_if_statement(const Expr& cond);
-	void emit_elif_statement(const Expr& cond);
-	void emit_else_statement();
-	void emit_while_loop(const Expr& cond);
-	void emit_do_loop();
-	void emit_do_loop_close(const Expr& cond);
-	void emit_for_loop(const Variable& var, const Expr& init, const Expr& cond, const std::vector<string>& updates);
-	void emit_control_statement(const string& stat);
+	void emit_function(const ir::Function& func);
+	void emit_user_function(const ir::Function& func); // Only emitted into the stages that call the function
+
+	static string ExprStr(const ir::Expr* expr, bool minify = false); // Minify only keeps the required parentheses
+	static string FloatStr(float f); // Shortest string that exactly round-trips the value
+
+private:
+	string header_str(ShaderStages stage) const; // The version and extension directives
+	string vars_str(ShaderStages stage, bool minified) const; // The global declarations used by the stage
+	inline void add_decl(const string& text, ShaderStages stages, const string& resource = "") {
+		decls_.push_back({ text, stages, resource, "" });
+	}
+	void emit_block(sstream& out, const ir::Block& block, uint32 depth, bool minify);
+	static string StmtStr(const ir::Stmt* stmt, bool minify); // Single line statements, without the trailing semicolon
+	static string MinifyStr(const string& src, const std::set<string>& names); // Strips and renames the source
+	static bool HasFlowHints(const ir::Block& block);
 }; // class GLSLGenerator
 
 } // namespace hlsv
@@ -0,0 +1,71 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements arena.hpp
+
+#include "arena.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+constexpr size_t Arena::BLOCK_SIZE;
+
+// ====================================================================================================================
+Arena::Arena() :
+	blocks_{ },
+	head_{ nullptr },
+	remain_{ 0 },
+	total_{ 0 }
+{
+
+}
+
+// ====================================================================================================================
+Arena::~Arena()
+{
+	for (auto block : blocks_)
+		delete[] block;
+	blocks_.clear();
+}
+
+// ====================================================================================================================
+void* Arena::allocate(size_t size, size_t align)
+{
+	// Align the head, and get a new block if there is not enough room
+	size_t pad = (align - ((size_t)head_ % align)) % align;
+	if (!head_ || (size + pad) > remain_) {
+		size_t bsize = std::max(BLOCK_SIZE, size + align);
+		blocks_.push_back(new uint8[bsize]);
+		head_ = blocks_.back();
+		remain_ = bsize;
+		pad = (align - ((size_t)head_ % align)) % align;
+	}
+
+	void* ptr = head_ + pad;
+	head_ += (pad + size);
+	remain_ -= (pad + size);
+	total_ += size;
+	return ptr;
+}
+
+// ====================================================================================================================
+const char* Arena::copy_str(const string& str)
+{
+	char* ptr = static_cast<char*>(allocate(str.length() + 1, 1));
+	std::memcpy(ptr, str.c_str(), str.length() + 1);
+	return ptr;
+}
+
+} // namespace ir
+} // namespace hlsv
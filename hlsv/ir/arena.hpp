@@ -0,0 +1,65 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the arena allocator used to store the intermediate representation
+
+#pragma once
+
+#include "../config.hpp"
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// Bump allocator that releases all of its allocations at once when destroyed, only trivially destructible types
+//    can be allocated, as destructors are never run
+class Arena final
+{
+	_DECLARE_NOCOPY(Arena)
+	_DECLARE_NOMOVE(Arena)
+
+public:
+	static constexpr size_t BLOCK_SIZE = 16384;
+
+private:
+	std::vector<uint8*> blocks_;
+	uint8* head_;     // The next free byte in the current block
+	size_t remain_;   // The number of free bytes left in the current block
+	size_t total_;    // The total number of bytes handed out
+
+public:
+	Arena();
+	~Arena();
+
+	void* allocate(size_t size, size_t align);
+	const char* copy_str(const string& str);
+
+	template<typename T, typename... Args>
+	T* make(Args&&... args) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena types must be trivially destructible.");
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+	template<typename T>
+	T* make_array(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena types must be trivially destructible.");
+		if (count == 0)
+			return nullptr;
+		return new (allocate(sizeof(T) * count, alignof(T))) T[count]();
+	}
+
+	inline size_t total_size() const { return total_; }
+}; // class Arena
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,219 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the static cost estimate of the stage functions, which is reported in the reflection info. The
+//    costs are rough per-component throughput numbers for scalar GPU architectures, not exact cycle counts.
+
+#include "passes.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The cost of division and modulo, which are a reciprocal and a multiply (or an integer sequence)
+static const uint32 DIV_COST = 4;
+// Loops with larger constant trip counts are counted as dynamic loops
+static const uint32 MAX_COUNTED_TRIPS = 1024;
+
+// The per-component cost of the builtin functions that cost more than a single operation, by generated name
+struct BuiltinCost final
+{
+	const char* name;
+	uint32 cost;
+};
+static const BuiltinCost BUILTIN_COSTS[] = {
+	// Transcendental functions run on the quarter-rate special function units
+	{ "sin", 4 }, { "cos", 4 }, { "tan", 8 }, { "asin", 8 }, { "acos", 8 }, { "atan", 8 },
+	{ "sinh", 8 }, { "cosh", 8 }, { "tanh", 8 }, { "asinh", 8 }, { "acosh", 8 }, { "atanh", 8 },
+	{ "pow", 9 }, { "exp", 5 }, { "log", 5 }, { "exp2", 4 }, { "log2", 4 }, { "sqrt", 4 }, { "inversesqrt", 4 },
+	// Functions that are built from several operations
+	{ "radians", 1 }, { "degrees", 1 }, { "mod", 6 }, { "smoothstep", 4 }, { "mix", 2 }, { "fract", 2 },
+	{ "length", 2 }, { "distance", 3 }, { "normalize", 3 }, { "reflect", 3 }, { "refract", 6 },
+	{ "faceForward", 2 }, { "cross", 2 }, { "determinant", 2 }, { "inverse", 8 }
+};
+
+// The counts for the stage, in larger types so loop multiplication cannot overflow before the final clamp
+struct CostInfo final
+{
+	uint64 alu;
+	uint64 samples;
+	uint64 fetches;
+	uint64 image_loads;
+	uint64 image_stores;
+	uint64 dynamic_indexing;
+	uint64 dynamic_loops;
+	bool discard;
+	uint64 scale;   // The number of times the current statement runs, from the enclosing constant loops
+	Module* module; // Used for the temporary nodes created when finding the loop trip counts
+};
+
+// ====================================================================================================================
+static uint32 builtin_cost(const char* name)
+{
+	for (const auto& bc : BUILTIN_COSTS) {
+		if (std::strcmp(bc.name, name) == 0)
+			return bc.cost;
+	}
+	return 1;
+}
+
+// ====================================================================================================================
+// The number of components processed by the expression, which is the largest of the result and the arguments
+static uint64 op_width(const Expr* expr)
+{
+	uint64 width = expr->type.is_value_type() ? expr->type.get_component_count() : 1;
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		const auto& type = expr->args[i]->type;
+		if (type.is_value_type() && !type.is_array)
+			width = std::max<uint64>(width, type.get_component_count());
+	}
+	return width;
+}
+
+// ====================================================================================================================
+static void block_cost(const Block& block, CostInfo& info);
+
+// ====================================================================================================================
+static void expr_cost(const Expr* expr, CostInfo& info)
+{
+	if (!expr)
+		return;
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr_cost(expr->args[i], info);
+
+	uint64 cost = 0;
+	switch (expr->kind)
+	{
+	case ExprKind::Unary: // Negation is a free source modifier
+		cost = (expr->op == Op::Neg || expr->op == Op::Pos) ? 0 : op_width(expr);
+		break;
+	case ExprKind::Binary: {
+		const auto& lt = expr->args[0]->type;
+		const auto& rt = expr->args[1]->type;
+		if (expr->op == Op::Mul && (lt.is_matrix_type() || rt.is_matrix_type())) {
+			// Matrix-vector products are one multiply-add per matrix component, matrix products are one per column
+			uint64 dim = (lt.is_matrix_type() ? lt.type : rt.type) - HLSVType::Mat2 + 2;
+			cost = (lt.is_matrix_type() && rt.is_matrix_type()) ? (dim * dim * dim) : (dim * dim);
+		}
+		else if (expr->op == Op::Div || expr->op == Op::Mod)
+			cost = op_width(expr) * DIV_COST;
+		else
+			cost = op_width(expr);
+	} break;
+	case ExprKind::Ternary: cost = op_width(expr); break;
+	case ExprKind::Index:
+		if (expr->args[0]->type.is_array && !expr->args[1]->is_constant)
+			info.dynamic_indexing += info.scale;
+		break;
+	case ExprKind::Construct: // Component type conversions are the only constructors that are not just moves
+		if (expr->arg_count == 1 && expr->args[0]->type.is_value_type() &&
+				expr->args[0]->type.get_component_type() != expr->type.get_component_type())
+			cost = op_width(expr);
+		break;
+	case ExprKind::Call: {
+		if (expr->func) { // User functions that are not inlined are counted at each call
+			block_cost(expr->func->body, info);
+			break;
+		}
+		const char* name = expr->out_name;
+		if (!std::strcmp(name, "texture") || !std::strcmp(name, "textureLod"))
+			info.samples += info.scale;
+		else if (!std::strcmp(name, "texelFetch") || !std::strcmp(name, "subpassLoad"))
+			info.fetches += info.scale;
+		else if (!std::strcmp(name, "imageLoad"))
+			info.image_loads += info.scale;
+		else if (!std::strcmp(name, "imageStore"))
+			info.image_stores += info.scale;
+		else
+			cost = op_width(expr) * builtin_cost(name);
+	} break;
+	default: break;
+	}
+	info.alu += cost * info.scale;
+}
+
+// ====================================================================================================================
+static void block_cost(const Block& block, CostInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		expr_cost(stmt->target, info);
+		switch (stmt->kind)
+		{
+		case StmtKind::Assign:
+			expr_cost(stmt->value, info);
+			if (stmt->op != Op::None) // The compound operator is an extra operation
+				info.alu += op_width(stmt->target) * ((stmt->op == Op::Div || stmt->op == Op::Mod) ? DIV_COST : 1) *
+					info.scale;
+			break;
+		case StmtKind::If:
+			expr_cost(stmt->value, info);
+			block_cost(stmt->body, info);
+			block_cost(stmt->else_body, info);
+			break;
+		case StmtKind::For: {
+			expr_cost(stmt->init, info);
+			uint32 trips = 0;
+			auto scale = info.scale;
+			if (GetTripCount(*info.module, stmt, MAX_COUNTED_TRIPS, trips))
+				info.scale *= trips;
+			else
+				++info.dynamic_loops;
+			expr_cost(stmt->value, info);
+			block_cost(stmt->updates, info);
+			block_cost(stmt->body, info);
+			info.scale = scale;
+		} break;
+		case StmtKind::While:
+		case StmtKind::DoWhile:
+			++info.dynamic_loops;
+			expr_cost(stmt->value, info);
+			block_cost(stmt->body, info);
+			break;
+		case StmtKind::Discard: info.discard = true; break;
+		default:
+			expr_cost(stmt->value, info);
+			break;
+		}
+	}
+}
+
+// ====================================================================================================================
+PerfStats EstimateCost(Module& module, const Function& func)
+{
+	CostInfo info{ 0, 0, 0, 0, 0, 0, 0, false, 1, &module };
+	block_cost(func.body, info);
+
+	auto clamp = [](uint64 val) -> uint32 { return (uint32)std::min<uint64>(val, UINT32_MAX); };
+	PerfStats stats{ func.stage };
+	stats.alu_cost = clamp(info.alu);
+	stats.texture_samples = clamp(info.samples);
+	stats.texture_fetches = clamp(info.fetches);
+	stats.image_loads = clamp(info.image_loads);
+	stats.image_stores = clamp(info.image_stores);
+	stats.dynamic_indexing = clamp(info.dynamic_indexing);
+	stats.dynamic_loops = clamp(info.dynamic_loops);
+	stats.uses_discard = info.discard;
+
+	// The locals that are still used after linking are the live varyings
+	SymbolSet used{ };
+	FindUsedSymbols(func.body, used);
+	uint32 bytes = 0;
+	for (auto sym : used) {
+		if (sym->scope == VarScope::Local)
+			bytes += sym->type.get_component_count() * 4u * sym->type.count;
+	}
+	stats.varying_bytes = (uint16)std::min<uint32>(bytes, UINT16_MAX);
+	return stats;
+}
+
+} // namespace ir
+} // namespace hlsv
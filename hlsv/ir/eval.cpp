@@ -0,0 +1,765 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements eval.hpp
+
+#include "eval.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#define NAN_F (std::numeric_limits<float>::quiet_NaN())
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+using Component = ConstValue::Component;
+using PrimType = HLSVType::PrimType;
+
+// The builtin functions that can be evaluated, by their GLSL name
+enum class Builtin : uint8
+{
+	None,
+	// Componentwise
+	Radians, Degrees, Sin, Cos, Tan, Asin, Acos, Atan, Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+	Pow, Exp, Log, Exp2, Log2, Sqrt, InverseSqrt,
+	Abs, Sign, Floor, Trunc, Round, RoundEven, Ceil, Fract, Mod, Min, Max, Clamp, Mix, Step, SmoothStep,
+	// Geometric
+	Length, Distance, Dot, Cross, Normalize,
+	// Relational
+	IsNan, IsInf, LessThan, LessThanEqual, GreaterThan, GreaterThanEqual, Equal, NotEqual, Any, All, Not,
+	// Matrix
+	MatrixCompMult, OuterProduct, Transpose, Determinant
+}; // enum class Builtin
+
+static const struct { const char* name; Builtin func; } BUILTIN_NAMES[] = {
+	{ "radians", Builtin::Radians }, { "degrees", Builtin::Degrees }, { "sin", Builtin::Sin }, { "cos", Builtin::Cos },
+	{ "tan", Builtin::Tan }, { "asin", Builtin::Asin }, { "acos", Builtin::Acos }, { "atan", Builtin::Atan },
+	{ "sinh", Builtin::Sinh }, { "cosh", Builtin::Cosh }, { "tanh", Builtin::Tanh }, { "asinh", Builtin::Asinh },
+	{ "acosh", Builtin::Acosh }, { "atanh", Builtin::Atanh }, { "pow", Builtin::Pow }, { "exp", Builtin::Exp },
+	{ "log", Builtin::Log }, { "exp2", Builtin::Exp2 }, { "log2", Builtin::Log2 }, { "sqrt", Builtin::Sqrt },
+	{ "inversesqrt", Builtin::InverseSqrt }, { "abs", Builtin::Abs }, { "sign", Builtin::Sign },
+	{ "floor", Builtin::Floor }, { "trunc", Builtin::Trunc }, { "round", Builtin::Round },
+	{ "roundEven", Builtin::RoundEven }, { "ceil", Builtin::Ceil }, { "fract", Builtin::Fract }, { "mod", Builtin::Mod },
+	{ "min", Builtin::Min }, { "max", Builtin::Max }, { "clamp", Builtin::Clamp }, { "mix", Builtin::Mix },
+	{ "step", Builtin::Step }, { "smoothstep", Builtin::SmoothStep }, { "length", Builtin::Length },
+	{ "distance", Builtin::Distance }, { "dot", Builtin::Dot }, { "cross", Builtin::Cross },
+	{ "normalize", Builtin::Normalize }, { "isnan", Builtin::IsNan }, { "isinf", Builtin::IsInf },
+	{ "lessThan", Builtin::LessThan }, { "lessThanEqual", Builtin::LessThanEqual },
+	{ "greaterThan", Builtin::GreaterThan }, { "greaterThanEqual", Builtin::GreaterThanEqual },
+	{ "equal", Builtin::Equal }, { "notEqual", Builtin::NotEqual }, { "any", Builtin::Any }, { "all", Builtin::All },
+	{ "not", Builtin::Not }, { "matrixCompMult", Builtin::MatrixCompMult }, { "outerProduct", Builtin::OuterProduct },
+	{ "transpose", Builtin::Transpose }, { "determinant", Builtin::Determinant }
+};
+
+// ====================================================================================================================
+static inline uint32 matrix_side(PrimType type)
+{
+	return (type == HLSVType::Mat2) ? 2u : (type == HLSVType::Mat3) ? 3u : 4u;
+}
+
+// ====================================================================================================================
+static Builtin find_builtin(const char* name)
+{
+	for (const auto& bn : BUILTIN_NAMES) {
+		if (std::strcmp(bn.name, name) == 0)
+			return bn.func;
+	}
+	return Builtin::None;
+}
+
+// ====================================================================================================================
+// Performs the implicit or explicit conversion between two scalar component types
+static bool convert_component(Component in, PrimType from, PrimType to, Component& out)
+{
+	if (from == to) {
+		out = in;
+		return true;
+	}
+
+	switch (to)
+	{
+	case HLSVType::Bool:
+		out.ui = (from == HLSVType::Float) ? ((in.f != 0.0f) ? 1u : 0u) : ((in.ui != 0u) ? 1u : 0u);
+		return true;
+	case HLSVType::Float:
+		out.f = (from == HLSVType::Int) ? (float)in.si : (float)in.ui;
+		return true;
+	case HLSVType::Int:
+		if (from == HLSVType::Float) {
+			if (!(in.f >= -2147483648.0f && in.f < 2147483648.0f))
+				return false; // Out of range conversions are undefined
+			out.si = (int32)in.f;
+		}
+		else
+			out.ui = in.ui; // Conversions between integer types preserve the bit pattern
+		return true;
+	case HLSVType::UInt:
+		if (from == HLSVType::Float) {
+			if (!(in.f >= 0.0f && in.f < 4294967296.0f))
+				return false;
+			out.ui = (uint32)in.f;
+		}
+		else
+			out.ui = in.ui;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// ====================================================================================================================
+// Converts all components of the value into the component type, keeping the same shape
+static bool convert_value(const ConstValue& in, PrimType ctype, ConstValue& out)
+{
+	auto from = in.comp_type();
+	out.type = HLSVType::IsMatrixType(in.type) ? in.type : HLSVType::MakeVectorType(ctype, in.count());
+	for (uint32 i = 0; i < in.count(); ++i) {
+		if (!convert_component(in.comps[i], from, ctype, out.comps[i]))
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+// Non-finite float values cannot be written as GLSL literals, and usually come from undefined operations
+static bool check_finite(const ConstValue& val)
+{
+	if (val.comp_type() != HLSVType::Float)
+		return true;
+	for (uint32 i = 0; i < val.count(); ++i) {
+		if (!std::isfinite(val.comps[i].f))
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+static bool eval_unary(const Expr* expr, ConstValue& val)
+{
+	if (IsIncDecOp(expr->op))
+		return false;
+	ConstValue arg;
+	if (!EvaluateConstant(expr->args[0], arg))
+		return false;
+
+	val.type = arg.type;
+	auto ct = arg.comp_type();
+	for (uint32 i = 0; i < arg.count(); ++i) {
+		auto c = arg.comps[i];
+		auto& r = val.comps[i];
+		switch (expr->op)
+		{
+		case Op::Neg:
+			if (ct == HLSVType::Float) r.f = -c.f;
+			else r.ui = 0u - c.ui; // Two's complement wrapping
+			break;
+		case Op::Pos: r = c; break;
+		case Op::Not: r.ui = c.ui ? 0u : 1u; break;
+		case Op::BitNot: r.ui = ~c.ui; break;
+		default: return false;
+		}
+	}
+	return true;
+}
+
+// ====================================================================================================================
+static bool eval_arithmetic(Op op, PrimType ct, Component a, Component b, Component& r)
+{
+	if (ct == HLSVType::Float) {
+		switch (op)
+		{
+		case Op::Add: r.f = a.f + b.f; return true;
+		case Op::Sub: r.f = a.f - b.f; return true;
+		case Op::Mul: r.f = a.f * b.f; return true;
+		case Op::Div: r.f = a.f / b.f; return true; // Division by zero is caught by the finite check
+		default: return false;
+		}
+	}
+
+	switch (op)
+	{
+	case Op::Add: r.ui = a.ui + b.ui; return true; // Integer overflow wraps in GLSL
+	case Op::Sub: r.ui = a.ui - b.ui; return true;
+	case Op::Mul: r.ui = a.ui * b.ui; return true;
+	case Op::Div:
+		if (b.ui == 0u)
+			return false;
+		if (ct == HLSVType::Int) {
+			if (a.si == INT32_MIN && b.si == -1)
+				return false;
+			r.si = a.si / b.si; // Truncates towards zero, same as GLSL
+		}
+		else
+			r.ui = a.ui / b.ui;
+		return true;
+	default: return false;
+	}
+}
+
+// ====================================================================================================================
+static bool eval_binary(const Expr* expr, ConstValue& val)
+{
+	ConstValue l, r;
+	if (!EvaluateConstant(expr->args[0], l) || !EvaluateConstant(expr->args[1], r))
+		return false;
+	auto op = expr->op;
+	val.type = expr->type.type;
+
+	switch (op)
+	{
+	case Op::Lt: case Op::Gt: case Op::Le: case Op::Ge: { // Scalar only
+		auto ct = HLSVType::GetMostPromotedType(l.type, r.type);
+		Component a, b;
+		if (!convert_component(l.comps[0], l.comp_type(), ct, a) || !convert_component(r.comps[0], r.comp_type(), ct, b))
+			return false;
+		int cmp =
+			(ct == HLSVType::Float) ? ((a.f < b.f) ? -1 : (a.f > b.f) ? 1 : 0) :
+			(ct == HLSVType::Int) ? ((a.si < b.si) ? -1 : (a.si > b.si) ? 1 : 0) :
+			((a.ui < b.ui) ? -1 : (a.ui > b.ui) ? 1 : 0);
+		bool res = (op == Op::Lt) ? (cmp < 0) : (op == Op::Gt) ? (cmp > 0) : (op == Op::Le) ? (cmp <= 0) : (cmp >= 0);
+		val.comps[0].ui = res ? 1u : 0u;
+		return true;
+	}
+	case Op::Eq: case Op::Ne: {
+		auto ct = HLSVType::GetMostPromotedType(l.type, r.type);
+		ConstValue cl, cr;
+		if (!convert_value(l, ct, cl) || !convert_value(r, ct, cr))
+			return false;
+		bool eq = true;
+		for (uint32 i = 0; i < cl.count() && eq; ++i)
+			eq = (ct == HLSVType::Float) ? (cl.comps[i].f == cr.comps[i].f) : (cl.comps[i].ui == cr.comps[i].ui);
+		val.comps[0].ui = (eq == (op == Op::Eq)) ? 1u : 0u;
+		return true;
+	}
+	case Op::LogAnd: val.comps[0].ui = (l.comps[0].ui && r.comps[0].ui) ? 1u : 0u; return true;
+	case Op::LogOr: val.comps[0].ui = (l.comps[0].ui || r.comps[0].ui) ? 1u : 0u; return true;
+	case Op::Shl: case Op::Shr: { // Scalar integers only
+		if (r.comp_type() == HLSVType::Int && r.comps[0].si < 0)
+			return false;
+		auto amt = r.comps[0].ui;
+		if (amt >= 32u)
+			return false; // Undefined shift amounts
+		if (op == Op::Shl)
+			val.comps[0].ui = l.comps[0].ui << amt;
+		else if (l.comp_type() == HLSVType::Int)
+			val.comps[0].si = l.comps[0].si >> amt; // Sign extends
+		else
+			val.comps[0].ui = l.comps[0].ui >> amt;
+		return true;
+	}
+	case Op::BitAnd: val.comps[0].ui = l.comps[0].ui & r.comps[0].ui; return true;
+	case Op::BitOr: val.comps[0].ui = l.comps[0].ui | r.comps[0].ui; return true;
+	case Op::BitXor: val.comps[0].ui = l.comps[0].ui ^ r.comps[0].ui; return true;
+	case Op::Mod: { // Scalar integers only
+		if (l.comp_type() != r.comp_type())
+			return false;
+		if (l.comp_type() == HLSVType::Int) {
+			if (l.comps[0].si < 0 || r.comps[0].si <= 0)
+				return false; // Undefined for negative operands
+			val.comps[0].si = l.comps[0].si % r.comps[0].si;
+		}
+		else {
+			if (r.comps[0].ui == 0u)
+				return false;
+			val.comps[0].ui = l.comps[0].ui % r.comps[0].ui;
+		}
+		return true;
+	}
+	default: break;
+	}
+
+	// Arithmetic, with the operands converted to the result component type
+	auto ct = HLSVType::GetComponentType(val.type);
+	ConstValue cl, cr;
+	if (!convert_value(l, ct, cl) || !convert_value(r, ct, cr))
+		return false;
+	if (op == Op::Mul && HLSVType::IsMatrixType(cl.type) && !HLSVType::IsScalarType(cr.type)) {
+		auto side = matrix_side(cl.type);
+		if (HLSVType::IsMatrixType(cr.type)) { // Linear algebra matrix product
+			for (uint32 c = 0; c < side; ++c) {
+				for (uint32 rr = 0; rr < side; ++rr) {
+					float sum = 0.0f;
+					for (uint32 k = 0; k < side; ++k)
+						sum += cl.comps[k * side + rr].f * cr.comps[c * side + k].f;
+					val.comps[c * side + rr].f = sum;
+				}
+			}
+		}
+		else { // Matrix-vector product
+			for (uint32 rr = 0; rr < side; ++rr) {
+				float sum = 0.0f;
+				for (uint32 c = 0; c < side; ++c)
+					sum += cl.comps[c * side + rr].f * cr.comps[c].f;
+				val.comps[rr].f = sum;
+			}
+		}
+		return check_finite(val);
+	}
+	for (uint32 i = 0; i < val.count(); ++i) {
+		if (!eval_arithmetic(op, ct, cl.get(i), cr.get(i), val.comps[i]))
+			return false;
+	}
+	return check_finite(val);
+}
+
+// ====================================================================================================================
+static bool eval_construct(const Expr* expr, ConstValue& val)
+{
+	if (expr->type.is_array || !expr->type.is_value_type() || expr->arg_count == 0)
+		return false;
+	ConstValue args[16];
+	if (expr->arg_count > 16)
+		return false;
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (!EvaluateConstant(expr->args[i], args[i]))
+			return false;
+	}
+
+	val.type = expr->type.type;
+	auto ct = val.comp_type();
+	auto count = val.count();
+	if (expr->arg_count == 1 && args[0].count() == 1) { // Scalar cast, vector fill, or diagonal matrix
+		Component c;
+		if (!convert_component(args[0].comps[0], args[0].comp_type(), ct, c))
+			return false;
+		if (HLSVType::IsMatrixType(val.type)) {
+			auto side = matrix_side(val.type);
+			for (uint32 i = 0; i < count; ++i)
+				val.comps[i].f = ((i / side) == (i % side)) ? c.f : 0.0f;
+		}
+		else {
+			for (uint32 i = 0; i < count; ++i)
+				val.comps[i] = c;
+		}
+		return check_finite(val);
+	}
+	if (expr->arg_count == 1 && HLSVType::IsMatrixType(val.type) && HLSVType::IsMatrixType(args[0].type)) { // Resize
+		auto side = matrix_side(val.type);
+		auto aside = matrix_side(args[0].type);
+		for (uint32 c = 0; c < side; ++c) {
+			for (uint32 r = 0; r < side; ++r) {
+				val.comps[c * side + r].f = (c < aside && r < aside) ? args[0].comps[c * aside + r].f :
+					(c == r) ? 1.0f : 0.0f;
+			}
+		}
+		return true;
+	}
+
+	// Fill the components in order from the flattened arguments
+	uint32 idx = 0;
+	for (uint32 i = 0; i < expr->arg_count && idx < count; ++i) {
+		for (uint32 j = 0; j < args[i].count() && idx < count; ++j, ++idx) {
+			if (!convert_component(args[i].comps[j], args[i].comp_type(), ct, val.comps[idx]))
+				return false;
+		}
+	}
+	return (idx == count) && check_finite(val);
+}
+
+// ====================================================================================================================
+// Evaluates a componentwise float function in double precision, returning NaN for undefined inputs
+static float eval_float_func(Builtin func, float x, float y, float z)
+{
+	static const double PI = 3.14159265358979323846;
+	double dx = x, dy = y;
+	switch (func)
+	{
+	case Builtin::Radians: return (float)(dx * (PI / 180.0));
+	case Builtin::Degrees: return (float)(dx * (180.0 / PI));
+	case Builtin::Sin: return (float)std::sin(dx);
+	case Builtin::Cos: return (float)std::cos(dx);
+	case Builtin::Tan: return (float)std::tan(dx);
+	case Builtin::Asin: return (float)std::asin(dx);
+	case Builtin::Acos: return (float)std::acos(dx);
+	case Builtin::Sinh: return (float)std::sinh(dx);
+	case Builtin::Cosh: return (float)std::cosh(dx);
+	case Builtin::Tanh: return (float)std::tanh(dx);
+	case Builtin::Asinh: return (float)std::asinh(dx);
+	case Builtin::Acosh: return (dx < 1.0) ? NAN_F : (float)std::acosh(dx);
+	case Builtin::Atanh: return (std::fabs(dx) >= 1.0) ? NAN_F : (float)std::atanh(dx);
+	case Builtin::Pow: return (dx < 0.0 || (dx == 0.0 && dy <= 0.0)) ? NAN_F : (float)std::pow(dx, dy);
+	case Builtin::Exp: return (float)std::exp(dx);
+	case Builtin::Log: return (dx <= 0.0) ? NAN_F : (float)std::log(dx);
+	case Builtin::Exp2: return (float)std::exp2(dx);
+	case Builtin::Log2: return (dx <= 0.0) ? NAN_F : (float)std::log2(dx);
+	case Builtin::Sqrt: return (dx < 0.0) ? NAN_F : (float)std::sqrt(dx);
+	case Builtin::InverseSqrt: return (dx <= 0.0) ? NAN_F : (float)(1.0 / std::sqrt(dx));
+	case Builtin::Abs: return std::fabs(x);
+	case Builtin::Sign: return (x > 0.0f) ? 1.0f : (x < 0.0f) ? -1.0f : 0.0f;
+	case Builtin::Floor: return std::floor(x);
+	case Builtin::Trunc: return std::trunc(x);
+	case Builtin::Round: // The direction of rounding for exact halves is implementation-defined
+		return (std::fabs(x - std::trunc(x)) == 0.5f) ? NAN_F : std::round(x);
+	case Builtin::RoundEven: return std::nearbyint(x); // Default rounding mode is round-to-nearest-even
+	case Builtin::Ceil: return std::ceil(x);
+	case Builtin::Fract: return x - std::floor(x);
+	case Builtin::Mod: return (y == 0.0f) ? NAN_F : (x - y * std::floor(x / y));
+	case Builtin::Min: return (y < x) ? y : x;
+	case Builtin::Max: return (x < y) ? y : x;
+	case Builtin::Step: return (y < x) ? 0.0f : 1.0f; // step(edge = x, y)
+	case Builtin::Mix: return x * (1.0f - z) + y * z;
+	case Builtin::Clamp: return (y > z) ? NAN_F : std::fmin(std::fmax(x, y), z);
+	case Builtin::SmoothStep: {
+		if (x >= y)
+			return NAN_F;
+		float t = std::fmin(std::fmax((z - x) / (y - x), 0.0f), 1.0f);
+		return t * t * (3.0f - 2.0f * t);
+	}
+	default: return NAN_F;
+	}
+}
+
+// ====================================================================================================================
+static bool eval_builtin(const Expr* expr, ConstValue& val)
+{
+	if (expr->arg_count == 0 || expr->arg_count > 3 || expr->type.is_array || !expr->type.is_value_type())
+		return false;
+	auto func = find_builtin(expr->out_name);
+	if (func == Builtin::None)
+		return false;
+	ConstValue args[3];
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (!EvaluateConstant(expr->args[i], args[i]))
+			return false;
+	}
+
+	val.type = expr->type.type;
+	auto count = val.count();
+	auto ct = val.comp_type();
+	switch (func)
+	{
+	case Builtin::Abs: case Builtin::Sign: case Builtin::Min: case Builtin::Max: case Builtin::Clamp:
+		if (ct != HLSVType::Float) { // Integer versions
+			ConstValue cargs[3];
+			for (uint32 i = 0; i < expr->arg_count; ++i) {
+				if (!convert_value(args[i], ct, cargs[i]))
+					return false;
+			}
+			auto less = [ct](Component a, Component b) { return (ct == HLSVType::Int) ? (a.si < b.si) : (a.ui < b.ui); };
+			for (uint32 i = 0; i < count; ++i) {
+				auto x = cargs[0].get(i);
+				auto& r = val.comps[i];
+				if (func == Builtin::Abs) {
+					if (x.si == INT32_MIN)
+						return false;
+					r.si = (x.si < 0) ? -x.si : x.si;
+				}
+				else if (func == Builtin::Sign)
+					r.si = (x.si > 0) ? 1 : (x.si < 0) ? -1 : 0;
+				else if (func == Builtin::Min)
+					r = less(cargs[1].get(i), x) ? cargs[1].get(i) : x;
+				else if (func == Builtin::Max)
+					r = less(x, cargs[1].get(i)) ? cargs[1].get(i) : x;
+				else {
+					auto lo = cargs[1].get(i), hi = cargs[2].get(i);
+					if (less(hi, lo))
+						return false;
+					r = less(x, lo) ? lo : less(hi, x) ? hi : x;
+				}
+			}
+			return true;
+		}
+		break;
+	case Builtin::Mix:
+		if (args[2].comp_type() == HLSVType::Bool) { // Component selection
+			ConstValue cx, cy;
+			if (!convert_value(args[0], ct, cx) || !convert_value(args[1], ct, cy))
+				return false;
+			for (uint32 i = 0; i < count; ++i)
+				val.comps[i] = args[2].get(i).ui ? cy.get(i) : cx.get(i);
+			return true;
+		}
+		break;
+	case Builtin::Length: case Builtin::Distance: case Builtin::Dot: case Builtin::Normalize: {
+		ConstValue x, y;
+		if (!convert_value(args[0], HLSVType::Float, x))
+			return false;
+		if (expr->arg_count > 1 && !convert_value(args[1], HLSVType::Float, y))
+			return false;
+		double sum = 0.0;
+		for (uint32 i = 0; i < x.count(); ++i) {
+			double c = (func == Builtin::Distance) ? ((double)x.comps[i].f - y.comps[i].f) :
+				(func == Builtin::Dot) ? ((double)x.comps[i].f * y.comps[i].f) : x.comps[i].f;
+			sum += (func == Builtin::Dot) ? c : (c * c);
+		}
+		if (func == Builtin::Normalize) {
+			if (sum == 0.0)
+				return false;
+			double len = std::sqrt(sum);
+			for (uint32 i = 0; i < count; ++i)
+				val.comps[i].f = (float)(x.comps[i].f / len);
+		}
+		else
+			val.comps[0].f = (float)((func == Builtin::Dot) ? sum : std::sqrt(sum));
+		return check_finite(val);
+	}
+	case Builtin::Cross: {
+		ConstValue x, y;
+		if (!convert_value(args[0], HLSVType::Float, x) || !convert_value(args[1], HLSVType::Float, y))
+			return false;
+		val.comps[0].f = x.comps[1].f * y.comps[2].f - y.comps[1].f * x.comps[2].f;
+		val.comps[1].f = x.comps[2].f * y.comps[0].f - y.comps[2].f * x.comps[0].f;
+		val.comps[2].f = x.comps[0].f * y.comps[1].f - y.comps[0].f * x.comps[1].f;
+		return check_finite(val);
+	}
+	case Builtin::IsNan: case Builtin::IsInf: // Constant values are always finite
+		for (uint32 i = 0; i < count; ++i)
+			val.comps[i].ui = 0u;
+		return true;
+	case Builtin::LessThan: case Builtin::LessThanEqual: case Builtin::GreaterThan: case Builtin::GreaterThanEqual:
+	case Builtin::Equal: case Builtin::NotEqual: {
+		auto act = HLSVType::GetMostPromotedType(args[0].type, args[1].type);
+		ConstValue x, y;
+		if (!convert_value(args[0], act, x) || !convert_value(args[1], act, y))
+			return false;
+		for (uint32 i = 0; i < count; ++i) {
+			auto a = x.comps[i], b = y.comps[i];
+			int cmp =
+				(act == HLSVType::Float) ? ((a.f < b.f) ? -1 : (a.f > b.f) ? 1 : 0) :
+				(act == HLSVType::Int) ? ((a.si < b.si) ? -1 : (a.si > b.si) ? 1 : 0) :
+				((a.ui < b.ui) ? -1 : (a.ui > b.ui) ? 1 : 0);
+			bool res =
+				(func == Builtin::LessThan) ? (cmp < 0) : (func == Builtin::LessThanEqual) ? (cmp <= 0) :
+				(func == Builtin::GreaterThan) ? (cmp > 0) : (func == Builtin::GreaterThanEqual) ? (cmp >= 0) :
+				(func == Builtin::Equal) ? (cmp == 0) : (cmp != 0);
+			val.comps[i].ui = res ? 1u : 0u;
+		}
+		return true;
+	}
+	case Builtin::Any: case Builtin::All: {
+		bool res = (func == Builtin::All);
+		for (uint32 i = 0; i < args[0].count(); ++i) {
+			if (func == Builtin::Any) res = res || args[0].comps[i].ui;
+			else res = res && args[0].comps[i].ui;
+		}
+		val.comps[0].ui = res ? 1u : 0u;
+		return true;
+	}
+	case Builtin::Not:
+		for (uint32 i = 0; i < count; ++i)
+			val.comps[i].ui = args[0].comps[i].ui ? 0u : 1u;
+		return true;
+	case Builtin::MatrixCompMult:
+		for (uint32 i = 0; i < count; ++i)
+			val.comps[i].f = args[0].comps[i].f * args[1].comps[i].f;
+		return check_finite(val);
+	case Builtin::OuterProduct: {
+		auto side = matrix_side(val.type);
+		ConstValue x, y;
+		if (!convert_value(args[0], HLSVType::Float, x) || !convert_value(args[1], HLSVType::Float, y))
+			return false;
+		for (uint32 c = 0; c < side; ++c) {
+			for (uint32 r = 0; r < side; ++r)
+				val.comps[c * side + r].f = x.comps[r].f * y.comps[c].f;
+		}
+		return check_finite(val);
+	}
+	case Builtin::Transpose: {
+		auto side = matrix_side(val.type);
+		for (uint32 c = 0; c < side; ++c) {
+			for (uint32 r = 0; r < side; ++r)
+				val.comps[c * side + r] = args[0].comps[r * side + c];
+		}
+		return true;
+	}
+	case Builtin::Determinant: {
+		const auto& m = args[0].comps;
+		if (args[0].type == HLSVType::Mat2)
+			val.comps[0].f = (float)((double)m[0].f * m[3].f - (double)m[2].f * m[1].f);
+		else if (args[0].type == HLSVType::Mat3) {
+			val.comps[0].f = (float)(
+				(double)m[0].f * ((double)m[4].f * m[8].f - (double)m[7].f * m[5].f) -
+				(double)m[3].f * ((double)m[1].f * m[8].f - (double)m[7].f * m[2].f) +
+				(double)m[6].f * ((double)m[1].f * m[5].f - (double)m[4].f * m[2].f));
+		}
+		else
+			return false;
+		return check_finite(val);
+	}
+	default: break;
+	}
+
+	// Remaining functions are componentwise over floats
+	if (ct != HLSVType::Float)
+		return false;
+	ConstValue fargs[3];
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (!convert_value(args[i], HLSVType::Float, fargs[i]))
+			return false;
+	}
+	if (func == Builtin::Atan && expr->arg_count == 2) {
+		for (uint32 i = 0; i < count; ++i) {
+			auto y = fargs[0].get(i).f, x = fargs[1].get(i).f;
+			if (x == 0.0f && y == 0.0f)
+				return false; // Undefined
+			val.comps[i].f = (float)std::atan2((double)y, (double)x);
+		}
+		return check_finite(val);
+	}
+	if (func == Builtin::Atan) {
+		for (uint32 i = 0; i < count; ++i)
+			val.comps[i].f = (float)std::atan((double)fargs[0].get(i).f);
+		return check_finite(val);
+	}
+	for (uint32 i = 0; i < count; ++i) {
+		auto x = fargs[0].get(i).f;
+		auto y = (expr->arg_count > 1) ? fargs[1].get(i).f : 0.0f;
+		auto z = (expr->arg_count > 2) ? fargs[2].get(i).f : 0.0f;
+		val.comps[i].f = eval_float_func(func, x, y, z);
+	}
+	return check_finite(val);
+}
+
+// ====================================================================================================================
+bool EvaluateConstant(const Expr* expr, ConstValue& val)
+{
+	if (!expr || expr->type.is_array || !expr->type.is_value_type())
+		return false;
+
+	switch (expr->kind)
+	{
+	case ExprKind::Literal:
+		val.type = expr->type.type;
+		val.comps[0].ui = expr->value.ui;
+		return true;
+	case ExprKind::Variable: { // Only known for unmodified constant values, converted to the variable type
+		if (!expr->symbol->value || expr->symbol->type.is_array)
+			return false;
+		ConstValue inner;
+		if (!EvaluateConstant(expr->symbol->value, inner))
+			return false;
+		return convert_value(inner, expr->symbol->type.get_component_type(), val) && (val.type == expr->symbol->type.type);
+	}
+	case ExprKind::Unary: return eval_unary(expr, val);
+	case ExprKind::Binary: return eval_binary(expr, val);
+	case ExprKind::Ternary: {
+		ConstValue cond;
+		if (!EvaluateConstant(expr->args[0], cond))
+			return false;
+		return EvaluateConstant(expr->args[cond.comps[0].ui ? 1 : 2], val);
+	}
+	case ExprKind::Index: {
+		ConstValue base, idx;
+		if (!EvaluateConstant(expr->args[0], base) || !EvaluateConstant(expr->args[1], idx))
+			return false;
+		if (idx.comp_type() == HLSVType::Int && idx.comps[0].si < 0)
+			return false;
+		auto n = idx.comps[0].ui;
+		if (HLSVType::IsMatrixType(base.type)) {
+			auto side = matrix_side(base.type);
+			if (n >= side)
+				return false;
+			val.type = HLSVType::MakeVectorType(HLSVType::Float, (uint8)side);
+			for (uint32 r = 0; r < side; ++r)
+				val.comps[r] = base.comps[n * side + r];
+		}
+		else {
+			if (n >= base.count())
+				return false;
+			val.type = base.comp_type();
+			val.comps[0] = base.comps[n];
+		}
+		return true;
+	}
+	case ExprKind::Swizzle: {
+		ConstValue base;
+		if (!EvaluateConstant(expr->args[0], base))
+			return false;
+		val.type = expr->type.type;
+		for (uint8 i = 0; i < expr->swizzle_count; ++i)
+			val.comps[i] = base.comps[expr->swizzle[i]];
+		return true;
+	}
+	case ExprKind::Construct: return eval_construct(expr, val);
+	case ExprKind::Call: return eval_builtin(expr, val);
+	default: return false;
+	}
+}
+
+// ====================================================================================================================
+static Expr* make_literal(Module& module, PrimType ct, Component c, uint32 line)
+{
+	switch (ct)
+	{
+	case HLSVType::Bool: return module.new_literal(c.ui != 0u, line);
+	case HLSVType::Float: return module.new_literal(c.f, line);
+	case HLSVType::Int: return module.new_literal(c.si, line);
+	default: return module.new_literal(c.ui, line);
+	}
+}
+
+// ====================================================================================================================
+Expr* MakeConstantExpr(Module& module, const ConstValue& val, uint32 line)
+{
+	auto ct = val.comp_type();
+	auto count = val.count();
+	if (count == 1)
+		return make_literal(module, ct, val.comps[0], line);
+
+	// Check for the compact forms (vector fill and diagonal matrix)
+	bool compact = true;
+	if (HLSVType::IsMatrixType(val.type)) {
+		auto side = matrix_side(val.type);
+		for (uint32 i = 0; i < count && compact; ++i) {
+			bool diag = (i / side) == (i % side);
+			compact = diag ? (val.comps[i].ui == val.comps[0].ui) : (val.comps[i].f == 0.0f);
+		}
+	}
+	else {
+		for (uint32 i = 1; i < count && compact; ++i)
+			compact = (val.comps[i].ui == val.comps[0].ui);
+	}
+
+	std::vector<Expr*> args{};
+	for (uint32 i = 0; i < (compact ? 1u : count); ++i)
+		args.push_back(make_literal(module, ct, val.comps[i], line));
+	return module.new_construct(val.type, args, line);
+}
+
+// ====================================================================================================================
+bool IsConstantForm(const Expr* expr)
+{
+	if (expr->kind == ExprKind::Literal)
+		return true;
+	if (expr->kind != ExprKind::Construct || expr->type.is_array)
+		return false;
+	if (expr->arg_count != 1 && expr->arg_count != expr->type.get_component_count())
+		return false;
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (expr->args[i]->kind != ExprKind::Literal)
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+bool HasSideEffects(const Expr* expr)
+{
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		return true;
+	if (expr->kind == ExprKind::Call && expr->type == HLSVType::Void) // Image stores
+		return true;
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (HasSideEffects(expr->args[i]))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+bool IsEvaluableBuiltin(const char* out_name)
+{
+	return find_builtin(out_name) != Builtin::None;
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,53 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the compile-time evaluation of constant IR expressions, which follows the GLSL rules for
+//    conversions, rounding, and operator semantics
+
+#pragma once
+
+#include "ir.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// A compile-time constant value of a non-array value type, matrix components are stored in column-major order
+struct ConstValue final
+{
+	union Component
+	{
+		float f;
+		int32 si;
+		uint32 ui; // Also used for boolean values (0 or 1)
+	};
+
+	HLSVType::PrimType type;
+	Component comps[16];
+
+	inline uint8 count() const { return HLSVType::GetComponentCount(type); }
+	inline HLSVType::PrimType comp_type() const { return HLSVType::GetComponentType(type); }
+	inline Component get(uint32 i) const { return comps[(count() == 1) ? 0 : i]; } // Broadcasts scalar values
+}; // struct ConstValue
+
+// Attempts to evaluate the expression at compile time, returns false if the value cannot be known, or if the result
+//    is undefined or implementation-defined in GLSL (such as division by zero, or non-finite float results)
+bool EvaluateConstant(const Expr* expr, ConstValue& val);
+// Creates the most compact literal or constant constructor expression that represents the value
+Expr* MakeConstantExpr(Module& module, const ConstValue& val, uint32 line);
+// Gets if the expression is already in the form created by MakeConstantExpr()
+bool IsConstantForm(const Expr* expr);
+// Gets if evaluating the expression can modify any variables or image memory
+bool HasSideEffects(const Expr* expr);
+// Gets if calls to the builtin function with the generated name can be evaluated by EvaluateConstant()
+bool IsEvaluableBuiltin(const char* out_name);
+
+} // namespace ir
+} // namespace hlsv
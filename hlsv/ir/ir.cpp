@@ -0,0 +1,376 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements ir.hpp
+
+#include "ir.hpp"
+#include <algorithm>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+void Block::append(Stmt* stmt)
+{
+	stmt->prev = last;
+	stmt->next = nullptr;
+	if (last)
+		last->next = stmt;
+	else
+		first = stmt;
+	last = stmt;
+}
+
+// ====================================================================================================================
+void Block::insert_before(Stmt* pos, Stmt* stmt)
+{
+	if (!pos) {
+		append(stmt);
+		return;
+	}
+	stmt->prev = pos->prev;
+	stmt->next = pos;
+	if (pos->prev)
+		pos->prev->next = stmt;
+	else
+		first = stmt;
+	pos->prev = stmt;
+}
+
+// ====================================================================================================================
+void Block::remove(Stmt* stmt)
+{
+	if (stmt->prev)
+		stmt->prev->next = stmt->next;
+	else
+		first = stmt->next;
+	if (stmt->next)
+		stmt->next->prev = stmt->prev;
+	else
+		last = stmt->prev;
+	stmt->prev = stmt->next = nullptr;
+}
+
+// ====================================================================================================================
+void Block::splice_before(Stmt* pos, Block& other)
+{
+	while (other.first) {
+		auto stmt = other.first;
+		other.remove(stmt);
+		insert_before(pos, stmt);
+	}
+}
+
+// ====================================================================================================================
+Module::Module() :
+	arena_{ },
+	next_id_{ 0 },
+	functions_{ }
+{
+
+}
+
+// ====================================================================================================================
+Module::~Module()
+{
+
+}
+
+// ====================================================================================================================
+Symbol* Module::new_symbol(const string& name, HLSVType type, VarScope scope, bool flat)
+{
+	auto sym = arena_.make<Symbol>();
+	sym->name = arena_.copy_str(name);
+	sym->type = type;
+	sym->scope = scope;
+	sym->is_flat = flat;
+	sym->id = next_id_++;
+	sym->value = nullptr;
+	return sym;
+}
+
+// ====================================================================================================================
+Function* Module::new_function(ShaderStages stage)
+{
+	auto func = arena_.make<Function>();
+	func->stage = stage;
+	func->body = { nullptr, nullptr };
+	functions_.push_back(func);
+	return func;
+}
+
+// ====================================================================================================================
+void Module::add_function(Function* func)
+{
+	functions_.push_back(func);
+}
+
+// ====================================================================================================================
+Function* Module::new_user_function(const string& name, HLSVType type, const std::vector<Symbol*>& params)
+{
+	auto func = arena_.make<Function>(); // Value-initialized (zeroed)
+	func->stage = ShaderStages::None;
+	func->name = arena_.copy_str(name);
+	func->return_type = type;
+	func->params = arena_.make_array<Symbol*>(params.size());
+	std::copy(params.begin(), params.end(), func->params);
+	func->param_count = (uint32)params.size();
+	return func;
+}
+
+// ====================================================================================================================
+Expr* Module::new_expr(ExprKind kind, HLSVType type, uint32 line)
+{
+	auto expr = arena_.make<Expr>(); // Value-initialized (zeroed)
+	expr->kind = kind;
+	expr->op = Op::None;
+	expr->type = type;
+	expr->line = line;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr** Module::new_args(const std::vector<Expr*>& args)
+{
+	auto arr = arena_.make_array<Expr*>(args.size());
+	for (size_t i = 0; i < args.size(); ++i)
+		arr[i] = args[i];
+	return arr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_literal(bool b, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Literal, HLSVType::Bool, line);
+	expr->is_constant = true;
+	expr->value.ui = b ? 1u : 0u;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_literal(float f, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Literal, HLSVType::Float, line);
+	expr->is_constant = true;
+	expr->value.f = f;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_literal(int32 i, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Literal, HLSVType::Int, line);
+	expr->is_constant = true;
+	expr->value.si = i;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_literal(uint32 u, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Literal, HLSVType::UInt, line);
+	expr->is_constant = true;
+	expr->value.ui = u;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_variable(Symbol* sym, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Variable, sym->type, line);
+	expr->symbol = sym;
+	expr->is_constant = (sym->scope == VarScope::Constant);
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_unary(Op op, Expr* val, HLSVType type, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Unary, type, line);
+	expr->op = op;
+	expr->args = new_args({ val });
+	expr->arg_count = 1;
+	expr->is_constant = val->is_constant && !IsIncDecOp(op);
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_binary(Op op, Expr* left, Expr* right, HLSVType type, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Binary, type, line);
+	expr->op = op;
+	expr->args = new_args({ left, right });
+	expr->arg_count = 2;
+	expr->is_constant = left->is_constant && right->is_constant;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_ternary(Expr* cond, Expr* texpr, Expr* fexpr, HLSVType type, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Ternary, type, line);
+	expr->args = new_args({ cond, texpr, fexpr });
+	expr->arg_count = 3;
+	expr->is_constant = cond->is_constant && texpr->is_constant && fexpr->is_constant;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_index(Expr* val, Expr* index, HLSVType type, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Index, type, line);
+	expr->args = new_args({ val, index });
+	expr->arg_count = 2;
+	expr->is_constant = val->is_constant && index->is_constant;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_swizzle(Expr* val, const uint8* comps, uint8 count, HLSVType type, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Swizzle, type, line);
+	expr->args = new_args({ val });
+	expr->arg_count = 1;
+	for (uint8 i = 0; i < count; ++i)
+		expr->swizzle[i] = comps[i];
+	expr->swizzle_count = count;
+	expr->is_constant = val->is_constant;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_construct(HLSVType type, const std::vector<Expr*>& args, uint32 line)
+{
+	auto expr = new_expr(ExprKind::Construct, type, line);
+	expr->args = new_args(args);
+	expr->arg_count = (uint32)args.size();
+	expr->is_constant = true;
+	for (auto arg : args)
+		expr->is_constant = expr->is_constant && arg->is_constant;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_init_list(HLSVType type, const std::vector<Expr*>& args, uint32 line)
+{
+	auto expr = new_construct(type, args, line);
+	expr->kind = ExprKind::InitList;
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* Module::new_call(const string& name, const string& out_name, HLSVType type, const std::vector<Expr*>& args,
+	uint32 line)
+{
+	auto expr = new_expr(ExprKind::Call, type, line);
+	expr->name = arena_.copy_str(name);
+	expr->out_name = arena_.copy_str(out_name);
+	expr->args = new_args(args);
+	expr->arg_count = (uint32)args.size();
+	return expr;
+}
+
+// ====================================================================================================================
+Stmt* Module::new_stmt(StmtKind kind, uint32 line)
+{
+	auto stmt = arena_.make<Stmt>(); // Value-initialized (zeroed)
+	stmt->kind = kind;
+	stmt->op = Op::None;
+	stmt->line = line;
+	return stmt;
+}
+
+// ====================================================================================================================
+Op ParseBinaryOp(const string& str)
+{
+	// Strip the trailing '=' from compound assignments, but not from the comparison operators
+	string op = str;
+	if (op.length() >= 2 && op.back() == '=' && op != "==" && op != "!=" && op != "<=" && op != ">=")
+		op.pop_back();
+
+	if (op == "+") return Op::Add;
+	if (op == "-") return Op::Sub;
+	if (op == "*") return Op::Mul;
+	if (op == "/") return Op::Div;
+	if (op == "%") return Op::Mod;
+	if (op == "<<") return Op::Shl;
+	if (op == ">>") return Op::Shr;
+	if (op == "<") return Op::Lt;
+	if (op == ">") return Op::Gt;
+	if (op == "<=") return Op::Le;
+	if (op == ">=") return Op::Ge;
+	if (op == "==") return Op::Eq;
+	if (op == "!=") return Op::Ne;
+	if (op == "&") return Op::BitAnd;
+	if (op == "|") return Op::BitOr;
+	if (op == "^") return Op::BitXor;
+	if (op == "&&") return Op::LogAnd;
+	if (op == "||") return Op::LogOr;
+	return Op::None;
+}
+
+// ====================================================================================================================
+Op ParseUnaryOp(const string& str, bool postfix)
+{
+	if (str == "++") return postfix ? Op::PostInc : Op::PreInc;
+	if (str == "--") return postfix ? Op::PostDec : Op::PreDec;
+	if (str == "-") return Op::Neg;
+	if (str == "+") return Op::Pos;
+	if (str == "!") return Op::Not;
+	if (str == "~") return Op::BitNot;
+	return Op::None;
+}
+
+// ====================================================================================================================
+const char* GetOpStr(Op op)
+{
+	switch (op)
+	{
+	case Op::Add: return "+";
+	case Op::Sub: return "-";
+	case Op::Mul: return "*";
+	case Op::Div: return "/";
+	case Op::Mod: return "%";
+	case Op::Shl: return "<<";
+	case Op::Shr: return ">>";
+	case Op::Lt: return "<";
+	case Op::Gt: return ">";
+	case Op::Le: return "<=";
+	case Op::Ge: return ">=";
+	case Op::Eq: return "==";
+	case Op::Ne: return "!=";
+	case Op::BitAnd: return "&";
+	case Op::BitOr: return "|";
+	case Op::BitXor: return "^";
+	case Op::LogAnd: return "&&";
+	case Op::LogOr: return "||";
+	case Op::Neg: return "-";
+	case Op::Pos: return "+";
+	case Op::Not: return "!";
+	case Op::BitNot: return "~";
+	case Op::PreInc: return "++";
+	case Op::PreDec: return "--";
+	case Op::PostInc: return "++";
+	case Op::PostDec: return "--";
+	default: return "";
+	}
+}
+
+// ====================================================================================================================
+Symbol* GetBaseSymbol(const Expr* lval)
+{
+	while (lval->kind == ExprKind::Index || lval->kind == ExprKind::Swizzle)
+		lval = lval->args[0];
+	return (lval->kind == ExprKind::Variable) ? lval->symbol : nullptr;
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,240 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the typed intermediate representation (IR) that is produced by the visitor, and consumed by the
+//    code generators. It is a tree of typed expressions and a linked list of statements for each shader stage.
+
+#pragma once
+
+#include "../config.hpp"
+#include "../type/variable.hpp"
+#include "arena.hpp"
+#include <vector>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The unary and binary operators
+enum class Op : uint8
+{
+	None = 0,
+	// Binary
+	Add, Sub, Mul, Div, Mod,
+	Shl, Shr,
+	Lt, Gt, Le, Ge, Eq, Ne,
+	BitAnd, BitOr, BitXor,
+	LogAnd, LogOr,
+	// Unary
+	Neg, Pos, Not, BitNot,
+	PreInc, PreDec, PostInc, PostDec
+}; // enum class Op
+
+// A variable that is referenced by the IR, each declaration gets a unique symbol
+struct Symbol final
+{
+	const char* name; // The output name of the variable
+	HLSVType type;
+	VarScope scope;
+	bool is_flat;     // If the variable is a flat local
+	uint32 id;        // Unique id within the module that created the symbol
+	const struct Expr* value; // The known constant value, for constants and locals that are never modified
+};
+
+// The different expression node types
+enum class ExprKind : uint8
+{
+	Literal,   // Scalar literal value
+	Variable,  // Variable reference
+	Unary,     // Unary operator (args[0])
+	Binary,    // Binary operator (args[0] op args[1])
+	Ternary,   // Selection (args[0] ? args[1] : args[2])
+	Index,     // Array, vector, or matrix indexing (args[0][args[1]])
+	Swizzle,   // Vector swizzle (args[0].swizzle)
+	Construct, // Type construction or cast (type(args...))
+	InitList,  // Array initializer list (type[](args...))
+	Call       // Builtin function call (name(args...))
+}; // enum class ExprKind
+
+struct Function;
+
+// A single typed expression node
+struct Expr final
+{
+	ExprKind kind;
+	Op op;
+	bool is_constant;      // If the expression is a compile-time constant (literal or constant reference)
+	HLSVType type;
+	uint32 line;           // The source line that the expression appeared on
+	union
+	{
+		float f;
+		int32 si;
+		uint32 ui;         // Also used for boolean values
+	} value;               // The literal value, if the expression is a literal
+	Symbol* symbol;        // The referenced variable, if a variable
+	const char* name;      // The HLSV name of the called function
+	const char* out_name;  // The generated name of the called function
+	Function* func;        // The called user function, or nullptr for builtin functions
+	uint8 swizzle[4];      // The swizzle component indices (0-3)
+	uint8 swizzle_count;
+	Expr** args;
+	uint32 arg_count;
+
+	inline bool is_literal() const { return kind == ExprKind::Literal; }
+	inline bool is_variable() const { return kind == ExprKind::Variable; }
+}; // struct Expr
+
+// The different statement node types
+enum class StmtKind : uint8
+{
+	Declare,  // Variable declaration with optional initializer (symbol = value)
+	Assign,   // Assignment (target op= value), op is None for simple assignment
+	Eval,     // Expression evaluated for its side effects (value)
+	If,       // Conditional (if (value) body else else_body)
+	While,    // While loop (while (value) body)
+	DoWhile,  // Do-while loop (do body while (value))
+	For,      // For loop (for (symbol = init; value; updates) body)
+	Break,
+	Continue,
+	Discard,
+	Return    // User function return (return value)
+}; // enum class StmtKind
+
+// The unrolling hint attached to a loop, emitted as the GL_EXT_control_flow_attributes attributes
+enum class LoopHint : uint8
+{
+	None,
+	Unroll,    // [[unroll]]
+	DontUnroll // [[loop]], emitted as [[dont_unroll]]
+}; // enum class LoopHint
+
+// The flattening hint attached to an if statement (and its elif chain), also emitted as control flow attributes
+enum class BranchHint : uint8
+{
+	None,
+	Flatten, // [[flatten]], always converted to selects when possible
+	Branch   // [[branch]], never converted to selects, emitted as [[dont_flatten]]
+}; // enum class BranchHint
+
+struct Stmt;
+
+// An ordered list of statements
+struct Block final
+{
+	Stmt* first;
+	Stmt* last;
+
+	inline bool empty() const { return first == nullptr; }
+	void append(Stmt* stmt);
+	void insert_before(Stmt* pos, Stmt* stmt);
+	void remove(Stmt* stmt);
+	void splice_before(Stmt* pos, Block& other); // Moves all statements from other into this block, before pos
+}; // struct Block
+
+// A single statement node
+struct Stmt final
+{
+	StmtKind kind;
+	Op op;            // The compound operator for assignments
+	bool is_elif;     // If the statement is an if statement that is the only statement of another else block
+	LoopHint hint;    // The unrolling hint for loops
+	BranchHint branch_hint; // The flattening hint for if statements
+	uint32 line;      // The source line that the statement appeared on
+	Symbol* symbol;   // The declared variable, or the for loop counter
+	Expr* target;     // The assignment lvalue
+	Expr* value;      // The initializer, assigned value, evaluated expression, or condition
+	Expr* init;       // The for loop counter initial value
+	Block updates;    // The for loop update statements
+	Block body;
+	Block else_body;
+	Stmt* prev;
+	Stmt* next;
+}; // struct Stmt
+
+// The inlining hint attached to a user function
+enum class InlineHint : uint8
+{
+	None,
+	Inline,  // [[inline]], always inlined when possible
+	NoInline // [[noinline]], never inlined
+}; // enum class InlineHint
+
+// The IR for a single shader stage function, or a user function
+struct Function final
+{
+	ShaderStages stage; // The stage of stage functions, or the stages that call user functions (after linking)
+	Block body;
+	// User functions only
+	const char* name;   // The generated name, nullptr for stage functions
+	HLSVType return_type;
+	Symbol** params;
+	uint32 param_count;
+	InlineHint hint;
+
+	inline bool is_user() const { return name != nullptr; }
+}; // struct Function
+
+// Owns and creates all IR objects for a set of shader stages
+class Module final
+{
+	_DECLARE_NOCOPY(Module)
+	_DECLARE_NOMOVE(Module)
+
+private:
+	Arena arena_;
+	uint32 next_id_;
+	std::vector<Function*> functions_;
+
+public:
+	Module();
+	~Module();
+
+	inline Arena& arena() { return arena_; }
+	inline const std::vector<Function*>& functions() const { return functions_; }
+
+	Symbol* new_symbol(const string& name, HLSVType type, VarScope scope, bool flat = false);
+	Function* new_function(ShaderStages stage);
+	void add_function(Function* func); // Adds a function created by another module
+	// User functions are not added to functions(), as they are only reachable through calls
+	Function* new_user_function(const string& name, HLSVType type, const std::vector<Symbol*>& params);
+
+	Expr* new_literal(bool b, uint32 line);
+	Expr* new_literal(float f, uint32 line);
+	Expr* new_literal(int32 i, uint32 line);
+	Expr* new_literal(uint32 u, uint32 line);
+	Expr* new_variable(Symbol* sym, uint32 line);
+	Expr* new_unary(Op op, Expr* val, HLSVType type, uint32 line);
+	Expr* new_binary(Op op, Expr* left, Expr* right, HLSVType type, uint32 line);
+	Expr* new_ternary(Expr* cond, Expr* texpr, Expr* fexpr, HLSVType type, uint32 line);
+	Expr* new_index(Expr* val, Expr* index, HLSVType type, uint32 line);
+	Expr* new_swizzle(Expr* val, const uint8* comps, uint8 count, HLSVType type, uint32 line);
+	Expr* new_construct(HLSVType type, const std::vector<Expr*>& args, uint32 line);
+	Expr* new_init_list(HLSVType type, const std::vector<Expr*>& args, uint32 line);
+	Expr* new_call(const string& name, const string& out_name, HLSVType type, const std::vector<Expr*>& args, uint32 line);
+	Stmt* new_stmt(StmtKind kind, uint32 line);
+
+private:
+	Expr* new_expr(ExprKind kind, HLSVType type, uint32 line);
+	Expr** new_args(const std::vector<Expr*>& args);
+}; // class Module
+
+// Op utilities
+Op ParseBinaryOp(const string& str);       // Parses binary operators and the compound assignment operators
+Op ParseUnaryOp(const string& str, bool postfix);
+const char* GetOpStr(Op op);
+inline bool IsBinaryOp(Op op) { return op >= Op::Add && op <= Op::LogOr; }
+inline bool IsIncDecOp(Op op) { return op >= Op::PreInc; }
+
+// Gets the variable that is modified when assigning to the lvalue expression
+Symbol* GetBaseSymbol(const Expr* lval);
+
+} // namespace ir
+} // namespace hlsv
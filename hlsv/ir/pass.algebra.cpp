@@ -0,0 +1,135 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the matrix algebra pass, which reorders matrix products and removes redundant matrix functions
+
+#include "passes.hpp"
+#include <cstring>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+static inline bool is_call(const Expr* expr, const char* out_name)
+{
+	return expr->kind == ExprKind::Call && expr->arg_count == 1 && std::strcmp(expr->out_name, out_name) == 0;
+}
+
+// ====================================================================================================================
+static inline bool is_matrix_product(const Expr* expr)
+{
+	return expr->kind == ExprKind::Binary && expr->op == Op::Mul && expr->args[0]->type.is_matrix_type() &&
+		expr->args[1]->type.is_matrix_type();
+}
+
+// ====================================================================================================================
+// Collects the matrices of a chain of matrix-matrix products, in order
+static void flatten_product(Expr* expr, std::vector<Expr*>& mats)
+{
+	if (is_matrix_product(expr)) {
+		flatten_product(expr->args[0], mats);
+		flatten_product(expr->args[1], mats);
+	}
+	else
+		mats.push_back(expr);
+}
+
+// ====================================================================================================================
+static Expr* reassociate_expr(Module& module, Expr* expr, const CompilerOptions& options);
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can be changed
+static void reassociate_lvalue(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	if (expr->kind == ExprKind::Index) {
+		reassociate_lvalue(module, expr->args[0], options);
+		expr->args[1] = reassociate_expr(module, expr->args[1], options);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		reassociate_lvalue(module, expr->args[0], options);
+}
+
+// ====================================================================================================================
+static Expr* reassociate_expr(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	if (!expr)
+		return nullptr;
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op)) {
+		reassociate_lvalue(module, expr->args[0], options);
+		return expr;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = reassociate_expr(module, expr->args[i], options);
+
+	// Involutions: trans(trans(m)) = m is exact, inv(inv(m)) = m is only approximate in floating point
+	if ((is_call(expr, "transpose") || (options.fast_math && is_call(expr, "inverse"))) &&
+			is_call(expr->args[0], expr->out_name))
+		return expr->args[0]->args[0];
+
+	if (expr->kind != ExprKind::Binary || expr->op != Op::Mul || !expr->type.is_vector_type())
+		return expr;
+	auto left = expr->args[0], right = expr->args[1];
+	bool col_vec = left->type.is_matrix_type() && right->type.is_vector_type(); // M * v
+	bool row_vec = left->type.is_vector_type() && right->type.is_matrix_type(); // v * M
+	if (!col_vec && !row_vec)
+		return expr;
+
+	// Multiplying by a transpose is the same as multiplying from the other side: trans(M) * v = v * M
+	auto mat = col_vec ? left : right;
+	if (is_call(mat, "transpose")) {
+		auto vec = col_vec ? right : left;
+		return reassociate_expr(module, col_vec ?
+			module.new_binary(Op::Mul, vec, mat->args[0], expr->type, expr->line) :
+			module.new_binary(Op::Mul, mat->args[0], vec, expr->type, expr->line), options);
+	}
+
+	// Apply each matrix to the vector in turn, which replaces each matrix-matrix product with a matrix-vector product
+	//    (for example, (P * V * M) * v = P * (V * (M * v))), this changes the rounding so it requires fast math
+	if (!options.fast_math || !is_matrix_product(mat))
+		return expr;
+	std::vector<Expr*> mats{};
+	flatten_product(mat, mats);
+	if (col_vec) {
+		auto vec = right;
+		for (auto it = mats.rbegin(); it != mats.rend(); ++it)
+			vec = module.new_binary(Op::Mul, *it, vec, expr->type, expr->line);
+		return vec;
+	}
+	else {
+		auto vec = left;
+		for (auto m : mats)
+			vec = module.new_binary(Op::Mul, vec, m, expr->type, expr->line);
+		return vec;
+	}
+}
+
+// ====================================================================================================================
+static void reassociate_block(Module& module, Block& block, const CompilerOptions& options)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			reassociate_lvalue(module, stmt->target, options);
+		stmt->value = reassociate_expr(module, stmt->value, options);
+		stmt->init = reassociate_expr(module, stmt->init, options);
+		reassociate_block(module, stmt->updates, options);
+		reassociate_block(module, stmt->body, options);
+		reassociate_block(module, stmt->else_body, options);
+	}
+}
+
+// ====================================================================================================================
+void ReassociateMatrices(Module& module, Function& func, const CompilerOptions& options)
+{
+	reassociate_block(module, func.body, options);
+}
+
+} // namespace ir
+} // namespace hlsv
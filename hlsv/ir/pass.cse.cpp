@@ -0,0 +1,242 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the common subexpression elimination pass. Each block is value numbered separately, and
+//    repeated expressions are replaced with a temporary that is declared before the first use. An expression stops
+//    being available once any variable it reads is written.
+
+#include "passes.hpp"
+#include "eval.hpp"
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// A set of equivalent expressions within a block
+struct ValueEntry final
+{
+	std::vector<Expr*> sites;
+	std::vector<Stmt*> stmts; // The statements that contain each site
+	SymbolSet deps;           // The variables that the expression reads
+};
+
+// The value numbering state for a single block
+class ValueTable final
+{
+public:
+	std::vector<ValueEntry> entries;
+	std::unordered_map<string, uint32> available;   // Expression key -> entry index
+	std::unordered_map<const Expr*, uint32> numbers; // Expression node -> entry index
+
+	// Removes the available expressions that read any of the variables
+	void invalidate(const SymbolSet& written) {
+		for (auto it = available.begin(); it != available.end(); ) {
+			bool dep = false;
+			for (auto sym : written) {
+				if (entries[it->second].deps.count(sym)) {
+					dep = true;
+					break;
+				}
+			}
+			it = dep ? available.erase(it) : std::next(it);
+		}
+	}
+};
+
+// ====================================================================================================================
+// Only expressions that do real work are worth a temporary
+static bool is_candidate(const Expr* expr)
+{
+	if (expr->type.is_array || !expr->type.is_value_type())
+		return false;
+	switch (expr->kind)
+	{
+	case ExprKind::Unary: return !IsIncDecOp(expr->op) && expr->op != Op::Pos;
+	case ExprKind::Binary: return true;
+	case ExprKind::Call: { // Image loads can see the stores made between them
+		for (uint32 i = 0; i < expr->arg_count; ++i) {
+			if (expr->args[i]->type.is_image_type())
+				return false;
+		}
+		return true;
+	}
+	default: return false;
+	}
+}
+
+// ====================================================================================================================
+// Builds the structural key for the expression, and collects the variables that it reads
+static string value_key(const Expr* expr, const ValueTable& table, SymbolSet& deps)
+{
+	string key = strarg("%u:%u:%u:%u", (uint32)expr->kind, (uint32)expr->op, (uint32)expr->type.type, expr->arg_count);
+	switch (expr->kind)
+	{
+	case ExprKind::Literal: key += strarg("=%u", expr->value.ui); break;
+	case ExprKind::Variable: key += strarg("@%p", (const void*)expr->symbol); deps.insert(expr->symbol); break;
+	case ExprKind::Swizzle:
+		key += '.';
+		for (uint8 i = 0; i < expr->swizzle_count; ++i)
+			key += (char)('0' + expr->swizzle[i]);
+		break;
+	case ExprKind::Call: key += '!'; key += expr->out_name; break;
+	default: break;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		auto child = expr->args[i];
+		auto it = table.numbers.find(child);
+		if (it != table.numbers.end()) { // Already numbered, refer to the entry instead of the full subtree
+			key += strarg("(#%u)", it->second);
+			const auto& cdeps = table.entries[it->second].deps;
+			deps.insert(cdeps.begin(), cdeps.end());
+		}
+		else
+			key += '(' + value_key(child, table, deps) + ')';
+	}
+	return key;
+}
+
+// ====================================================================================================================
+// Numbers the expression tree in evaluation order, skipping the parts that are only conditionally evaluated
+static void number_expr(Expr* expr, Stmt* stmt, ValueTable& table)
+{
+	bool short_circuit = (expr->kind == ExprKind::Binary && (expr->op == Op::LogAnd || expr->op == Op::LogOr));
+	uint32 count = (expr->kind == ExprKind::Ternary || short_circuit) ? 1u : expr->arg_count;
+	for (uint32 i = 0; i < count; ++i)
+		number_expr(expr->args[i], stmt, table);
+
+	if (!is_candidate(expr))
+		return;
+	SymbolSet deps{};
+	auto key = value_key(expr, table, deps);
+	auto it = table.available.find(key);
+	uint32 idx;
+	if (it == table.available.end()) {
+		idx = (uint32)table.entries.size();
+		table.entries.push_back({ { }, { }, std::move(deps) });
+		table.available.emplace(std::move(key), idx);
+	}
+	else
+		idx = it->second;
+	table.entries[idx].sites.push_back(expr);
+	table.entries[idx].stmts.push_back(stmt);
+	table.numbers.emplace(expr, idx);
+}
+
+// ====================================================================================================================
+static void find_nodes(const Expr* expr, std::unordered_set<const Expr*>& nodes)
+{
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		nodes.insert(expr->args[i]);
+		find_nodes(expr->args[i], nodes);
+	}
+}
+
+// ====================================================================================================================
+static void replace_sites(Expr*& expr, const ValueTable& table, const std::vector<Symbol*>& temps, Module& module)
+{
+	auto it = table.numbers.find(expr);
+	if (it != table.numbers.end() && temps[it->second]) {
+		expr = module.new_variable(temps[it->second], expr->line);
+		return;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		replace_sites(expr->args[i], table, temps, module);
+}
+
+// ====================================================================================================================
+static uint32 cse_block(Module& module, Block& block, uint32 temp_index)
+{
+	// Number the expressions in order, invalidating on writes
+	ValueTable table{};
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		bool loop = (stmt->kind == StmtKind::While || stmt->kind == StmtKind::DoWhile || stmt->kind == StmtKind::For);
+		if (stmt->value && !loop && !HasSideEffects(stmt->value))
+			number_expr(stmt->value, stmt, table);
+
+		// Nested blocks are handled separately, and only their writes affect this block
+		temp_index = cse_block(module, stmt->body, temp_index);
+		temp_index = cse_block(module, stmt->else_body, temp_index);
+		SymbolSet written{};
+		if (stmt->kind == StmtKind::Assign)
+			written.insert(GetBaseSymbol(stmt->target));
+		else if (stmt->kind == StmtKind::For)
+			written.insert(stmt->symbol);
+		FindModifiedSymbols(stmt->target, written); // Increments in the lvalue indices
+		FindModifiedSymbols(stmt->value, written);
+		FindModifiedSymbols(stmt->init, written);
+		FindModifiedSymbols(stmt->body, written);
+		FindModifiedSymbols(stmt->else_body, written);
+		FindModifiedSymbols(stmt->updates, written);
+		if (!written.empty())
+			table.invalidate(written);
+	}
+
+	// Pick the temporaries from the outermost expressions inwards (entries are numbered in post-order), the sites
+	//    inside of a replaced expression are not evaluated anymore and do not count towards the inner expressions
+	std::vector<Symbol*> temps(table.entries.size(), nullptr);
+	std::vector<uint32> firsts(table.entries.size(), 0);
+	std::vector<bool> selected(table.entries.size(), false);
+	std::unordered_set<const Expr*> removed{};
+	for (uint32 i = (uint32)table.entries.size(); i-- > 0; ) {
+		const auto& entry = table.entries[i];
+		uint32 live = 0, first = 0;
+		for (uint32 si = 0; si < entry.sites.size(); ++si) {
+			if (removed.count(entry.sites[si]))
+				continue;
+			if (live++ == 0)
+				first = si;
+		}
+		if (live < 2)
+			continue;
+		firsts[i] = first;
+		selected[i] = true;
+		for (uint32 si = first + 1; si < entry.sites.size(); ++si)
+			find_nodes(entry.sites[si], removed);
+	}
+
+	for (uint32 i = 0; i < table.entries.size(); ++i) {
+		if (selected[i]) {
+			const auto type = table.entries[i].sites[firsts[i]]->type;
+			temps[i] = module.new_symbol(strarg("_cse%u", temp_index++), type, VarScope::Block);
+		}
+	}
+
+	// Replace the sites in the existing statements, then declare the temporaries before their first use, inner
+	//    temporaries are declared first as they can appear in the initializers of the outer ones
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->value)
+			replace_sites(stmt->value, table, temps, module);
+	}
+	for (uint32 i = 0; i < table.entries.size(); ++i) {
+		if (!temps[i])
+			continue;
+		const auto& entry = table.entries[i];
+		auto value = entry.sites[firsts[i]];
+		for (uint32 ai = 0; ai < value->arg_count; ++ai)
+			replace_sites(value->args[ai], table, temps, module);
+		auto decl = module.new_stmt(StmtKind::Declare, value->line);
+		decl->symbol = temps[i];
+		decl->value = value;
+		block.insert_before(entry.stmts[firsts[i]], decl);
+	}
+	return temp_index;
+}
+
+// ====================================================================================================================
+void EliminateCommonSubexprs(Module& module, Function& func)
+{
+	cse_block(module, func.body, 0);
+}
+
+} // namespace ir
+} // namespace hlsv
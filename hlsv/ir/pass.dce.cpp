@@ -0,0 +1,128 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the dead code elimination pass
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+// Gets the constant value of a boolean condition, returns false if it is not known
+static bool get_condition(const Expr* cond, bool& value)
+{
+	ConstValue val;
+	if (!EvaluateConstant(cond, val))
+		return false;
+	value = (val.comps[0].ui != 0u);
+	return true;
+}
+
+// ====================================================================================================================
+// Replaces the statement with the contents of the block
+static void replace_with(Block& parent, Stmt* stmt, Block& contents)
+{
+	if (contents.first && contents.first == contents.last && contents.first->kind == StmtKind::If)
+		contents.first->is_elif = false; // Lifted out of an else block
+	parent.splice_before(stmt, contents);
+	parent.remove(stmt);
+}
+
+// ====================================================================================================================
+static bool eliminate_block(Module& module, Block& block)
+{
+	bool changed = false;
+	for (auto stmt = block.first; stmt; ) {
+		auto next = stmt->next;
+		changed = eliminate_block(module, stmt->body) || changed;
+		changed = eliminate_block(module, stmt->else_body) || changed;
+
+		bool cond;
+		switch (stmt->kind)
+		{
+		case StmtKind::Declare: // Propagated constants are no longer referenced
+			if (stmt->symbol->value && stmt->symbol->scope == VarScope::Block) {
+				block.remove(stmt);
+				changed = true;
+			}
+			break;
+		case StmtKind::If:
+			if (get_condition(stmt->value, cond)) {
+				auto& taken = cond ? stmt->body : stmt->else_body;
+				if (!DeclaresVariables(taken)) {
+					replace_with(block, stmt, taken);
+					changed = true;
+				}
+				else if (!stmt->else_body.empty()) {
+					stmt->value = module.new_literal(true, stmt->line); // Keep the scope of the taken branch only
+					if (!cond)
+						std::swap(stmt->body, stmt->else_body);
+					stmt->else_body = { nullptr, nullptr };
+					changed = true;
+				}
+			}
+			break;
+		case StmtKind::While:
+			if (get_condition(stmt->value, cond) && !cond) {
+				block.remove(stmt);
+				changed = true;
+			}
+			break;
+		case StmtKind::DoWhile:
+			if (get_condition(stmt->value, cond) && !cond && !HasLoopControl(stmt->body) &&
+					!DeclaresVariables(stmt->body)) {
+				replace_with(block, stmt, stmt->body);
+				changed = true;
+			}
+			break;
+		case StmtKind::For: { // Check the condition with the initial counter value
+			if (!IsConstantForm(stmt->init))
+				break;
+			auto saved = stmt->symbol->value;
+			stmt->symbol->value = stmt->init;
+			bool known = get_condition(stmt->value, cond);
+			stmt->symbol->value = saved;
+			if (known && !cond) {
+				block.remove(stmt);
+				changed = true;
+			}
+		} break;
+		default: break;
+		}
+
+		stmt = next;
+	}
+
+	// Remove the unreachable statements after the first jump
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Break || stmt->kind == StmtKind::Continue || stmt->kind == StmtKind::Discard ||
+				stmt->kind == StmtKind::Return) {
+			while (stmt->next) {
+				block.remove(stmt->next);
+				changed = true;
+			}
+			break;
+		}
+	}
+
+	return changed;
+}
+
+// ====================================================================================================================
+bool EliminateDeadCode(Module& module, Function& func)
+{
+	return eliminate_block(module, func.body);
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,93 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the constant folding pass
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+// Folds the subexpressions of an assignment target, without replacing the variable itself
+static Expr* fold_lvalue(Module& module, Expr* expr)
+{
+	if (expr->kind == ExprKind::Index) {
+		expr->args[0] = fold_lvalue(module, expr->args[0]);
+		expr->args[1] = FoldExpr(module, expr->args[1]);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		expr->args[0] = fold_lvalue(module, expr->args[0]);
+	return expr;
+}
+
+// ====================================================================================================================
+Expr* FoldExpr(Module& module, Expr* expr)
+{
+	if (!expr)
+		return nullptr;
+
+	// Fold the children first, so each level only needs to look at constants one level down
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		expr->args[0] = fold_lvalue(module, expr->args[0]);
+	else {
+		for (uint32 i = 0; i < expr->arg_count; ++i)
+			expr->args[i] = FoldExpr(module, expr->args[i]);
+	}
+
+	// Selection and short-circuiting with a constant condition only keeps the evaluated side
+	if (expr->kind == ExprKind::Ternary && expr->args[0]->is_literal())
+		return expr->args[0]->value.ui ? expr->args[1] : expr->args[2];
+	if (expr->kind == ExprKind::Binary && (expr->op == Op::LogAnd || expr->op == Op::LogOr)) {
+		bool is_and = (expr->op == Op::LogAnd);
+		auto left = expr->args[0], right = expr->args[1];
+		if (left->is_literal()) // (true && x) = x, (false && x) = false, (true || x) = true, (false || x) = x
+			return ((left->value.ui != 0u) == is_and) ? right : left;
+		if (right->is_literal()) { // (x && true) = x, (x || false) = x
+			if ((right->value.ui != 0u) == is_and)
+				return left;
+			if (!HasSideEffects(left))
+				return right;
+		}
+	}
+
+	// Replace with the evaluated value
+	if (IsConstantForm(expr))
+		return expr;
+	ConstValue val;
+	if (EvaluateConstant(expr, val))
+		return MakeConstantExpr(module, val, expr->line);
+	return expr;
+}
+
+// ====================================================================================================================
+static void fold_block(Module& module, Block& block)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			stmt->target = fold_lvalue(module, stmt->target);
+		stmt->value = FoldExpr(module, stmt->value);
+		stmt->init = FoldExpr(module, stmt->init);
+		fold_block(module, stmt->updates);
+		fold_block(module, stmt->body);
+		fold_block(module, stmt->else_body);
+	}
+}
+
+// ====================================================================================================================
+void FoldConstants(Module& module, Function& func)
+{
+	fold_block(module, func.body);
+}
+
+} // namespace ir
+} // namespace hlsv
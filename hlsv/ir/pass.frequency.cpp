@@ -0,0 +1,214 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the frequency hoisting pass, which moves fragment stage expressions that read locals into the
+//    vertex stage, and passes their results to the fragment stage with new locals. Linear interpolation of a value
+//    is only the same as calculating the value from interpolated inputs if the value is affine in the interpolated
+//    locals (with coefficients that are the same for all vertices), while flat locals are not interpolated at all, so
+//    any value that only depends on flat locals and uniforms can be moved into a new flat local.
+
+#include "passes.hpp"
+#include "eval.hpp"
+#include <unordered_map>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// How an expression changes over a primitive
+enum class Frequency : uint8
+{
+	None,    // Cannot be calculated in the vertex stage
+	Uniform, // Only reads uniforms, push constants, and constants
+	Flat,    // Reads flat locals, and is the same for all fragments in a primitive
+	Affine   // Affine function of interpolated locals, with uniform coefficients
+};
+
+// The state for the moved expressions
+struct FrequencyInfo final
+{
+	Function& vert;
+	uint32 free_slots;
+	std::unordered_map<string, Symbol*> locals; // Expression key -> new local
+	std::vector<Symbol*> symbols;
+};
+
+// ====================================================================================================================
+static inline bool is_float_type(const Expr* expr)
+{
+	return HLSVType::GetComponentType(expr->type.type) == HLSVType::Float;
+}
+
+// ====================================================================================================================
+static Frequency get_frequency(const Expr* expr)
+{
+	switch (expr->kind)
+	{
+	case ExprKind::Literal: return Frequency::Uniform;
+	case ExprKind::Variable: {
+		auto scope = expr->symbol->scope;
+		if (scope == VarScope::Uniform || scope == VarScope::PushConstant || scope == VarScope::Constant)
+			return expr->type.is_value_type() ? Frequency::Uniform : Frequency::None;
+		if (scope == VarScope::Local)
+			return expr->symbol->is_flat ? Frequency::Flat : Frequency::Affine;
+		return Frequency::None;
+	}
+	case ExprKind::Unary:
+		if (IsIncDecOp(expr->op))
+			return Frequency::None;
+		break;
+	case ExprKind::Call:
+		if (!IsEvaluableBuiltin(expr->out_name)) // Only pure math functions, derivatives and sampling stay
+			return Frequency::None;
+		break;
+	case ExprKind::InitList: return Frequency::None;
+	default: break;
+	}
+
+	// Combine the argument frequencies
+	bool flat = false, affine = false;
+	Frequency args[3] = { Frequency::None, Frequency::None, Frequency::None };
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		auto freq = get_frequency(expr->args[i]);
+		if (freq == Frequency::None)
+			return Frequency::None;
+		flat = flat || (freq == Frequency::Flat);
+		affine = affine || (freq == Frequency::Affine);
+		if (i < 3)
+			args[i] = freq;
+	}
+	if (!affine)
+		return flat ? Frequency::Flat : Frequency::Uniform;
+	if (flat) // The coefficients would change between the vertices
+		return Frequency::None;
+
+	// Only the linear operations keep affine values affine
+	switch (expr->kind)
+	{
+	case ExprKind::Unary: return (expr->op == Op::Neg || expr->op == Op::Pos) ? Frequency::Affine : Frequency::None;
+	case ExprKind::Binary:
+		if (!is_float_type(expr))
+			return Frequency::None;
+		if (expr->op == Op::Add || expr->op == Op::Sub)
+			return Frequency::Affine;
+		if (expr->op == Op::Mul) // Both sides affine would be quadratic
+			return (args[0] == Frequency::Uniform || args[1] == Frequency::Uniform) ? Frequency::Affine : Frequency::None;
+		if (expr->op == Op::Div)
+			return (args[1] == Frequency::Uniform) ? Frequency::Affine : Frequency::None;
+		return Frequency::None;
+	case ExprKind::Index: return (args[1] == Frequency::Uniform) ? Frequency::Affine : Frequency::None;
+	case ExprKind::Swizzle: return Frequency::Affine;
+	case ExprKind::Construct: { // Building vectors and matrices from float components, but not conversions
+		if (!is_float_type(expr))
+			return Frequency::None;
+		for (uint32 i = 0; i < expr->arg_count; ++i) {
+			if (!is_float_type(expr->args[i]))
+				return Frequency::None;
+		}
+		return Frequency::Affine;
+	}
+	default: return Frequency::None;
+	}
+}
+
+// ====================================================================================================================
+// Only expressions that do real work are worth a new local
+static bool is_candidate(const Expr* expr)
+{
+	if (expr->type.is_array || !expr->type.is_value_type() || IsConstantForm(expr))
+		return false;
+	if (HLSVType::GetComponentType(expr->type.type) == HLSVType::Bool) // Cannot be a stage interface type
+		return false;
+	return expr->kind == ExprKind::Unary || expr->kind == ExprKind::Binary || expr->kind == ExprKind::Ternary ||
+		expr->kind == ExprKind::Call || expr->kind == ExprKind::Construct;
+}
+
+// ====================================================================================================================
+// Replaces the largest fragment expressions that can be moved with new locals
+static Expr* hoist_expr(Module& module, Expr* expr, FrequencyInfo& info)
+{
+	if (!expr)
+		return nullptr;
+	if (is_candidate(expr)) {
+		auto freq = get_frequency(expr);
+		if (freq == Frequency::Flat || freq == Frequency::Affine) {
+			auto key = GetExprKey(expr);
+			auto it = info.locals.find(key);
+			if (it == info.locals.end()) {
+				bool flat = (freq == Frequency::Flat) || !is_float_type(expr);
+				uint32 slots = expr->type.get_slot_size();
+				if (slots > info.free_slots)
+					return expr; // Out of slots, so this expression stays in the fragment stage
+				info.free_slots -= slots;
+				auto sym = module.new_symbol(strarg("_freq%u", (uint32)info.symbols.size()), expr->type, VarScope::Local,
+					flat);
+				auto assign = module.new_stmt(StmtKind::Assign, expr->line);
+				assign->target = module.new_variable(sym, expr->line);
+				assign->value = expr;
+				info.vert.body.append(assign);
+				info.symbols.push_back(sym);
+				it = info.locals.emplace(std::move(key), sym).first;
+			}
+			return module.new_variable(it->second, expr->line);
+		}
+	}
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		return expr; // Lvalue
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = hoist_expr(module, expr->args[i], info);
+	return expr;
+}
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can be moved
+static void hoist_lvalue(Module& module, Expr* expr, FrequencyInfo& info)
+{
+	if (expr->kind == ExprKind::Index) {
+		hoist_lvalue(module, expr->args[0], info);
+		expr->args[1] = hoist_expr(module, expr->args[1], info);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		hoist_lvalue(module, expr->args[0], info);
+}
+
+// ====================================================================================================================
+static void hoist_block(Module& module, Block& block, FrequencyInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			hoist_lvalue(module, stmt->target, info);
+		stmt->value = hoist_expr(module, stmt->value, info);
+		stmt->init = hoist_expr(module, stmt->init, info);
+		hoist_block(module, stmt->updates, info);
+		hoist_block(module, stmt->body, info);
+		hoist_block(module, stmt->else_body, info);
+	}
+}
+
+// ====================================================================================================================
+std::vector<Symbol*> HoistToVertexStage(Module& module, uint32 free_slots)
+{
+	Function* vert = nullptr;
+	Function* frag = nullptr;
+	for (auto func : module.functions()) {
+		if (func->stage == ShaderStages::Vertex) vert = func;
+		else if (func->stage == ShaderStages::Fragment) frag = func;
+	}
+	if (!vert || !frag)
+		return { };
+
+	// The values are calculated at the end of the vertex stage, after all locals have their final values
+	FrequencyInfo info{ *vert, free_slots, { }, { } };
+	hoist_block(module, frag->body, info);
+	return info.symbols;
+}
+
+} // namespace ir
+} // namespace hlsv
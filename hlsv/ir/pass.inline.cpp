@@ -0,0 +1,187 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the inlining pass for user functions. The copied body is placed before the statement that
+//    contains the call, and the call is replaced with the copied return value. User functions cannot modify any of
+//    the variables of the caller, so evaluating the body early does not change the result.
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// Functions up to this size (in IR nodes) are always inlined, as the call costs about as much as the body
+static const uint32 MAX_SMALL_SIZE = 16;
+// Larger functions are inlined if all of the copies of the body add at most this many nodes to the caller
+static const uint32 MAX_INLINE_GROWTH = 256;
+// The prefix of the variables declared by inlined bodies
+static const char* const INLINE_PREFIX = "_inl";
+
+// The call counts used by the inlining heuristic
+struct InlineInfo final
+{
+	std::unordered_map<const Function*, uint32> calls; // The number of calls to each function within the caller
+	uint32 inlined; // The number of calls that were replaced, the body can add nothing to the caller if it only returns
+};
+
+// ====================================================================================================================
+static void count_calls(const Expr* expr, InlineInfo& info)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::Call && expr->func)
+		++info.calls[expr->func];
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		count_calls(expr->args[i], info);
+}
+
+// ====================================================================================================================
+static void count_calls(const Block& block, InlineInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		count_calls(stmt->target, info);
+		count_calls(stmt->value, info);
+		count_calls(stmt->init, info);
+		count_calls(stmt->updates, info);
+		count_calls(stmt->body, info);
+		count_calls(stmt->else_body, info);
+	}
+}
+
+// ====================================================================================================================
+static bool has_return(const Block& block)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Return || has_return(stmt->body) || has_return(stmt->else_body))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+static bool should_inline(const Function& callee, const InlineInfo& info)
+{
+	// The body can only be copied into an expression if it runs to the end, and returns there
+	auto last = callee.body.last;
+	if (callee.hint == InlineHint::NoInline || !last || last->kind != StmtKind::Return)
+		return false;
+	for (auto stmt = callee.body.first; stmt != last; stmt = stmt->next) {
+		if (has_return(stmt->body) || has_return(stmt->else_body))
+			return false;
+	}
+	if (callee.hint == InlineHint::Inline)
+		return true;
+
+	uint32 size = GetBlockSize(callee.body);
+	return (size <= MAX_SMALL_SIZE) || ((size * info.calls.at(&callee)) <= MAX_INLINE_GROWTH);
+}
+
+// ====================================================================================================================
+// Gets if the argument is only evaluated for some values of the other arguments (ternary arms, and the right side of
+//    the short-circuit operators)
+static inline bool is_conditional_arg(const Expr* expr, uint32 index)
+{
+	return (expr->kind == ExprKind::Ternary && index > 0) ||
+		(expr->kind == ExprKind::Binary && (expr->op == Op::LogAnd || expr->op == Op::LogOr) && index == 1);
+}
+
+// ====================================================================================================================
+// Replaces the inlined calls with their return values, and adds the rest of the copied bodies to pre. The bodies in
+//    pre always run, so calls in conditional arguments are kept, which stops guarded code from running unguarded.
+static Expr* inline_expr(Module& module, Expr* expr, Block& pre, InlineInfo& info, bool conditional)
+{
+	if (!expr)
+		return nullptr;
+	for (uint32 i = 0; i < expr->arg_count; ++i) // Calls in the arguments are evaluated first
+		expr->args[i] = inline_expr(module, expr->args[i], pre, info, conditional || is_conditional_arg(expr, i));
+	if (conditional || expr->kind != ExprKind::Call || !expr->func || !should_inline(*expr->func, info))
+		return expr;
+	const auto& callee = *expr->func;
+
+	// Arguments that are variables or constants are used directly if the parameter is never written, all other
+	//    arguments are evaluated once into a copy of the parameter
+	CloneMap map{ { }, INLINE_PREFIX };
+	SymbolSet modified{ };
+	FindModifiedSymbols(callee.body, modified);
+	for (uint32 i = 0; i < callee.param_count; ++i) {
+		auto param = callee.params[i];
+		auto arg = expr->args[i];
+		if (!modified.count(param) && (arg->is_variable() || IsConstantForm(arg))) {
+			map.values[param] = arg;
+			continue;
+		}
+		auto decl = module.new_stmt(StmtKind::Declare, expr->line);
+		decl->symbol = module.new_symbol("", param->type, VarScope::Block);
+		decl->symbol->name = module.arena().copy_str(strarg("%s%u", INLINE_PREFIX, decl->symbol->id));
+		decl->value = arg;
+		pre.append(decl);
+		map.values[param] = module.new_variable(decl->symbol, expr->line);
+	}
+
+	// Copy the body, and replace the call with the return value
+	CloneBlock(module, callee.body, pre, map);
+	auto ret = pre.last;
+	pre.remove(ret);
+	++info.inlined;
+	return ret->value;
+}
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can contain calls
+static void inline_lvalue(Module& module, Expr* expr, Block& pre, InlineInfo& info)
+{
+	if (expr->kind == ExprKind::Index) {
+		inline_lvalue(module, expr->args[0], pre, info);
+		expr->args[1] = inline_expr(module, expr->args[1], pre, info, false);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		inline_lvalue(module, expr->args[0], pre, info);
+}
+
+// ====================================================================================================================
+static void inline_block(Module& module, Block& block, InlineInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		inline_block(module, stmt->body, info);
+		inline_block(module, stmt->else_body, info);
+
+		// The body is evaluated before the statement, which would reorder it with other side effects
+		if ((stmt->target && HasSideEffects(stmt->target)) || (stmt->value && HasSideEffects(stmt->value)) ||
+				(stmt->init && HasSideEffects(stmt->init)))
+			continue;
+
+		// Loop conditions and updates run more than once, so only the for loop initializer is inlined
+		Block pre{ nullptr, nullptr };
+		bool loop = (stmt->kind == StmtKind::While || stmt->kind == StmtKind::DoWhile || stmt->kind == StmtKind::For);
+		if (stmt->target)
+			inline_lvalue(module, stmt->target, pre, info);
+		if (!loop)
+			stmt->value = inline_expr(module, stmt->value, pre, info, false);
+		stmt->init = inline_expr(module, stmt->init, pre, info, false);
+		if (!pre.empty())
+			block.splice_before(stmt, pre);
+	}
+}
+
+// ====================================================================================================================
+bool InlineFunctions(Module& module, Function& func)
+{
+	InlineInfo info{ { }, 0 };
+	count_calls(func.body, info);
+	if (info.calls.empty())
+		return false;
+	inline_block(module, func.body, info);
+	return info.inlined > 0;
+}
+
+} // namespace ir
+} // namespace hlsv
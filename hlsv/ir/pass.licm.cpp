@@ -0,0 +1,181 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the loop-invariant code motion pass, which moves expressions that compute the same value in
+//    every iteration into temporaries that are declared before the loop
+
+#include "passes.hpp"
+#include "eval.hpp"
+#include <cstring>
+#include <unordered_map>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The state for hoisting out of a single loop
+struct LoopInfo final
+{
+	SymbolSet variant;  // Variables that are written or declared within the loop
+	bool stores_images; // If the loop writes to any images
+	Block hoisted;      // The temporaries to declare before the loop
+	std::unordered_map<string, Symbol*> temps; // Expression key -> temporary, to share identical hoisted expressions
+};
+
+// ====================================================================================================================
+static void find_declared(const Block& block, SymbolSet& declared)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Declare)
+			declared.insert(stmt->symbol);
+		find_declared(stmt->body, declared);
+		find_declared(stmt->else_body, declared);
+	}
+}
+
+// ====================================================================================================================
+static bool stores_images(const Block& block)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if ((stmt->value && HasSideEffects(stmt->value)) || stores_images(stmt->body) || stores_images(stmt->else_body))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+// Gets if the expression has the same value in every iteration, and is safe to evaluate before the loop
+static bool is_invariant(const Expr* expr, const LoopInfo& info)
+{
+	switch (expr->kind)
+	{
+	case ExprKind::Variable: return !info.variant.count(expr->symbol);
+	case ExprKind::Unary: if (IsIncDecOp(expr->op)) return false; break;
+	case ExprKind::Index: // Dynamic indices are only known to be in range when the loop actually runs
+		if (!expr->args[1]->is_literal())
+			return false;
+		break;
+	case ExprKind::Call:
+		if (expr->type == HLSVType::Void)
+			return false;
+		if (info.stores_images && std::strcmp(expr->out_name, "imageLoad") == 0)
+			return false;
+		break;
+	default: break;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (!is_invariant(expr->args[i], info))
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+// Only expressions that do real work are worth a temporary
+static bool is_candidate(const Expr* expr)
+{
+	if (expr->type.is_array || !expr->type.is_value_type() || IsConstantForm(expr))
+		return false;
+	return expr->kind == ExprKind::Unary || expr->kind == ExprKind::Binary || expr->kind == ExprKind::Call ||
+		expr->kind == ExprKind::Ternary;
+}
+
+// ====================================================================================================================
+// Replaces the largest invariant subexpressions with temporaries
+static Expr* hoist_expr(Module& module, Expr* expr, LoopInfo& info, uint32& temp_index)
+{
+	if (!expr)
+		return nullptr;
+	if (is_candidate(expr) && is_invariant(expr, info)) {
+		auto key = GetExprKey(expr);
+		auto it = info.temps.find(key);
+		if (it == info.temps.end()) {
+			auto sym = module.new_symbol(strarg("_licm%u", temp_index++), expr->type, VarScope::Block);
+			auto decl = module.new_stmt(StmtKind::Declare, expr->line);
+			decl->symbol = sym;
+			decl->value = expr;
+			info.hoisted.append(decl);
+			it = info.temps.emplace(std::move(key), sym).first;
+		}
+		return module.new_variable(it->second, expr->line);
+	}
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		return expr; // Lvalue
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = hoist_expr(module, expr->args[i], info, temp_index);
+	return expr;
+}
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can be hoisted
+static void hoist_lvalue(Module& module, Expr* expr, LoopInfo& info, uint32& temp_index)
+{
+	if (expr->kind == ExprKind::Index) {
+		hoist_lvalue(module, expr->args[0], info, temp_index);
+		expr->args[1] = hoist_expr(module, expr->args[1], info, temp_index);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		hoist_lvalue(module, expr->args[0], info, temp_index);
+}
+
+// ====================================================================================================================
+static void hoist_block(Module& module, Block& block, LoopInfo& info, uint32& temp_index)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			hoist_lvalue(module, stmt->target, info, temp_index);
+		stmt->value = hoist_expr(module, stmt->value, info, temp_index);
+		stmt->init = hoist_expr(module, stmt->init, info, temp_index);
+		hoist_block(module, stmt->updates, info, temp_index);
+		hoist_block(module, stmt->body, info, temp_index);
+		hoist_block(module, stmt->else_body, info, temp_index);
+	}
+}
+
+// ====================================================================================================================
+static bool licm_block(Module& module, Block& block, uint32& temp_index)
+{
+	bool changed = false;
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		bool loop = (stmt->kind == StmtKind::While || stmt->kind == StmtKind::DoWhile || stmt->kind == StmtKind::For);
+		if (loop) { // Outer loops first, so expressions invariant to several loops move out all at once
+			LoopInfo info{ { }, false, { nullptr, nullptr }, { } };
+			FindModifiedSymbols(stmt->body, info.variant);
+			FindModifiedSymbols(stmt->updates, info.variant);
+			FindModifiedSymbols(stmt->value, info.variant);
+			find_declared(stmt->body, info.variant);
+			if (stmt->kind == StmtKind::For)
+				info.variant.insert(stmt->symbol);
+			info.stores_images = stores_images(stmt->body) || stores_images(stmt->updates) ||
+				(stmt->value && HasSideEffects(stmt->value));
+
+			stmt->value = hoist_expr(module, stmt->value, info, temp_index);
+			hoist_block(module, stmt->updates, info, temp_index);
+			hoist_block(module, stmt->body, info, temp_index);
+			if (!info.hoisted.empty()) {
+				block.splice_before(stmt, info.hoisted);
+				changed = true;
+			}
+		}
+		changed = licm_block(module, stmt->body, temp_index) || changed;
+		changed = licm_block(module, stmt->else_body, temp_index) || changed;
+	}
+	return changed;
+}
+
+// ====================================================================================================================
+bool HoistLoopInvariants(Module& module, Function& func)
+{
+	uint32 temp_index = 0;
+	return licm_block(module, func.body, temp_index);
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,217 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the stage linking pass, which looks at how the vertex and fragment stages use the locals.
+//    Locals that the vertex stage always sets to the same constant are replaced with that constant in the fragment
+//    stage, and locals that the fragment stage never reads are removed from the stage interface.
+
+#include "passes.hpp"
+#include "eval.hpp"
+#include <unordered_map>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+using ConstantMap = std::unordered_map<const Symbol*, ConstValue>;
+
+// ====================================================================================================================
+static void find_reads(const Expr* expr, SymbolSet& reads)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::Variable)
+		reads.insert(expr->symbol);
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		find_reads(expr->args[i], reads);
+}
+
+// ====================================================================================================================
+// The variable written by an assignment is not read, even by compound assignments, since those only update itself
+static void find_lvalue_reads(const Expr* expr, SymbolSet& reads)
+{
+	if (expr->kind == ExprKind::Index) {
+		find_lvalue_reads(expr->args[0], reads);
+		find_reads(expr->args[1], reads);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		find_lvalue_reads(expr->args[0], reads);
+}
+
+// ====================================================================================================================
+// Gets if the statement is an assignment to one of the variables that can be removed
+static bool is_dead_store(const Stmt* stmt, const SymbolSet& dead)
+{
+	return stmt->kind == StmtKind::Assign && dead.count(GetBaseSymbol(stmt->target)) && !HasSideEffects(stmt->value) &&
+		!HasSideEffects(stmt->target);
+}
+
+// ====================================================================================================================
+// Finds the variables read by the block, ignoring the reads by the stores to the dead variables
+static void find_reads(const Block& block, SymbolSet& reads, const SymbolSet& dead)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (is_dead_store(stmt, dead))
+			continue;
+		if (stmt->target)
+			find_lvalue_reads(stmt->target, reads);
+		find_reads(stmt->value, reads);
+		find_reads(stmt->init, reads);
+		find_reads(stmt->updates, reads, dead);
+		find_reads(stmt->body, reads, dead);
+		find_reads(stmt->else_body, reads, dead);
+	}
+}
+
+// ====================================================================================================================
+static void count_writes(const Block& block, std::unordered_map<const Symbol*, uint32>& writes, SymbolSet& modified)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Assign)
+			++writes[GetBaseSymbol(stmt->target)];
+		FindModifiedSymbols(stmt->target, modified);
+		FindModifiedSymbols(stmt->value, modified);
+		FindModifiedSymbols(stmt->init, modified);
+		count_writes(stmt->updates, writes, modified);
+		count_writes(stmt->body, writes, modified);
+		count_writes(stmt->else_body, writes, modified);
+	}
+}
+
+// ====================================================================================================================
+// Finds the locals that are written exactly once, unconditionally, with a constant
+static void find_constant_locals(const Function& vert, ConstantMap& constants)
+{
+	std::unordered_map<const Symbol*, uint32> writes{ };
+	SymbolSet modified{ };
+	count_writes(vert.body, writes, modified);
+
+	for (auto stmt = vert.body.first; stmt; stmt = stmt->next) {
+		if (stmt->kind != StmtKind::Assign || stmt->op != Op::None || !stmt->target->is_variable())
+			continue;
+		auto sym = stmt->target->symbol;
+		if (sym->scope != VarScope::Local || writes[sym] != 1 || modified.count(sym))
+			continue;
+		ConstValue val;
+		if (EvaluateConstant(stmt->value, val))
+			constants.emplace(sym, val);
+	}
+}
+
+// ====================================================================================================================
+static Expr* replace_constants(Module& module, Expr* expr, const ConstantMap& constants)
+{
+	if (!expr)
+		return nullptr;
+	if (expr->kind == ExprKind::Variable) {
+		auto it = constants.find(expr->symbol);
+		return (it != constants.end()) ? MakeConstantExpr(module, it->second, expr->line) : expr;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = replace_constants(module, expr->args[i], constants);
+	return expr;
+}
+
+// ====================================================================================================================
+static void replace_constants(Module& module, Block& block, const ConstantMap& constants)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		stmt->target = replace_constants(module, stmt->target, constants);
+		stmt->value = replace_constants(module, stmt->value, constants);
+		stmt->init = replace_constants(module, stmt->init, constants);
+		replace_constants(module, stmt->updates, constants);
+		replace_constants(module, stmt->body, constants);
+		replace_constants(module, stmt->else_body, constants);
+	}
+}
+
+// ====================================================================================================================
+static void remove_stores(Block& block, const SymbolSet& dead)
+{
+	for (auto stmt = block.first; stmt; ) {
+		auto next = stmt->next;
+		if (is_dead_store(stmt, dead))
+			block.remove(stmt);
+		else {
+			remove_stores(stmt->updates, dead);
+			remove_stores(stmt->body, dead);
+			remove_stores(stmt->else_body, dead);
+		}
+		stmt = next;
+	}
+}
+
+// ====================================================================================================================
+bool LinkStages(Module& module, SymbolSet& passed)
+{
+	Function* vert = nullptr;
+	Function* frag = nullptr;
+	for (auto func : module.functions()) {
+		if (func->stage == ShaderStages::Vertex) vert = func;
+		else if (func->stage == ShaderStages::Fragment) frag = func;
+	}
+	if (!vert || !frag)
+		return false;
+
+	// Interpolating the same value at all vertices gives that value, so constants go straight into the fragment stage
+	ConstantMap constants{ };
+	find_constant_locals(*vert, constants);
+	if (!constants.empty()) {
+		replace_constants(module, frag->body, constants);
+		FoldConstants(module, *frag);
+		EliminateDeadCode(module, *frag);
+	}
+
+	// Only the locals read by the fragment stage are passed
+	SymbolSet frag_reads{ };
+	find_reads(frag->body, frag_reads, { });
+	for (auto sym : frag_reads) {
+		if (sym->scope == VarScope::Local)
+			passed.insert(sym);
+	}
+
+	// The other locals are dead unless the vertex stage reads them for something other than the dead stores
+	SymbolSet dead{ };
+	FindModifiedSymbols(vert->body, dead);
+	for (auto it = dead.begin(); it != dead.end(); )
+		it = ((*it)->scope == VarScope::Local && !passed.count(*it)) ? std::next(it) : dead.erase(it);
+	for (bool changed = true; changed; ) {
+		SymbolSet vert_reads{ };
+		find_reads(vert->body, vert_reads, dead);
+		changed = false;
+		for (auto it = dead.begin(); it != dead.end(); ) {
+			bool live = vert_reads.count(*it) != 0;
+			changed = changed || live;
+			it = live ? dead.erase(it) : std::next(it);
+		}
+	}
+	remove_stores(vert->body, dead);
+
+	// The locals that are still used by the vertex stage become function variables
+	SymbolSet vert_used{ };
+	find_reads(vert->body, vert_used, { });
+	FindModifiedSymbols(vert->body, vert_used);
+	for (auto sym : vert_used) {
+		if (sym->scope != VarScope::Local || passed.count(sym))
+			continue;
+		auto decl = module.new_stmt(StmtKind::Declare, 0);
+		decl->symbol = const_cast<Symbol*>(sym);
+		decl->symbol->scope = VarScope::Block;
+		decl->symbol->is_flat = false;
+		if (vert->body.first)
+			vert->body.insert_before(vert->body.first, decl);
+		else
+			vert->body.append(decl);
+	}
+	return true;
+}
+
+} // namespace ir
+} // namespace hlsv
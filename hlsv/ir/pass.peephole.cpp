@@ -0,0 +1,231 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the peephole pass, which replaces small expression patterns with cheaper equivalents
+
+#include "passes.hpp"
+#include "eval.hpp"
+#include <cmath>
+#include <cstring>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+// Gets if the expression is a constant with all components equal to the value, float zeros must also match the sign
+static bool is_splat(const Expr* expr, float value)
+{
+	ConstValue val;
+	if (!IsConstantForm(expr) || !EvaluateConstant(expr, val))
+		return false;
+	auto ct = val.comp_type();
+	for (uint32 i = 0; i < val.count(); ++i) {
+		auto comp = val.get(i);
+		bool eq =
+			(ct == HLSVType::Float) ? ((comp.f == value) && (std::signbit(comp.f) == std::signbit(value))) :
+			(ct == HLSVType::Int) ? ((float)comp.si == value) :
+			(ct == HLSVType::UInt) ? ((float)comp.ui == value) : false;
+		if (!eq)
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+static inline bool is_call(const Expr* expr, const char* out_name, uint32 arg_count)
+{
+	return expr->kind == ExprKind::Call && expr->arg_count == arg_count && std::strcmp(expr->out_name, out_name) == 0;
+}
+
+// ====================================================================================================================
+// Gets the reciprocal of the constant float divisor, if multiplying by it gives the same result as dividing
+static bool get_reciprocal(const Expr* expr, bool fast_math, ConstValue& recip)
+{
+	if (!IsConstantForm(expr) || !EvaluateConstant(expr, recip) || recip.comp_type() != HLSVType::Float ||
+			expr->type.is_matrix_type())
+		return false;
+	for (uint32 i = 0; i < recip.count(); ++i) {
+		int exp;
+		float div = recip.comps[i].f;
+		if (div == 0.0f || !std::isfinite(div))
+			return false;
+		if (!fast_math && std::frexp(div, &exp) != 0.5f && std::frexp(div, &exp) != -0.5f)
+			return false; // Only powers of two have exact reciprocals
+		float inv = 1.0f / div;
+		if (!std::isnormal(inv))
+			return false;
+		recip.comps[i].f = inv;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+static Expr* peephole_binary(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	auto left = expr->args[0], right = expr->args[1];
+	if (expr->type.is_boolean_type())
+		return expr;
+
+	// Identities, only when the kept operand already has the result type (no scalar to vector broadcasts)
+	// Float zeros are only identities with the sign that keeps -0 (x + -0, and x - +0), unless fast math is enabled
+	bool keep_left = (left->type == expr->type), keep_right = (right->type == expr->type);
+	bool any_zero = !expr->type.is_floating_point_type() || options.fast_math;
+	switch (expr->op)
+	{
+	case Op::Add:
+		if (keep_left && (is_splat(right, -0.0f) || (any_zero && is_splat(right, 0.0f))))
+			return left;
+		if (keep_right && (is_splat(left, -0.0f) || (any_zero && is_splat(left, 0.0f))))
+			return right;
+		break;
+	case Op::Sub:
+		if (keep_left && (is_splat(right, 0.0f) || (any_zero && is_splat(right, -0.0f))))
+			return left;
+		break;
+	case Op::Mul:
+		if (keep_left && !right->type.is_matrix_type() && is_splat(right, 1.0f))
+			return left;
+		if (keep_right && !left->type.is_matrix_type() && is_splat(left, 1.0f))
+			return right;
+		break;
+	case Op::Div: {
+		if (keep_left && is_splat(right, 1.0f))
+			return left;
+		ConstValue recip;
+		if (expr->type.is_floating_point_type() && get_reciprocal(right, options.fast_math, recip))
+			return module.new_binary(Op::Mul, left, MakeConstantExpr(module, recip, right->line), expr->type, expr->line);
+	} break;
+	default: break;
+	}
+	return expr;
+}
+
+// ====================================================================================================================
+static Expr* peephole_call(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	if (!expr->type.is_floating_point_type())
+		return expr;
+
+	// Small constant powers, the square roots are not exact replacements so they require fast math
+	if (is_call(expr, "pow", 2)) {
+		auto base = expr->args[0], exp = expr->args[1];
+		if (is_splat(exp, 1.0f))
+			return base;
+		if (is_splat(exp, 2.0f) && !HasSideEffects(base)) { // Each operand needs its own node for the later passes
+			CloneMap map{ { }, nullptr };
+			return module.new_binary(Op::Mul, base, CloneExpr(module, base, map), expr->type, expr->line);
+		}
+		if (options.fast_math && is_splat(exp, 0.5f))
+			return module.new_call("sqrt", "sqrt", expr->type, { base }, expr->line);
+		if (options.fast_math && is_splat(exp, -0.5f))
+			return module.new_call("isqrt", "inversesqrt", expr->type, { base }, expr->line);
+	}
+
+	// Saturation uses scalar bounds, which the GPU compilers recognize as a free output modifier
+	bool is_clamp = is_call(expr, "clamp", 3) && is_splat(expr->args[1], 0.0f) && is_splat(expr->args[2], 1.0f);
+	bool is_minmax = is_call(expr, "min", 2) && is_splat(expr->args[1], 1.0f) && is_call(expr->args[0], "max", 2) &&
+		is_splat(expr->args[0]->args[1], 0.0f);
+	if (is_clamp || is_minmax) {
+		auto val = is_clamp ? expr->args[0] : expr->args[0]->args[0];
+		if (!is_clamp || !expr->args[1]->is_literal() || !expr->args[2]->is_literal()) {
+			auto zero = module.new_literal(0.0f, expr->line), one = module.new_literal(1.0f, expr->line);
+			return module.new_call("clamp", "clamp", expr->type, { val, zero, one }, expr->line);
+		}
+	}
+
+	return expr;
+}
+
+// ====================================================================================================================
+static Expr* peephole_expr(Module& module, Expr* expr, const CompilerOptions& options);
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can be changed
+static void peephole_lvalue(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	if (expr->kind == ExprKind::Index) {
+		peephole_lvalue(module, expr->args[0], options);
+		expr->args[1] = peephole_expr(module, expr->args[1], options);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		peephole_lvalue(module, expr->args[0], options);
+}
+
+// ====================================================================================================================
+static Expr* peephole_expr(Module& module, Expr* expr, const CompilerOptions& options)
+{
+	if (!expr)
+		return nullptr;
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op)) {
+		peephole_lvalue(module, expr->args[0], options);
+		return expr;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = peephole_expr(module, expr->args[i], options);
+
+	switch (expr->kind)
+	{
+	case ExprKind::Unary: { // Double negation
+		auto val = expr->args[0];
+		if ((expr->op == Op::Neg || expr->op == Op::Not || expr->op == Op::BitNot) && val->kind == ExprKind::Unary &&
+				val->op == expr->op)
+			return val->args[0];
+		if (expr->op == Op::Pos)
+			return val;
+	} break;
+	case ExprKind::Binary: return peephole_binary(module, expr, options);
+	case ExprKind::Call: return peephole_call(module, expr, options);
+	case ExprKind::Swizzle: {
+		auto val = expr->args[0];
+		if (val->kind == ExprKind::Swizzle) { // Chained swizzles select from the original vector
+			for (uint8 i = 0; i < expr->swizzle_count; ++i)
+				expr->swizzle[i] = val->swizzle[expr->swizzle[i]];
+			expr->args[0] = val = val->args[0];
+		}
+		if (val->type == expr->type) { // Identity swizzle
+			bool identity = true;
+			for (uint8 i = 0; i < expr->swizzle_count; ++i)
+				identity = identity && (expr->swizzle[i] == i);
+			if (identity)
+				return val;
+		}
+	} break;
+	case ExprKind::Construct: // Casts to the same type
+		if (expr->arg_count == 1 && !expr->type.is_array && expr->args[0]->type == expr->type)
+			return expr->args[0];
+		break;
+	default: break;
+	}
+	return expr;
+}
+
+// ====================================================================================================================
+static void peephole_block(Module& module, Block& block, const CompilerOptions& options)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			peephole_lvalue(module, stmt->target, options);
+		stmt->value = peephole_expr(module, stmt->value, options);
+		stmt->init = peephole_expr(module, stmt->init, options);
+		peephole_block(module, stmt->updates, options);
+		peephole_block(module, stmt->body, options);
+		peephole_block(module, stmt->else_body, options);
+	}
+}
+
+// ====================================================================================================================
+void OptimizePeephole(Module& module, Function& func, const CompilerOptions& options)
+{
+	peephole_block(module, func.body, options);
+}
+
+} // namespace ir
+} // namespace hlsv
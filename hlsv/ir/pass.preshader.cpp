@@ -0,0 +1,126 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the preshader extraction pass. The largest subexpressions that only read uniforms, push
+//    constants, and known constants are replaced with new uniforms, which the application calculates on the CPU with
+//    the preshader bytecode when the inputs change, instead of every vertex or fragment calculating them again.
+
+#include "passes.hpp"
+#include "preshader.hpp"
+#include "../type/typehelper.hpp"
+#include <map>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The state for the preshader values in all stage functions
+struct PreshaderInfo final
+{
+	ReflectionInfo& refl;
+	uint32 size_limit;
+	uint16 size;
+	std::map<std::vector<uint8>, Symbol*> values; // Bytecode -> preshader uniform
+	std::vector<Symbol*> symbols;
+};
+
+// ====================================================================================================================
+// Only expressions that do real work are worth a uniform
+static bool is_candidate(const Expr* expr)
+{
+	if (expr->type.is_array || !expr->type.is_value_type() || IsConstantForm(expr))
+		return false;
+	return expr->kind == ExprKind::Unary || expr->kind == ExprKind::Binary || expr->kind == ExprKind::Ternary ||
+		expr->kind == ExprKind::Call || expr->kind == ExprKind::Construct;
+}
+
+// ====================================================================================================================
+static bool reads_uniforms(const Expr* expr)
+{
+	if (expr->kind == ExprKind::Variable)
+		return expr->symbol->scope == VarScope::Uniform || expr->symbol->scope == VarScope::PushConstant;
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (reads_uniforms(expr->args[i]))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+// Replaces the largest uniform-only subexpressions with preshader uniforms
+static Expr* extract_expr(Module& module, Expr* expr, PreshaderInfo& info)
+{
+	if (!expr)
+		return nullptr;
+	if (is_candidate(expr) && reads_uniforms(expr)) {
+		std::vector<uint8> code{ };
+		if (EncodePreshader(expr, info.refl, code)) {
+			auto it = info.values.find(code);
+			if (it == info.values.end()) {
+				uint16 align, size;
+				TypeHelper::GetScalarLayoutInfo(expr->type, &align, &size);
+				uint16 offset = (uint16)(((info.size + align - 1) / align) * align);
+				if ((uint32)(offset + size) > info.size_limit || (info.refl.uniforms.size() + info.symbols.size()) >= 255)
+					return expr; // The block is full, so this expression stays on the GPU
+				auto sym = module.new_symbol(strarg("_pre%u", (uint32)info.symbols.size()), expr->type, VarScope::Uniform);
+				PreshaderValue val{ expr->type, offset };
+				val.code = code;
+				info.refl.preshader.push_back(std::move(val));
+				info.symbols.push_back(sym);
+				info.size = offset + size;
+				it = info.values.emplace(std::move(code), sym).first;
+			}
+			return module.new_variable(it->second, expr->line);
+		}
+	}
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		return expr; // Lvalue
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		expr->args[i] = extract_expr(module, expr->args[i], info);
+	return expr;
+}
+
+// ====================================================================================================================
+// Only the index subexpressions of assignment targets can be extracted
+static void extract_lvalue(Module& module, Expr* expr, PreshaderInfo& info)
+{
+	if (expr->kind == ExprKind::Index) {
+		extract_lvalue(module, expr->args[0], info);
+		expr->args[1] = extract_expr(module, expr->args[1], info);
+	}
+	else if (expr->kind == ExprKind::Swizzle)
+		extract_lvalue(module, expr->args[0], info);
+}
+
+// ====================================================================================================================
+static void extract_block(Module& module, Block& block, PreshaderInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->target)
+			extract_lvalue(module, stmt->target, info);
+		stmt->value = extract_expr(module, stmt->value, info);
+		stmt->init = extract_expr(module, stmt->init, info);
+		extract_block(module, stmt->updates, info);
+		extract_block(module, stmt->body, info);
+		extract_block(module, stmt->else_body, info);
+	}
+}
+
+// ====================================================================================================================
+std::vector<Symbol*> ExtractPreshader(Module& module, ReflectionInfo& refl, uint32 size_limit)
+{
+	PreshaderInfo info{ refl, size_limit, 0, { }, { } };
+	for (auto func : module.functions())
+		extract_block(module, func->body, info);
+	return info.symbols;
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,86 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the profiling instrumentation, which adds an atomic counter increment to the start of each
+//    function body, branch arm, and loop body, so the application can read back how often each block ran
+
+#include "passes.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The name of the counter array in the generated code
+static const char* const COUNTER_NAME = "_prof";
+
+// The state used while adding the counters
+struct ProfileInfo final
+{
+	Symbol* counters;
+	ShaderStages stage; // The stages of the function being instrumented
+	std::vector<ProfileCounter>* table;
+};
+
+// ====================================================================================================================
+// Adds the next counter to the start of the block, the line is the first statement, or the owning statement if empty
+static void add_counter(Module& module, Block& block, uint32 line, ProfileInfo& info)
+{
+	if (block.first)
+		line = block.first->line;
+	uint32 index = (uint32)info.table->size();
+	auto elem = module.new_index(module.new_variable(info.counters, line), module.new_literal(index, line),
+		HLSVType::UInt, line);
+	auto stmt = module.new_stmt(StmtKind::Eval, line);
+	stmt->value = module.new_call("atomicAdd", "atomicAdd", HLSVType::UInt, { elem, module.new_literal(1u, line) },
+		line);
+	block.insert_before(block.first, stmt);
+	info.table->push_back({ line, info.stage });
+}
+
+// ====================================================================================================================
+static void instrument_block(Module& module, Block& block, ProfileInfo& info)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		switch (stmt->kind)
+		{
+		case StmtKind::If:
+			add_counter(module, stmt->body, stmt->line, info);
+			instrument_block(module, stmt->body, info);
+			// The elif statements count their own bodies, and an inserted counter would break the elif chain
+			if (!stmt->else_body.empty() && !stmt->else_body.first->is_elif)
+				add_counter(module, stmt->else_body, stmt->line, info);
+			instrument_block(module, stmt->else_body, info);
+			break;
+		case StmtKind::While:
+		case StmtKind::DoWhile:
+		case StmtKind::For:
+			add_counter(module, stmt->body, stmt->line, info);
+			instrument_block(module, stmt->body, info);
+			break;
+		default: break;
+		}
+	}
+}
+
+// ====================================================================================================================
+Symbol* InstrumentProfiling(Module& module, const std::vector<Function*>& funcs, ReflectionInfo& refl)
+{
+	auto sym = module.new_symbol(COUNTER_NAME, HLSVType::UInt, VarScope::Uniform);
+	for (auto func : funcs) {
+		ProfileInfo info{ sym, func->stage, &refl.profile_counters };
+		uint32 line = func->body.first ? func->body.first->line : 0;
+		add_counter(module, func->body, line, info);
+		instrument_block(module, func->body, info);
+	}
+	return sym;
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,47 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the constant propagation pass for function locals
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+static bool mark_constants(Block& block, const SymbolSet& modified)
+{
+	bool found = false;
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Declare) {
+			auto sym = stmt->symbol;
+			if (!sym->value && stmt->value && !sym->type.is_array && !modified.count(sym) && IsConstantForm(stmt->value)) {
+				sym->value = stmt->value;
+				found = true;
+			}
+		}
+		found = mark_constants(stmt->body, modified) || found;
+		found = mark_constants(stmt->else_body, modified) || found;
+	}
+	return found;
+}
+
+// ====================================================================================================================
+bool PropagateConstants(Function& func)
+{
+	SymbolSet modified{};
+	FindModifiedSymbols(func.body, modified);
+	return mark_constants(func.body, modified);
+}
+
+} // namespace ir
+} // namespace hlsv
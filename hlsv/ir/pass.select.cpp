@@ -0,0 +1,158 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the select pass, which replaces small if/else statements that only assign to one variable
+//    with a single assignment of a ternary selection, which removes the divergent branch
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The largest cost of each branch value that is converted without the [[flatten]] attribute
+static const uint32 MAX_ARM_COST = 6;
+// The cost used for expressions that should never be evaluated unconditionally
+static const uint32 NO_SELECT_COST = UINT32_MAX / 4;
+
+// ====================================================================================================================
+// Rough instruction cost of evaluating the expression, swizzles and variable reads are free
+static uint32 expr_cost(const Expr* expr)
+{
+	uint32 cost = 0;
+	switch (expr->kind)
+	{
+	case ExprKind::Literal:
+	case ExprKind::Variable:
+	case ExprKind::Swizzle: break;
+	case ExprKind::Unary:
+	case ExprKind::Ternary: cost = 1; break;
+	case ExprKind::Binary: cost = (expr->op == Op::Div || expr->op == Op::Mod) ? 4 : 1; break;
+	case ExprKind::Index: // Dynamic array indexing is a memory read that can be out of bounds when not taken
+		if (expr->args[0]->type.is_array && !expr->args[1]->is_constant)
+			return NO_SELECT_COST;
+		break;
+	case ExprKind::Construct: cost = 1; break;
+	case ExprKind::InitList: return NO_SELECT_COST;
+	case ExprKind::Call: cost = 4; break;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		cost += expr_cost(expr->args[i]);
+	return (cost > NO_SELECT_COST) ? NO_SELECT_COST : cost;
+}
+
+// ====================================================================================================================
+// Gets the only statement of the block, if it is an assignment
+static Stmt* get_single_assign(const Block& block)
+{
+	auto stmt = block.first;
+	return (stmt && !stmt->next && stmt->kind == StmtKind::Assign) ? stmt : nullptr;
+}
+
+// ====================================================================================================================
+// Gets if the lvalue has a non-constant index, which the branch condition can be guarding from going out of bounds
+static bool has_dynamic_index(const Expr* lval)
+{
+	for (; lval->kind == ExprKind::Index || lval->kind == ExprKind::Swizzle; lval = lval->args[0]) {
+		if (lval->kind == ExprKind::Index && !lval->args[1]->is_constant)
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+static bool can_select(const Stmt* assign, bool flatten)
+{
+	if (HasSideEffects(assign->target) || HasSideEffects(assign->value) || has_dynamic_index(assign->target))
+		return false;
+	auto cost = expr_cost(assign->value);
+	return flatten ? (cost < NO_SELECT_COST) : (cost <= MAX_ARM_COST);
+}
+
+// ====================================================================================================================
+// Copies an lvalue expression, so it can also be read as the value of the untaken branch
+static Expr* copy_lvalue(Module& module, const Expr* expr)
+{
+	auto copy = module.arena().make<Expr>();
+	*copy = *expr;
+	if (expr->arg_count > 0) {
+		copy->args = module.arena().make_array<Expr*>(expr->arg_count);
+		for (uint32 i = 0; i < expr->arg_count; ++i)
+			copy->args[i] = copy_lvalue(module, expr->args[i]);
+	}
+	return copy;
+}
+
+// ====================================================================================================================
+// Creates the assignment that replaces the if statement, or returns nullptr if it cannot be converted
+static Stmt* make_select(Module& module, const Stmt* stmt)
+{
+	if (stmt->branch_hint == BranchHint::Branch || HasSideEffects(stmt->value))
+		return nullptr;
+	bool flatten = (stmt->branch_hint == BranchHint::Flatten);
+	auto tassign = get_single_assign(stmt->body);
+	if (!tassign || tassign->target->type.is_array || !can_select(tassign, flatten))
+		return nullptr;
+	auto type = tassign->value->type;
+
+	// Find the value of the else branch, which is the current value of the variable if there is no else branch
+	Expr* fvalue = nullptr;
+	if (stmt->else_body.empty()) {
+		if (tassign->op != Op::None || type != tassign->target->type)
+			return nullptr;
+		fvalue = copy_lvalue(module, tassign->target);
+	}
+	else {
+		auto fassign = get_single_assign(stmt->else_body);
+		if (!fassign || fassign->op != tassign->op || fassign->value->type != type || !can_select(fassign, flatten))
+			return nullptr;
+		if (GetExprKey(fassign->target) != GetExprKey(tassign->target))
+			return nullptr;
+		fvalue = fassign->value;
+	}
+
+	auto select = module.new_stmt(StmtKind::Assign, stmt->line);
+	select->op = tassign->op;
+	select->target = tassign->target;
+	select->value = module.new_ternary(stmt->value, tassign->value, fvalue, type, stmt->line);
+	return select;
+}
+
+// ====================================================================================================================
+static bool select_block(Module& module, Block& block)
+{
+	bool changed = false;
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		// Convert the inner statements first, so elif chains collapse into nested selects
+		changed = select_block(module, stmt->body) || changed;
+		changed = select_block(module, stmt->else_body) || changed;
+		if (stmt->kind != StmtKind::If)
+			continue;
+
+		auto select = make_select(module, stmt);
+		if (select) {
+			block.insert_before(stmt, select);
+			block.remove(stmt);
+			stmt = select;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+// ====================================================================================================================
+bool ConvertSelects(Module& module, Function& func)
+{
+	return select_block(module, func.body);
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,161 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the loop unrolling pass for for loops with a constant trip count
+
+#include "passes.hpp"
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The limits for loops without a hint, the size is the number of IR nodes in all of the copied bodies
+static const uint32 MAX_TRIP_COUNT = 16;
+static const uint32 MAX_UNROLLED_SIZE = 256;
+// The limits for loops marked with [[unroll]]
+static const uint32 HINT_MAX_TRIP_COUNT = 256;
+static const uint32 HINT_MAX_UNROLLED_SIZE = 4096;
+
+// ====================================================================================================================
+// Gets the expression that calculates the next counter value, if the loop has a single constant step update
+static Expr* get_step_expr(Module& module, const Stmt* loop)
+{
+	auto up = loop->updates.first;
+	if (!up || up->next)
+		return nullptr;
+
+	auto counter = loop->symbol;
+	auto type = counter->type;
+	if (up->kind == StmtKind::Eval) {
+		auto val = up->value;
+		if (val->kind != ExprKind::Unary || !IsIncDecOp(val->op) || !val->args[0]->is_variable() ||
+				val->args[0]->symbol != counter)
+			return nullptr;
+		bool inc = (val->op == Op::PreInc || val->op == Op::PostInc);
+		auto one = (type == HLSVType::UInt) ? module.new_literal(1u, up->line) : module.new_literal(1, up->line);
+		return module.new_binary(inc ? Op::Add : Op::Sub, module.new_variable(counter, up->line), one, type, up->line);
+	}
+	if (up->kind == StmtKind::Assign) {
+		if (!up->target->is_variable() || up->target->symbol != counter || (up->op != Op::Add && up->op != Op::Sub))
+			return nullptr;
+		ConstValue step;
+		if (!EvaluateConstant(up->value, step))
+			return nullptr;
+		return module.new_binary(up->op, module.new_variable(counter, up->line), up->value, type, up->line);
+	}
+	return nullptr;
+}
+
+// ====================================================================================================================
+// Calculates the counter values for each iteration, returns false if the loop cannot be unrolled within the limit
+static bool get_iterations(Module& module, Stmt* loop, uint32 max_trips, std::vector<ConstValue>& values)
+{
+	auto counter = loop->symbol;
+	if (counter->type.is_array || (counter->type != HLSVType::Int && counter->type != HLSVType::UInt))
+		return false; // Float counters could round differently on the GPU
+	auto step = get_step_expr(module, loop);
+	if (!step)
+		return false;
+	ConstValue val;
+	if (!EvaluateConstant(loop->init, val))
+		return false;
+	val.type = counter->type.type; // Initializers can be promoted
+
+	// Run the loop with the counter as a known constant
+	auto saved = counter->value;
+	bool ok = false;
+	while (values.size() <= max_trips) {
+		counter->value = MakeConstantExpr(module, val, loop->line);
+		ConstValue cond;
+		if (!EvaluateConstant(loop->value, cond))
+			break;
+		if (cond.comps[0].ui == 0u) {
+			ok = true;
+			break;
+		}
+		values.push_back(val);
+		if (!EvaluateConstant(step, val))
+			break;
+	}
+	counter->value = saved;
+	return ok;
+}
+
+// ====================================================================================================================
+static bool unroll_block(Module& module, Block& block)
+{
+	bool changed = false;
+	for (auto stmt = block.first; stmt; ) {
+		auto next = stmt->next;
+		changed = unroll_block(module, stmt->body) || changed; // Inner loops first, so their size is known
+		changed = unroll_block(module, stmt->else_body) || changed;
+		if (stmt->kind != StmtKind::For || stmt->hint == LoopHint::DontUnroll) {
+			stmt = next;
+			continue;
+		}
+
+		// Check the loop
+		bool hinted = (stmt->hint == LoopHint::Unroll);
+		SymbolSet modified{};
+		FindModifiedSymbols(stmt->body, modified);
+		std::vector<ConstValue> values{};
+		if (modified.count(stmt->symbol) || HasLoopControl(stmt->body) ||
+				!get_iterations(module, stmt, hinted ? HINT_MAX_TRIP_COUNT : MAX_TRIP_COUNT, values) ||
+				(values.size() * GetBlockSize(stmt->body)) > (hinted ? HINT_MAX_UNROLLED_SIZE : MAX_UNROLLED_SIZE)) {
+			stmt = next;
+			continue;
+		}
+
+		// Copy the body for each iteration, with the counter replaced by its value
+		bool scoped = DeclaresVariables(stmt->body);
+		for (const auto& val : values) {
+			CloneMap map{ { { stmt->symbol, MakeConstantExpr(module, val, stmt->line) } }, nullptr };
+			Block copy{ nullptr, nullptr };
+			CloneBlock(module, stmt->body, copy, map);
+			if (scoped) { // Keep the declarations in their own scope
+				auto scope = module.new_stmt(StmtKind::If, stmt->line);
+				scope->value = module.new_literal(true, stmt->line);
+				scope->body = copy;
+				block.insert_before(stmt, scope);
+			}
+			else
+				block.splice_before(stmt, copy);
+		}
+		block.remove(stmt);
+		changed = true;
+
+		stmt = next;
+	}
+	return changed;
+}
+
+// ====================================================================================================================
+bool GetTripCount(Module& module, Stmt* loop, uint32 max_trips, uint32& count)
+{
+	if (loop->kind != StmtKind::For || HasLoopControl(loop->body))
+		return false;
+	SymbolSet modified{};
+	FindModifiedSymbols(loop->body, modified);
+	std::vector<ConstValue> values{};
+	if (modified.count(loop->symbol) || !get_iterations(module, loop, max_trips, values))
+		return false;
+	count = (uint32)values.size();
+	return true;
+}
+
+// ====================================================================================================================
+bool UnrollLoops(Module& module, Function& func)
+{
+	return unroll_block(module, func.body);
+}
+
+} // namespace ir
+} // namespace hlsv
@@ -0,0 +1,242 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements the pass ordering functions in passes.hpp
+
+#include "passes.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+void FindModifiedSymbols(const Block& block, SymbolSet& modified)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Assign)
+			modified.insert(GetBaseSymbol(stmt->target));
+		else if (stmt->kind == StmtKind::For)
+			modified.insert(stmt->symbol);
+		FindModifiedSymbols(stmt->target, modified);
+		FindModifiedSymbols(stmt->value, modified);
+		FindModifiedSymbols(stmt->init, modified);
+		FindModifiedSymbols(stmt->updates, modified);
+		FindModifiedSymbols(stmt->body, modified);
+		FindModifiedSymbols(stmt->else_body, modified);
+	}
+}
+
+// ====================================================================================================================
+void FindModifiedSymbols(const Expr* expr, SymbolSet& modified)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::Unary && IsIncDecOp(expr->op))
+		modified.insert(GetBaseSymbol(expr->args[0]));
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		FindModifiedSymbols(expr->args[i], modified);
+}
+
+// ====================================================================================================================
+void FindUsedSymbols(const Block& block, SymbolSet& used)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->symbol)
+			used.insert(stmt->symbol);
+		FindUsedSymbols(stmt->target, used);
+		FindUsedSymbols(stmt->value, used);
+		FindUsedSymbols(stmt->init, used);
+		FindUsedSymbols(stmt->updates, used);
+		FindUsedSymbols(stmt->body, used);
+		FindUsedSymbols(stmt->else_body, used);
+	}
+}
+
+// ====================================================================================================================
+void FindUsedSymbols(const Expr* expr, SymbolSet& used)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::Variable)
+		used.insert(expr->symbol);
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		FindUsedSymbols(expr->args[i], used);
+}
+
+// ====================================================================================================================
+bool DeclaresVariables(const Block& block)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Declare)
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+bool HasLoopControl(const Block& block)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == StmtKind::Break || stmt->kind == StmtKind::Continue)
+			return true;
+		if (stmt->kind == StmtKind::If && (HasLoopControl(stmt->body) || HasLoopControl(stmt->else_body)))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+string GetExprKey(const Expr* expr)
+{
+	string key = strarg("%u:%u:%u:%u", (uint32)expr->kind, (uint32)expr->op, (uint32)expr->type.type, expr->arg_count);
+	switch (expr->kind)
+	{
+	case ExprKind::Literal: key += strarg("=%u", expr->value.ui); break;
+	case ExprKind::Variable: key += strarg("@%p", (const void*)expr->symbol); break; // Ids are per-module
+	case ExprKind::Swizzle:
+		key += '.';
+		for (uint8 i = 0; i < expr->swizzle_count; ++i)
+			key += (char)('0' + expr->swizzle[i]);
+		break;
+	case ExprKind::Call: key += '!'; key += expr->out_name; break;
+	default: break;
+	}
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		key += '(' + GetExprKey(expr->args[i]) + ')';
+	return key;
+}
+
+// ====================================================================================================================
+Expr* CloneExpr(Module& module, const Expr* expr, CloneMap& map)
+{
+	if (!expr)
+		return nullptr;
+	if (expr->kind == ExprKind::Variable) {
+		auto it = map.values.find(expr->symbol);
+		if (it != map.values.end()) {
+			CloneMap plain{ { }, nullptr }; // The replacement is already in terms of the new symbols
+			auto copy = CloneExpr(module, it->second, plain);
+			copy->line = expr->line;
+			return copy;
+		}
+	}
+
+	auto copy = module.arena().make<Expr>();
+	*copy = *expr;
+	if (expr->arg_count > 0) {
+		copy->args = module.arena().make_array<Expr*>(expr->arg_count);
+		for (uint32 i = 0; i < expr->arg_count; ++i)
+			copy->args[i] = CloneExpr(module, expr->args[i], map);
+	}
+	return copy;
+}
+
+// ====================================================================================================================
+void CloneBlock(Module& module, const Block& block, Block& out, CloneMap& map)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		auto copy = module.new_stmt(stmt->kind, stmt->line);
+		copy->op = stmt->op;
+		copy->is_elif = stmt->is_elif;
+		copy->hint = stmt->hint;
+		copy->branch_hint = stmt->branch_hint;
+		if (stmt->symbol) { // Each copy gets its own declarations, so the other passes can track them separately
+			auto sym = stmt->symbol;
+			copy->symbol = module.new_symbol(sym->name, sym->type, sym->scope, sym->is_flat);
+			if (map.prefix)
+				copy->symbol->name = module.arena().copy_str(strarg("%s%u", map.prefix, copy->symbol->id));
+			map.values[sym] = module.new_variable(copy->symbol, stmt->line);
+		}
+		copy->init = CloneExpr(module, stmt->init, map);
+		copy->target = CloneExpr(module, stmt->target, map);
+		copy->value = CloneExpr(module, stmt->value, map);
+		CloneBlock(module, stmt->updates, copy->updates, map);
+		CloneBlock(module, stmt->body, copy->body, map);
+		CloneBlock(module, stmt->else_body, copy->else_body, map);
+		out.append(copy);
+	}
+}
+
+// ====================================================================================================================
+uint32 GetExprSize(const Expr* expr)
+{
+	if (!expr)
+		return 0;
+	uint32 size = 1;
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		size += GetExprSize(expr->args[i]);
+	return size;
+}
+
+// ====================================================================================================================
+uint32 GetBlockSize(const Block& block)
+{
+	uint32 size = 0;
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		size += 1 + GetExprSize(stmt->target) + GetExprSize(stmt->value) + GetExprSize(stmt->init);
+		size += GetBlockSize(stmt->updates) + GetBlockSize(stmt->body) + GetBlockSize(stmt->else_body);
+	}
+	return size;
+}
+
+// ====================================================================================================================
+void FindCalledFunctions(const Block& block, FunctionSet& funcs)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		FindCalledFunctions(stmt->target, funcs);
+		FindCalledFunctions(stmt->value, funcs);
+		FindCalledFunctions(stmt->init, funcs);
+		FindCalledFunctions(stmt->updates, funcs);
+		FindCalledFunctions(stmt->body, funcs);
+		FindCalledFunctions(stmt->else_body, funcs);
+	}
+}
+
+// ====================================================================================================================
+void FindCalledFunctions(const Expr* expr, FunctionSet& funcs)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::Call && expr->func && funcs.insert(expr->func).second)
+		FindCalledFunctions(expr->func->body, funcs);
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		FindCalledFunctions(expr->args[i], funcs);
+}
+
+// ====================================================================================================================
+void OptimizeFunction(Module& module, Function& func, const CompilerOptions& options)
+{
+	if (!options.optimize)
+		return;
+
+	// Inline first, so the copied bodies are optimized with the argument values
+	InlineFunctions(module, func);
+
+	// Propagation, unrolling, and branch elimination expose more of each other, so repeat them until nothing changes
+	static const uint32 MAX_ITERATIONS = 4;
+	for (uint32 i = 0; i < MAX_ITERATIONS; ++i) {
+		bool changed = PropagateConstants(func);
+		changed = UnrollLoops(module, func) || changed;
+		FoldConstants(module, func);
+		changed = EliminateDeadCode(module, func) || changed;
+		if (!changed)
+			break;
+	}
+
+	// Run after folding, so expressions that only differ by constants are matched
+	ReassociateMatrices(module, func, options);
+	OptimizePeephole(module, func, options);
+	ConvertSelects(module, func);
+	HoistLoopInvariants(module, func);
+	EliminateCommonSubexprs(module, func);
+}
+
+} // namespace ir
+} // namespace hlsv
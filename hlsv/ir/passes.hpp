@@ -0,0 +1,114 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the optimization passes that operate on the IR, and the functions that run them in order
+
+#pragma once
+
+#include "ir.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// Runs the enabled passes that operate on a single stage function
+void OptimizeFunction(Module& module, Function& func, const CompilerOptions& options);
+
+using SymbolSet = std::unordered_set<const Symbol*>;
+using FunctionSet = std::unordered_set<Function*>;
+
+// The replacements used when copying IR
+struct CloneMap final
+{
+	std::unordered_map<const Symbol*, const Expr*> values; // Symbols replaced with a copy of the expression at each use
+	const char* prefix; // If not null, the copied declarations are renamed to the prefix and their symbol id
+};
+
+/* Utilities */
+// Collects the variables written by assignments, increment and decrement operators, and loop counters
+void FindModifiedSymbols(const Block& block, SymbolSet& modified);
+void FindModifiedSymbols(const Expr* expr, SymbolSet& modified);
+// Collects all variables that are read, written, or declared
+void FindUsedSymbols(const Block& block, SymbolSet& used);
+void FindUsedSymbols(const Expr* expr, SymbolSet& used);
+// Gets if the block declares variables directly, which stops it from being merged into its parent block
+bool DeclaresVariables(const Block& block);
+// Gets if the block has a break or continue statement that applies to the loop that contains the block
+bool HasLoopControl(const Block& block);
+// Builds a string that is equal for expressions with the same structure, operators, and variables
+string GetExprKey(const Expr* expr);
+// Copies the expression or block, the variables declared in copied blocks get new symbols (added to the map)
+Expr* CloneExpr(Module& module, const Expr* expr, CloneMap& map);
+void CloneBlock(Module& module, const Block& block, Block& out, CloneMap& map);
+// The number of IR nodes in the expression or block, used to limit code growth
+uint32 GetExprSize(const Expr* expr);
+uint32 GetBlockSize(const Block& block);
+// Collects the user functions called by the block, including the functions that they call
+void FindCalledFunctions(const Block& block, FunctionSet& funcs);
+void FindCalledFunctions(const Expr* expr, FunctionSet& funcs);
+// Gets the number of iterations of a for loop with a constant trip count (up to the maximum), returns false if the
+//    count is not known, or if the body can change the counter or leave the loop early
+bool GetTripCount(Module& module, Stmt* loop, uint32 max_trips, uint32& count);
+// Estimates the static cost of the stage function, including the user functions that it calls
+PerfStats EstimateCost(Module& module, const Function& func);
+
+/* Passes */
+// Replaces calls to small user functions (or the ones marked with [[inline]]) with copies of their bodies, if the
+//    function only returns at its end and the call always runs (not in a ternary arm, or the right side of && or ||),
+//    returns if any calls were inlined
+bool InlineFunctions(Module& module, Function& func);
+// Replaces constant subexpressions with literals, including builtin function calls with constant arguments
+void FoldConstants(Module& module, Function& func);
+Expr* FoldExpr(Module& module, Expr* expr); // Returns the folded expression, which may be the same node
+// Marks the locals that have constant initializers and are never modified as known constants, so folding replaces
+//    their uses, returns if any new constants were found
+bool PropagateConstants(Function& func);
+// Removes branches and loops with constant conditions that are never taken, unreachable statements after jumps, and
+//    the declarations of propagated constants, returns if anything changed
+bool EliminateDeadCode(Module& module, Function& func);
+// Replaces for loops that have a constant trip count with copies of their body, limited by the size of the result
+//    (which is larger for loops marked with [[unroll]]), returns if any loops were unrolled
+bool UnrollLoops(Module& module, Function& func);
+// Moves transposes in matrix-vector products to the other side and removes transposes that cancel out, and with fast
+//    math also reorders chains of matrix products applied to a vector into matrix-vector products and removes
+//    inverses that cancel out (these change the rounding)
+void ReassociateMatrices(Module& module, Function& func, const CompilerOptions& options);
+// Replaces small expression patterns with cheaper equivalents, such as identity operations, small constant powers,
+//    and division by constants (only the exact rewrites, unless fast math is enabled)
+void OptimizePeephole(Module& module, Function& func, const CompilerOptions& options);
+// Replaces if statements whose branches only assign cheap side-effect free values to the same variable with a single
+//    assignment of a ternary selection (skipping [[branch]] statements), returns if anything was converted
+bool ConvertSelects(Module& module, Function& func);
+// Moves the expressions in loops that have the same value in every iteration into temporaries declared before the
+//    loop, returns if anything was moved
+bool HoistLoopInvariants(Module& module, Function& func);
+// Replaces repeated expressions within each block with temporaries, as long as the variables they read are not written
+//    between the uses
+void EliminateCommonSubexprs(Module& module, Function& func);
+// Moves the largest fragment stage expressions that are exact under interpolation (affine in the interpolated locals,
+//    or only reading flat locals) to the end of the vertex stage, using at most the given number of local slots, and
+//    returns the new locals that pass the values between the stages
+std::vector<Symbol*> HoistToVertexStage(Module& module, uint32 free_slots);
+// Replaces the locals that the vertex stage always sets to the same constant with the constant in the fragment stage,
+//    and removes the locals that the fragment stage does not read (turning them into vertex stage variables if they
+//    are still used there), returns false if the stages are missing, otherwise fills the locals that are still passed
+bool LinkStages(Module& module, SymbolSet& passed);
+// Replaces the largest subexpressions in all stage functions that only read uniforms, push constants, and constants
+//    with new uniforms calculated by the preshader (added to the reflection info), limited by the block size, and
+//    returns the new uniform symbols in block order
+std::vector<Symbol*> ExtractPreshader(Module& module, ReflectionInfo& refl, uint32 size_limit);
+// Adds an atomic increment of a new counter to the start of each function, and each branch arm and loop body within
+//    them, records the source line of each counter in the reflection info, and returns the counter array symbol
+Symbol* InstrumentProfiling(Module& module, const std::vector<Function*>& funcs, ReflectionInfo& refl);
+
+} // namespace ir
+} // namespace hlsv
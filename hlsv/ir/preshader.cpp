@@ -0,0 +1,292 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file implements preshader.hpp, the evaluation rebuilds the expression and uses the constant evaluator, so the
+//    CPU results follow the same GLSL rules as constant folding
+
+#include "preshader.hpp"
+#include "../type/typehelper.hpp"
+#include <cstring>
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// ====================================================================================================================
+static inline void write16(std::vector<uint8>& code, uint32 val)
+{
+	code.push_back((uint8)(val & 0xFF));
+	code.push_back((uint8)((val >> 8) & 0xFF));
+}
+
+// ====================================================================================================================
+static inline void write32(std::vector<uint8>& code, uint32 val)
+{
+	write16(code, val & 0xFFFF);
+	write16(code, val >> 16);
+}
+
+// ====================================================================================================================
+// Encodes a reference to a uniform block member or push constant, with an optional constant array index
+static bool encode_load(const Symbol* sym, uint32 element, HLSVType type, const ReflectionInfo& refl,
+	std::vector<uint8>& code)
+{
+	const uint32 elsize = TypeHelper::GetValueTypeSize(type.type);
+	if (sym->scope == VarScope::Uniform) {
+		for (const auto& uni : refl.uniforms) {
+			if (uni.name != sym->name || !uni.type.is_value_type())
+				continue;
+			if (element >= (uni.type.is_array ? uni.type.count : 1u))
+				return false;
+			code.push_back((uint8)PreshaderOp::Uniform);
+			code.push_back((uint8)type.type);
+			code.push_back(uni.set);
+			code.push_back(uni.binding);
+			write16(code, uni.block.offset + element * elsize);
+			return true;
+		}
+	}
+	else if (sym->scope == VarScope::PushConstant) {
+		for (const auto& pc : refl.push_constants) {
+			if (pc.name != sym->name)
+				continue;
+			if (element >= (pc.type.is_array ? pc.type.count : 1u))
+				return false;
+			code.push_back((uint8)PreshaderOp::Push);
+			code.push_back((uint8)type.type);
+			write16(code, pc.offset + element * elsize);
+			return true;
+		}
+	}
+	return false;
+}
+
+// ====================================================================================================================
+bool EncodePreshader(const Expr* expr, const ReflectionInfo& refl, std::vector<uint8>& code)
+{
+	if (expr->type.is_array || !expr->type.is_value_type())
+		return false;
+
+	switch (expr->kind)
+	{
+	case ExprKind::Literal:
+	case ExprKind::Variable: {
+		if (expr->kind == ExprKind::Variable && expr->symbol->scope != VarScope::Constant)
+			return encode_load(expr->symbol, 0, expr->type, refl, code);
+		ConstValue val;
+		if (!EvaluateConstant(expr, val)) // Specialization constants are not known on the CPU
+			return false;
+		code.push_back((uint8)PreshaderOp::Const);
+		code.push_back((uint8)val.type);
+		for (uint32 i = 0; i < val.count(); ++i)
+			write32(code, val.comps[i].ui);
+		return true;
+	}
+	case ExprKind::Unary:
+		if (IsIncDecOp(expr->op))
+			return false;
+		code.push_back((uint8)PreshaderOp::Unary);
+		code.push_back((uint8)expr->type.type);
+		code.push_back((uint8)expr->op);
+		break;
+	case ExprKind::Binary:
+		code.push_back((uint8)PreshaderOp::Binary);
+		code.push_back((uint8)expr->type.type);
+		code.push_back((uint8)expr->op);
+		break;
+	case ExprKind::Ternary:
+		code.push_back((uint8)PreshaderOp::Ternary);
+		code.push_back((uint8)expr->type.type);
+		break;
+	case ExprKind::Index: {
+		auto base = expr->args[0];
+		if (base->type.is_array) { // Arrays are only supported as direct loads with constant indices
+			ConstValue idx;
+			if (!base->is_variable() || !EvaluateConstant(expr->args[1], idx))
+				return false;
+			if (idx.comp_type() == HLSVType::Int && idx.comps[0].si < 0)
+				return false;
+			return encode_load(base->symbol, idx.comps[0].ui, expr->type, refl, code);
+		}
+		code.push_back((uint8)PreshaderOp::Index);
+		code.push_back((uint8)expr->type.type);
+	} break;
+	case ExprKind::Swizzle:
+		code.push_back((uint8)PreshaderOp::Swizzle);
+		code.push_back((uint8)expr->type.type);
+		code.push_back(expr->swizzle_count);
+		code.insert(code.end(), expr->swizzle, expr->swizzle + expr->swizzle_count);
+		break;
+	case ExprKind::Construct:
+		code.push_back((uint8)PreshaderOp::Construct);
+		code.push_back((uint8)expr->type.type);
+		code.push_back((uint8)expr->arg_count);
+		break;
+	case ExprKind::Call: {
+		if (!IsEvaluableBuiltin(expr->out_name))
+			return false;
+		auto len = std::strlen(expr->out_name);
+		code.push_back((uint8)PreshaderOp::Call);
+		code.push_back((uint8)expr->type.type);
+		code.push_back((uint8)expr->arg_count);
+		code.push_back((uint8)len);
+		code.insert(code.end(), expr->out_name, expr->out_name + len);
+	} break;
+	default: return false;
+	}
+
+	for (uint32 i = 0; i < expr->arg_count; ++i) {
+		if (!EncodePreshader(expr->args[i], refl, code))
+			return false;
+	}
+	return true;
+}
+
+// Reads the bytecode back into expressions
+class PreshaderReader final
+{
+public:
+	Module& module;
+	const uint8* pc;
+	const uint8* end;
+	const ReflectionInfo& refl;
+	const void* const* block_data;
+	const void* push_data;
+
+	inline bool has(size_t count) const { return (size_t)(end - pc) >= count; }
+	inline uint32 read16() { uint32 v = pc[0] | (pc[1] << 8); pc += 2; return v; }
+	inline uint32 read32() { uint32 v = read16(); return v | (read16() << 16); }
+
+	// Creates a constant from the raw component values
+	Expr* make_value(HLSVType::PrimType type, const uint8* data) {
+		ConstValue val;
+		val.type = type;
+		for (uint32 i = 0; i < val.count(); ++i) {
+			std::memcpy(&val.comps[i], data + (i * 4), 4);
+			if (val.comp_type() == HLSVType::Bool)
+				val.comps[i].ui = (val.comps[i].ui != 0u) ? 1u : 0u;
+		}
+		return MakeConstantExpr(module, val, 0);
+	}
+
+	Expr* read() {
+		if (!has(2))
+			return nullptr;
+		auto op = (PreshaderOp)*(pc++);
+		auto type = (HLSVType::PrimType)*(pc++);
+		if (!HLSVType::IsValueType(type))
+			return nullptr;
+		const uint32 size = TypeHelper::GetValueTypeSize(type);
+
+		switch (op)
+		{
+		case PreshaderOp::Const: {
+			if (!has(size))
+				return nullptr;
+			auto expr = make_value(type, pc);
+			pc += size;
+			return expr;
+		}
+		case PreshaderOp::Uniform: {
+			if (!has(4))
+				return nullptr;
+			uint8 set = pc[0], binding = pc[1];
+			pc += 2;
+			uint32 offset = read16();
+			for (size_t i = 0; i < refl.blocks.size(); ++i) {
+				const auto& bl = refl.blocks[i];
+				if (bl.set == set && bl.binding == binding && block_data && block_data[i] && (offset + size) <= bl.size)
+					return make_value(type, (const uint8*)block_data[i] + offset);
+			}
+			return nullptr;
+		}
+		case PreshaderOp::Push: {
+			if (!has(2))
+				return nullptr;
+			uint32 offset = read16();
+			if (!push_data || (offset + size) > refl.push_constants_size)
+				return nullptr;
+			return make_value(type, (const uint8*)push_data + offset);
+		}
+		case PreshaderOp::Unary: {
+			if (!has(1))
+				return nullptr;
+			auto uop = (Op)*(pc++);
+			auto val = read();
+			return val ? module.new_unary(uop, val, type, 0) : nullptr;
+		}
+		case PreshaderOp::Binary: {
+			if (!has(1))
+				return nullptr;
+			auto bop = (Op)*(pc++);
+			auto left = read();
+			auto right = left ? read() : nullptr;
+			return right ? module.new_binary(bop, left, right, type, 0) : nullptr;
+		}
+		case PreshaderOp::Ternary: {
+			auto cond = read();
+			auto texpr = cond ? read() : nullptr;
+			auto fexpr = texpr ? read() : nullptr;
+			return fexpr ? module.new_ternary(cond, texpr, fexpr, type, 0) : nullptr;
+		}
+		case PreshaderOp::Index: {
+			auto val = read();
+			auto idx = val ? read() : nullptr;
+			return idx ? module.new_index(val, idx, type, 0) : nullptr;
+		}
+		case PreshaderOp::Swizzle: {
+			if (!has(1) || *pc > 4 || !has(1u + *pc))
+				return nullptr;
+			uint8 count = *(pc++);
+			const uint8* comps = pc;
+			pc += count;
+			auto val = read();
+			return val ? module.new_swizzle(val, comps, count, type, 0) : nullptr;
+		}
+		case PreshaderOp::Construct:
+		case PreshaderOp::Call: {
+			if (!has(1))
+				return nullptr;
+			uint32 argc = *(pc++);
+			string name{};
+			if (op == PreshaderOp::Call) {
+				if (!has(1) || !has(1u + *pc))
+					return nullptr;
+				uint32 len = *(pc++);
+				name.assign((const char*)pc, len);
+				pc += len;
+			}
+			std::vector<Expr*> args{};
+			for (uint32 i = 0; i < argc; ++i) {
+				auto arg = read();
+				if (!arg)
+					return nullptr;
+				args.push_back(arg);
+			}
+			return (op == PreshaderOp::Call) ? module.new_call(name, name, type, args, 0) :
+				module.new_construct(type, args, 0);
+		}
+		default: return nullptr;
+		}
+	}
+}; // class PreshaderReader
+
+// ====================================================================================================================
+bool EvaluatePreshader(const std::vector<uint8>& code, const ReflectionInfo& refl, const void* const* block_data,
+	const void* push_data, ConstValue& val)
+{
+	Module module{};
+	PreshaderReader reader{ module, code.data(), code.data() + code.size(), refl, block_data, push_data };
+	auto expr = reader.read();
+	return expr && (reader.pc == reader.end) && EvaluateConstant(expr, val);
+}
+
+} // namespace ir
+} // namespace hlsv
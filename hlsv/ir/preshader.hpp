@@ -0,0 +1,55 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the preshader bytecode, which stores uniform-only expressions so they can be calculated on the
+//    CPU when the uniform values are uploaded
+
+#pragma once
+
+#include "eval.hpp"
+
+
+namespace hlsv
+{
+namespace ir
+{
+
+// The bytecode node types, each node is stored in prefix order, with the operands following the node header:
+//    Const:     op, type, comps[count] (LE32)
+//    Uniform:   op, type, set, binding, offset (LE16)
+//    Push:      op, type, offset (LE16)
+//    Unary:     op, type, Op, operand
+//    Binary:    op, type, Op, left, right
+//    Ternary:   op, type, cond, texpr, fexpr
+//    Index:     op, type, value, index
+//    Swizzle:   op, type, count, comps[count], value
+//    Construct: op, type, argc, args[argc]
+//    Call:      op, type, argc, name length, name chars, args[argc]
+enum class PreshaderOp : uint8
+{
+	Const,
+	Uniform,
+	Push,
+	Unary,
+	Binary,
+	Ternary,
+	Index,
+	Swizzle,
+	Construct,
+	Call
+}; // enum class PreshaderOp
+
+// Appends the bytecode for the expression, returns false if the expression cannot be calculated by the preshader
+bool EncodePreshader(const Expr* expr, const ReflectionInfo& refl, std::vector<uint8>& code);
+// Calculates the value of the bytecode with the uniform values read from the block data (in the same order as
+//    refl.blocks) and push constant data, returns false if the code is invalid or the result is undefined in GLSL
+bool EvaluatePreshader(const std::vector<uint8>& code, const ReflectionInfo& refl, const void* const* block_data,
+	const void* push_data, ConstValue& val);
+
+} // namespace ir
+} // namespace hlsv
@@ -10,7 +10,9 @@
 
 #include "../config.hpp"
 #include "../type/typehelper.hpp"
+#include "../ir/preshader.hpp"
 #include <algorithm>
+#include <cstring>
 
 
 namespace hlsv
@@ -49,12 +51,20 @@ ReflectionInfo::ReflectionInfo(ShaderType type, uint32 tv, uint32 sv) :
 	stages{ ShaderStages::None },
 	attributes{ },
 	outputs{ },
+	locals{ },
 	uniforms{ },
 	blocks{ },
 	push_constants{ },
 	spec_constants{ },
 	push_constants_packed{ false },
-	push_constants_size{ 0 }
+	push_constants_size{ 0 },
+	preshader{ },
+	preshader_set{ 0 },
+	preshader_binding{ 0 },
+	perf_stats{ },
+	profile_counters{ },
+	profile_set{ 0 },
+	profile_binding{ 0 }
 {
 
 }
@@ -78,6 +88,11 @@ void ReflectionInfo::sort()
 		return l.location < r.location;
 	});
 
+	// Locals
+	std::sort(locals.begin(), locals.end(), [](const Local& l, const Local& r) {
+		return (l.location == r.location) ? l.component < r.component : l.location < r.location;
+	});
+
 	// Uniforms
 	std::sort(uniforms.begin(), uniforms.end(), [](const Uniform& l, const Uniform& r) {
 		return (l.set == r.set) ?
@@ -107,6 +122,11 @@ void ReflectionInfo::sort()
 	std::sort(push_constants.begin(), push_constants.end(), [](const PushConstant& l, const PushConstant& r) {
 		return l.offset < r.offset;
 	});
+
+	// Perf stats (in pipeline order)
+	std::sort(perf_stats.begin(), perf_stats.end(), [](const PerfStats& l, const PerfStats& r) {
+		return (uint8)l.stage < (uint8)r.stage;
+	});
 }
 
 // ====================================================================================================================
@@ -140,4 +160,57 @@ const Uniform* ReflectionInfo::get_subpass_input(uint32 index) const
 	return (it != uniforms.end()) ? &(*it) : nullptr;
 }
 
+// ====================================================================================================================
+bool ReflectionInfo::evaluate_preshader(const void* const* block_data, const void* push_data, void* preshader_data) const
+{
+	bool valid = true;
+	for (const auto& val : preshader) {
+		ir::ConstValue res;
+		uint8* dst = (uint8*)preshader_data + val.offset;
+		if (ir::EvaluatePreshader(val.code, *this, block_data, push_data, res))
+			std::memcpy(dst, res.comps, TypeHelper::GetValueTypeSize(val.type.type));
+		else {
+			std::memset(dst, 0, TypeHelper::GetValueTypeSize(val.type.type));
+			valid = false;
+		}
+	}
+	return valid;
+}
+
+// ====================================================================================================================
+std::vector<ProfileLine> ReflectionInfo::get_profile_report(const uint32* counter_data) const
+{
+	// Sum the counters that start on the same line in the same stages
+	std::vector<ProfileLine> lines{ };
+	for (size_t i = 0; i < profile_counters.size(); ++i) {
+		const auto& pc = profile_counters[i];
+		if (counter_data[i] == 0)
+			continue;
+		auto it = std::find_if(lines.begin(), lines.end(), [&pc](const ProfileLine& pl) {
+			return pl.line == pc.line && pl.stage == pc.stage;
+		});
+		if (it == lines.end())
+			it = lines.insert(lines.end(), ProfileLine{ pc.line, pc.stage });
+		it->count += counter_data[i];
+	}
+
+	std::stable_sort(lines.begin(), lines.end(), [](const ProfileLine& l, const ProfileLine& r) {
+		return (l.count > r.count) || ((l.count == r.count) && (l.line < r.line));
+	});
+	return lines;
+}
+
+// ====================================================================================================================
+/* static */
+bool ReflectionInfo::CheckBinaryHeader(const void* data, size_t size)
+{
+	// Magic number, then the tool version as three digit bytes
+	if (!data || size < 7)
+		return false;
+	auto bytes = reinterpret_cast<const uint8*>(data);
+	if (std::memcmp(bytes, "HLSV", 4) != 0)
+		return false;
+	return (bytes[4] == HLSV_VERSION_MAJOR) && (bytes[5] == HLSV_VERSION_MINOR) && (bytes[6] == HLSV_VERSION_PATCH);
+}
+
 } // namespace hlsv
@@ -52,6 +52,19 @@ static string spec_const_value_str(const SpecConstant& sc)
 	return "ERROR";
 }
 
+// ====================================================================================================================
+// Single letter per stage, in pipeline order
+static string stages_str(ShaderStages stages)
+{
+	string str{ };
+	if (stages & ShaderStages::Vertex) str += 'V';
+	if (stages & ShaderStages::TessControl) str += 'C';
+	if (stages & ShaderStages::TessEval) str += 'E';
+	if (stages & ShaderStages::Geometry) str += 'G';
+	if (stages & ShaderStages::Fragment) str += 'F';
+	return str.empty() ? "-" : str;
+}
+
 // ====================================================================================================================
 /* static */
 bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, string& err)
@@ -82,11 +95,12 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 		 << "----------" << std::endl;
 	if (refl.attributes.size() > 0) {
 		file << pad("Name", 16) << ' ' << pad("Type", 16) << ' ' << pad("Array", 10) << ' '  << pad("Count", 10) << ' '
-			 << pad("Location", 10) << ' ' << pad("Slots", 10) << std::endl;
+			 << pad("Location", 10) << ' ' << pad("Slots", 10) << ' ' << pad("Used", 8) << std::endl;
 		for (const auto& attr : refl.attributes) {
 			file << pad(attr.name, 16) << ' ' << pad(attr.type.get_type_str(), 16) << ' ' 
 				 << pad(attr.type.is_array ? "Yes" : "No", 10) << ' ' << padf("%u", 10, (uint32)attr.type.count) << ' '
-				 << padf("%u", 10, (uint32)attr.location) << ' ' << padf("%u", 10, (uint32)attr.slot_count) << std::endl;
+				 << padf("%u", 10, (uint32)attr.location) << ' ' << padf("%u", 10, (uint32)attr.slot_count) << ' '
+				 << pad(attr.used ? "Yes" : "No", 8) << std::endl;
 		}
 		file << std::endl;
 	}
@@ -107,13 +121,28 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 	else
 		file << "None" << std::endl << std::endl;
 
+	// Write locals
+	file << "Locals" << std::endl
+		 << "------" << std::endl;
+	if (refl.locals.size() > 0) {
+		file << pad("Name", 16) << ' ' << pad("Type", 16) << ' ' << pad("Location", 10) << ' ' << pad("Component", 10) << ' '
+			 << pad("Flat", 8) << std::endl;
+		for (const auto& loc : refl.locals) {
+			file << pad(loc.name, 16) << ' ' << pad(loc.type.get_type_str(), 16) << ' ' << padf("%u", 10, (uint32)loc.location)
+				 << ' ' << padf("%u", 10, (uint32)loc.component) << ' ' << pad(loc.flat ? "Yes" : "No", 8) << std::endl;
+		}
+		file << std::endl;
+	}
+	else
+		file << "None" << std::endl << std::endl;
+
 	// Uniforms
 	file << "Uniforms" << std::endl
 		 << "--------" << std::endl;
 	if (refl.uniforms.size() > 0) {
 		file << pad("Name", 16) << ' ' << pad("Type", 16) << ' ' << pad("Type Arg.", 12) << ' ' << pad("Array", 10) << ' '
 			 << pad("Set", 8) << ' ' << pad("Binding", 8) << ' ' << pad("Block", 8) << ' ' << pad("Offset", 8) << ' '
-			 << pad("Count", 8) << ' ' << pad("Size", 8) << std::endl;
+			 << pad("Count", 8) << ' ' << pad("Size", 8) << ' ' << pad("Stages", 8) << std::endl;
 		for (const auto& uni : refl.uniforms) {
 			file << pad(uni.name, 16) << ' ' << pad(uni.type.get_type_str(), 16) << ' ';
 			if (uni.type.is_image_type()) file << pad(HLSVType::GetTypeStr(uni.type.extra.image_format), 12);
@@ -123,10 +152,10 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 				 << padf("%u", 8, (uint32)uni.binding);
 			if (uni.type.is_value_type()) {
 				file << ' ' << padf("%u", 8, (uint32)uni.block.index) << ' ' << padf("%u", 8, (uint32)uni.block.offset)
-					 << ' ' << padf("%u", 8, (uint32)uni.type.count) << ' ' << padf("%u", 8, (uint32)uni.block.size)
-					 << std::endl;
+					 << ' ' << padf("%u", 8, (uint32)uni.type.count) << ' ' << padf("%u", 8, (uint32)uni.block.size);
 			}
-			else file << std::endl;
+			else file << ' ' << pad("", 8) << ' ' << pad("", 8) << ' ' << pad("", 8) << ' ' << pad("", 8);
+			file << ' ' << pad(stages_str(uni.stage_mask), 8) << std::endl;
 		}
 		file << std::endl;
 	}
@@ -138,11 +167,11 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 		 << "--------------" << std::endl;
 	if (refl.blocks.size() > 0) {
 		file << pad("Set", 8) << ' ' << pad("Binding", 8) << ' ' << pad("Members", 8) << ' ' << pad("Packed", 8) << ' ' 
-			 << pad("Size", 8) << std::endl;
+			 << pad("Size", 8) << ' ' << pad("Stages", 8) << std::endl;
 		for (const auto& bl : refl.blocks) {
 			file << padf("%u", 8, (uint32)bl.set) << ' ' << padf("%u", 8, (uint32)bl.binding) << ' '
 				 << padf("%u", 8, (uint32)bl.members.size()) << ' ' << pad(bl.packed ? "Yes" : "No", 8) << ' '
-				 << padf("%u", 8, (uint32)bl.size) << std::endl;
+				 << padf("%u", 8, (uint32)bl.size) << ' ' << pad(stages_str(bl.stage_mask), 8) << std::endl;
 		}
 		file << std::endl;
 	}
@@ -154,11 +183,11 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 		 << "--------------" << std::endl;
 	if (refl.push_constants.size() > 0) {
 		file << pad("Name", 16) << ' ' << pad("Type", 12) << ' ' << pad("Array", 8) << ' ' << pad("Count", 8) << ' '
-			 << pad("Offset", 8) << ' ' << pad("Size", 8) << std::endl;
+			 << pad("Offset", 8) << ' ' << pad("Size", 8) << ' ' << pad("Stages", 8) << std::endl;
 		for (const auto& pc : refl.push_constants) {
 			file << pad(pc.name, 16) << ' ' << pad(pc.type.get_type_str(), 12) << ' ' << pad(pc.type.is_array ? "Yes" : "No", 8)
 				 << ' ' << padf("%u", 8, (uint32)pc.type.count) << ' ' << padf("%u", 8, (uint32)pc.offset) << ' '
-				 << padf("%u", 8, (uint32)pc.size) << std::endl;
+				 << padf("%u", 8, (uint32)pc.size) << ' ' << pad(stages_str(pc.stage_mask), 8) << std::endl;
 		}
 		file << std::endl;
 	}
@@ -170,10 +199,62 @@ bool ReflWriter::WriteText(const string& path, const ReflectionInfo& refl, strin
 		 << "---------------" << std::endl;
 	if (refl.spec_constants.size() > 0) {
 		file << pad("Name", 16) << ' ' << pad("Type", 12) << ' ' << pad("Index", 8) << ' ' << pad("Size", 8) << ' '
-			 << pad("Value", 20) << std::endl;
+			 << pad("Value", 20) << ' ' << pad("Stages", 8) << std::endl;
 		for (const auto& sc : refl.spec_constants) {
 			file << pad(sc.name, 16) << ' ' << pad(sc.type.get_type_str(), 12) << ' ' << padf("%u", 8, (uint32)sc.index) 
-				 << ' ' << padf("%u", 8, (uint32)sc.size) << ' ' << pad(spec_const_value_str(sc), 20) << std::endl;
+				 << ' ' << padf("%u", 8, (uint32)sc.size) << ' ' << pad(spec_const_value_str(sc), 20) << ' '
+				 << pad(stages_str(sc.stage_mask), 8) << std::endl;
+		}
+		file << std::endl;
+	}
+	else
+		file << "None" << std::endl << std::endl;
+
+	// Preshader
+	file << "Preshader" << std::endl
+		 << "---------" << std::endl;
+	if (refl.preshader.size() > 0) {
+		file << "Set: " << (uint32)refl.preshader_set << ", Binding: " << (uint32)refl.preshader_binding << std::endl;
+		file << pad("Offset", 8) << ' ' << pad("Type", 12) << ' ' << pad("Code Size", 10) << std::endl;
+		for (const auto& val : refl.preshader) {
+			file << padf("%u", 8, (uint32)val.offset) << ' ' << pad(val.type.get_type_str(), 12) << ' '
+				 << padf("%u", 10, (uint32)val.code.size()) << std::endl;
+		}
+		file << std::endl;
+	}
+	else
+		file << "None" << std::endl << std::endl;
+
+	// Perf stats
+	file << "Perf Stats" << std::endl
+		 << "----------" << std::endl;
+	if (refl.perf_stats.size() > 0) {
+		file << pad("Stage", 8) << ' ' << pad("Total", 8) << ' ' << pad("ALU", 8) << ' ' << pad("Samples", 8) << ' '
+			 << pad("Fetches", 8) << ' ' << pad("Img Load", 8) << ' ' << pad("Img Store", 9) << ' ' << pad("Dyn Index", 9)
+			 << ' ' << pad("Dyn Loops", 9) << ' ' << pad("Discard", 8) << ' ' << pad("Varyings", 8) << std::endl;
+		for (const auto& ps : refl.perf_stats) {
+			file << pad(stages_str(ps.stage), 8) << ' ' << padf("%u", 8, ps.get_total_cost()) << ' '
+				 << padf("%u", 8, ps.alu_cost) << ' ' << padf("%u", 8, ps.texture_samples) << ' '
+				 << padf("%u", 8, ps.texture_fetches) << ' ' << padf("%u", 8, ps.image_loads) << ' '
+				 << padf("%u", 9, ps.image_stores) << ' ' << padf("%u", 9, ps.dynamic_indexing) << ' '
+				 << padf("%u", 9, ps.dynamic_loops) << ' ' << pad(ps.uses_discard ? "Yes" : "No", 8) << ' '
+				 << padf("%u", 8, (uint32)ps.varying_bytes) << std::endl;
+		}
+		file << std::endl;
+	}
+	else
+		file << "None" << std::endl << std::endl;
+
+	// Profile counters
+	file << "Profile Counters" << std::endl
+		 << "----------------" << std::endl;
+	if (refl.profile_counters.size() > 0) {
+		file << "Set: " << (uint32)refl.profile_set << ", Binding: " << (uint32)refl.profile_binding << std::endl;
+		file << pad("Index", 8) << ' ' << pad("Line", 8) << ' ' << pad("Stages", 8) << std::endl;
+		for (size_t i = 0; i < refl.profile_counters.size(); ++i) {
+			const auto& pc = refl.profile_counters[i];
+			file << padf("%u", 8, (uint32)i) << ' ' << padf("%u", 8, pc.line) << ' ' << pad(stages_str(pc.stage), 8)
+				 << std::endl;
 		}
 		file << std::endl;
 	}
@@ -209,7 +290,7 @@ bool ReflWriter::WriteBinary(const string& path, const ReflectionInfo& refl, str
 	if (refl.attributes.size() > 0) {
 		for (const auto& attr : refl.attributes) {
 			write_str(file, attr.name) << (uint8)attr.type.type << (uint8)(attr.type.is_array ? attr.type.count : 0)
-				<< attr.location << attr.slot_count;
+				<< attr.location << attr.slot_count << (uint8)(attr.used ? 1 : 0);
 		}
 	}
 
@@ -221,13 +302,22 @@ bool ReflWriter::WriteBinary(const string& path, const ReflectionInfo& refl, str
 		}
 	}
 
+	// Write locals
+	file << (uint8)refl.locals.size();
+	if (refl.locals.size() > 0) {
+		for (const auto& loc : refl.locals) {
+			write_str(file, loc.name) << (uint8)loc.type.type << (uint8)(loc.type.is_array ? loc.type.count : 0)
+				<< loc.location << loc.component << (uint8)(loc.flat ? 1 : 0);
+		}
+	}
+
 	// Write uniforms
 	file << (uint8)refl.uniforms.size();
 	if (refl.uniforms.size() > 0) {
 		for (const auto& uni : refl.uniforms) {
 			write_str(file, uni.name) << (uint8)uni.type.type << (uint8)uni.type.extra.image_format // Writes whatever extra information there is
 				<< (uint8)(uni.type.is_array ? uni.type.count : 0) << uni.set << uni.binding << uni.block.index
-				<< WRITE_LE16(uni.block.offset) << WRITE_LE16(uni.block.size);
+				<< WRITE_LE16(uni.block.offset) << WRITE_LE16(uni.block.size) << (uint8)uni.stage_mask;
 		}
 	}
 
@@ -235,7 +325,7 @@ bool ReflWriter::WriteBinary(const string& path, const ReflectionInfo& refl, str
 	file << (uint8)refl.blocks.size();
 	if (refl.blocks.size() > 0) {
 		for (const auto& bl : refl.blocks) {
-			file << bl.set << bl.binding << WRITE_LE16(bl.size) << (uint8)(bl.packed ? 1 : 0);
+			file << bl.set << bl.binding << WRITE_LE16(bl.size) << (uint8)(bl.packed ? 1 : 0) << (uint8)bl.stage_mask;
 			file << (uint8)bl.members.size();
 			for (auto mi : bl.members) {
 				file << mi;
@@ -248,7 +338,7 @@ bool ReflWriter::WriteBinary(const string& path, const ReflectionInfo& refl, str
 	if (refl.push_constants.size() > 0) {
 		for (const auto& pc : refl.push_constants) {
 			write_str(file, pc.name) << (uint8)pc.type.type << (uint8)(pc.type.is_array ? pc.type.count : 0)
-				<< WRITE_LE16(pc.offset) << WRITE_LE16(pc.size);
+				<< WRITE_LE16(pc.offset) << WRITE_LE16(pc.size) << (uint8)pc.stage_mask;
 		}
 	}
 
@@ -256,10 +346,40 @@ bool ReflWriter::WriteBinary(const string& path, const ReflectionInfo& refl, str
 	file << (uint8)refl.spec_constants.size();
 	if (refl.spec_constants.size() > 0) {
 		for (const auto& sc : refl.spec_constants) {
-			write_str(file, sc.name) << (uint8)sc.type.type << (uint8)sc.index << (uint8)sc.size << WRITE_LE32(sc.default_value.ui);
+			write_str(file, sc.name) << (uint8)sc.type.type << (uint8)sc.index << (uint8)sc.size << WRITE_LE32(sc.default_value.ui)
+				<< (uint8)sc.stage_mask;
+		}
+	}
+
+	// Write preshader
+	file << (uint8)refl.preshader.size();
+	if (refl.preshader.size() > 0) {
+		file << refl.preshader_set << refl.preshader_binding;
+		for (const auto& val : refl.preshader) {
+			file << (uint8)val.type.type << WRITE_LE16(val.offset) << WRITE_LE16(val.code.size());
+			file.write((const char*)val.code.data(), val.code.size());
 		}
 	}
 
+	// Write perf stats
+	file << (uint8)refl.perf_stats.size();
+	if (refl.perf_stats.size() > 0) {
+		for (const auto& ps : refl.perf_stats) {
+			file << (uint8)ps.stage << WRITE_LE32(ps.alu_cost) << WRITE_LE32(ps.texture_samples)
+				<< WRITE_LE32(ps.texture_fetches) << WRITE_LE32(ps.image_loads) << WRITE_LE32(ps.image_stores)
+				<< WRITE_LE32(ps.dynamic_indexing) << WRITE_LE32(ps.dynamic_loops) << (uint8)(ps.uses_discard ? 1 : 0)
+				<< WRITE_LE16(ps.varying_bytes);
+		}
+	}
+
+	// Write profile counters
+	file << WRITE_LE32(refl.profile_counters.size());
+	if (refl.profile_counters.size() > 0) {
+		file << refl.profile_set << refl.profile_binding;
+		for (const auto& pc : refl.profile_counters)
+			file << WRITE_LE32(pc.line) << (uint8)pc.stage;
+	}
+
 	// Close and return
 	file.flush();
 	file.close();
@@ -10,16 +10,11 @@
 
 #include "functions.hpp"
 #include "typehelper.hpp"
-#include <stdexcept>
 
 
 namespace hlsv
 {
 
-// ====================================================================================================================
-bool FunctionRegistry::Populated_ = false;
-std::map<string, std::vector<FunctionEntry>> FunctionRegistry::Functions_{ };
-
 // ====================================================================================================================
 bool FunctionParam::matches(HLSVType typ) const
 {
@@ -60,7 +55,7 @@ HLSVType FunctionParam::as_return_type(HLSVType rtype, HLSVType atype) const
 // ====================================================================================================================
 bool FunctionEntry::matches(const std::vector<HLSVType>& args, HLSVType& rtype) const
 {
-	if (args.size() != params.size())
+	if (args.size() != param_count)
 		return false;
 
 	// Check the types one at a time
@@ -86,48 +81,77 @@ bool FunctionEntry::matches(const std::vector<HLSVType>& args, HLSVType& rtype)
 /* static */
 bool FunctionRegistry::CheckFunction(const string& name, const std::vector<HLSVType>& args, string& err, HLSVType& ret, string& outname)
 {
-	if (!Populated_)
-		Populate();
-
-	try {
-		const auto& ents = Functions_.at(name);
-		for (const auto& e : ents) {
-			if (e.matches(args, ret)) {
-				outname = e.out_name;
-				return true;
-			}
-		}
-		err = strarg("No argument list for the function '%s' matches the given arguments.", name.c_str());
+	uint32 count;
+	auto ents = FindEntries(name, &count);
+	if (!ents) {
+		err = strarg("The function '%s' does not exist in the current context.", name.c_str());
 		return false;
 	}
-	catch (std::out_of_range&) {
+
+	for (uint32 i = 0; i < count; ++i) {
+		if (ents[i].matches(args, ret)) {
+			outname = ents[i].out_name;
+			return true;
+		}
+	}
+	err = strarg("No argument list for the function '%s' matches the given arguments.", name.c_str());
+	return false;
+}
+
+// ====================================================================================================================
+/* static */
+bool FunctionRegistry::CheckFunction(const string& name, const std::vector<Expr*>& args, string& err, HLSVType& ret, string& outname)
+{
+	uint32 count;
+	auto ents = FindEntries(name, &count);
+	if (!ents) {
 		err = strarg("The function '%s' does not exist in the current context.", name.c_str());
 		return false;
 	}
+
+	for (uint32 i = 0; i < count; ++i) {
+		if (ents[i].matches(args, ret)) {
+			outname = ents[i].out_name;
+			return true;
+		}
+	}
+	err = strarg("No argument list for the function '%s' matches the given arguments.", name.c_str());
+	return false;
 }
 
 // ====================================================================================================================
 /* static */
-bool FunctionRegistry::CheckFunction(const string& name, const std::vector<Expr*>& args, string& err, HLSVType& ret, string& outname)
+bool FunctionRegistry::CheckUserFunction(const std::vector<FunctionEntry>& funcs, const string& name,
+	const std::vector<Expr*>& args, string& err, HLSVType& ret, uint32& index)
 {
-	if (!Populated_)
-		Populate();
-
-	try {
-		const auto& ents = Functions_.at(name);
-		for (const auto& e : ents) {
-			if (e.matches(args, ret)) {
-				outname = e.out_name;
-				return true;
-			}
+	bool found = false;
+	for (uint32 i = 0; i < funcs.size(); ++i) { // Exact matches first, so promotion does not pick another overload
+		const auto& ent = funcs[i];
+		if (name != ent.name)
+			continue;
+		found = true;
+		if (ent.param_count != args.size())
+			continue;
+		bool exact = true;
+		for (uint32 p = 0; exact && (p < ent.param_count); ++p)
+			exact = (args[p]->type == ent.params[p].type);
+		if (exact) {
+			ret = ent.return_type;
+			index = i;
+			return true;
 		}
-		err = strarg("No argument list for the function '%s' matches the given arguments.", name.c_str());
-		return false;
 	}
-	catch (std::out_of_range&) {
-		err = strarg("The function '%s' does not exist in the current context.", name.c_str());
+	if (!found)
 		return false;
+
+	for (uint32 i = 0; i < funcs.size(); ++i) {
+		if (name == funcs[i].name && funcs[i].matches(args, ret)) {
+			index = i;
+			return true;
+		}
 	}
+	err = strarg("No argument list for the function '%s' matches the given arguments.", name.c_str());
+	return false;
 }
 
 // ====================================================================================================================
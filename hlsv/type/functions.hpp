@@ -14,7 +14,7 @@
 #include "../config.hpp"
 #include "../visitor/expr.hpp"
 #include <algorithm>
-#include <map>
+#include <initializer_list>
 
 
 namespace hlsv
@@ -28,13 +28,13 @@ public:
 	bool gen_type;
 	bool exact;
 
-	FunctionParam() :
+	constexpr FunctionParam() :
 		type{ HLSVType::Error }, gen_type{ false }, exact{ false }
 	{ }
-	FunctionParam(HLSVType type, bool gt = true, bool exact = false) :
+	constexpr FunctionParam(HLSVType type, bool gt = true, bool exact = false) :
 		type{ type }, gen_type{ gt && (type.is_scalar_type() || type.is_image_type()) }, exact{ exact }
 	{ }
-	FunctionParam(HLSVType::PrimType type, bool gt = true, bool exact = false) :
+	constexpr FunctionParam(HLSVType::PrimType type, bool gt = true, bool exact = false) :
 		type{ type }, gen_type{ gt && (HLSVType::IsScalarType(type) || HLSVType::IsImageType(type)) }, exact{ exact }
 	{ }
 
@@ -43,33 +43,45 @@ public:
 };
 
 // Contains a single set of arguments that are valid for a function, and a way to check a given set against them
+// Entries are literal types so the builtin function table can be built at compile time
 struct FunctionEntry final
 {
 public:
+	static constexpr uint32 MAX_PARAMS = 8;
+
+	const char* name;       // The HLSV name of the function
+	const char* out_name;   // The GLSL name of the function
 	uint32 version;         // The minimum shader version that the function is available in
-	string out_name;
 	HLSVType return_type;
-	std::vector<FunctionParam> params;
+	FunctionParam params[MAX_PARAMS];
+	uint32 param_count;
 	uint32 gen_idx; // Deduces the return type from the gen_type param at this index
 
-	FunctionEntry() : 
-		version{ 0 }, out_name{ "" }, return_type{ HLSVType::Error }, params{ }, gen_idx{ UINT32_MAX }
-	{ }
-	FunctionEntry(const string& name, uint32 genidx, const std::initializer_list<FunctionParam>& pars, uint32 v = 100) :
-		version{ v }, out_name{ name }, return_type{ HLSVType::Error }, params{ pars }, gen_idx{ genidx }
-	{ }
-	FunctionEntry(const string& name, uint32 genidx, const std::initializer_list<FunctionParam>& pars, HLSVType rt, uint32 v = 100) :
-		version{ v }, out_name{ name }, return_type{ rt }, params{ pars }, gen_idx{ genidx }
-	{ }
-	FunctionEntry(const string& name, uint32 genidx, const std::initializer_list<FunctionParam>& pars, HLSVType::PrimType rt, uint32 v = 100) :
-		version{ v }, out_name{ name }, return_type{ rt }, params{ pars }, gen_idx{ genidx }
-	{ }
-	FunctionEntry(const string& name, HLSVType rt, const std::initializer_list<FunctionParam>& pars, uint32 v = 100) :
-		version{ v }, out_name{ name }, return_type{ rt }, params{ pars }, gen_idx{ UINT32_MAX }
-	{ }
-	FunctionEntry(const string& name, HLSVType::PrimType rt, const std::initializer_list<FunctionParam>& pars, uint32 v = 100) :
-		version{ v }, out_name{ name }, return_type{ rt }, params{ pars }, gen_idx{ UINT32_MAX }
-	{ }
+	constexpr FunctionEntry(const char* n, const char* on, uint32 genidx, std::initializer_list<FunctionParam> pars, uint32 v = 100) :
+		name{ n }, out_name{ on }, version{ v }, return_type{ HLSVType::Error }, params{ }, param_count{ 0 }, gen_idx{ genidx }
+	{
+		for (const auto& p : pars) params[param_count++] = p;
+	}
+	constexpr FunctionEntry(const char* n, const char* on, uint32 genidx, std::initializer_list<FunctionParam> pars, HLSVType rt, uint32 v = 100) :
+		name{ n }, out_name{ on }, version{ v }, return_type{ rt }, params{ }, param_count{ 0 }, gen_idx{ genidx }
+	{
+		for (const auto& p : pars) params[param_count++] = p;
+	}
+	constexpr FunctionEntry(const char* n, const char* on, uint32 genidx, std::initializer_list<FunctionParam> pars, HLSVType::PrimType rt, uint32 v = 100) :
+		name{ n }, out_name{ on }, version{ v }, return_type{ rt }, params{ }, param_count{ 0 }, gen_idx{ genidx }
+	{
+		for (const auto& p : pars) params[param_count++] = p;
+	}
+	constexpr FunctionEntry(const char* n, const char* on, HLSVType rt, std::initializer_list<FunctionParam> pars, uint32 v = 100) :
+		name{ n }, out_name{ on }, version{ v }, return_type{ rt }, params{ }, param_count{ 0 }, gen_idx{ UINT32_MAX }
+	{
+		for (const auto& p : pars) params[param_count++] = p;
+	}
+	constexpr FunctionEntry(const char* n, const char* on, HLSVType::PrimType rt, std::initializer_list<FunctionParam> pars, uint32 v = 100) :
+		name{ n }, out_name{ on }, version{ v }, return_type{ rt }, params{ }, param_count{ 0 }, gen_idx{ UINT32_MAX }
+	{
+		for (const auto& p : pars) params[param_count++] = p;
+	}
 
 	bool matches(const std::vector<HLSVType>& args, HLSVType& rtype) const;
 	inline bool matches(const std::vector<Expr*>& args, HLSVType& rtype) const {
@@ -81,22 +93,27 @@ public:
 
 class FunctionRegistry final
 {
-private:
-	static bool Populated_;
-	static std::map<string, std::vector<FunctionEntry>> Functions_;
-
 public:
 	static bool CheckFunction(const string& name, const std::vector<HLSVType>& args, string& err, HLSVType& ret, string& outname);
 	static bool CheckFunction(const string& name, const std::vector<Expr*>& args, string& err, HLSVType& ret, string& outname);
+	// Checks against the user function overloads, preferring exact matches, and gets the index of the matching entry,
+	//    returns false without an error if there is no user function with the name
+	static bool CheckUserFunction(const std::vector<FunctionEntry>& funcs, const string& name,
+		const std::vector<Expr*>& args, string& err, HLSVType& ret, uint32& index);
 	static bool CheckConstructor(HLSVType::PrimType type, const std::vector<HLSVType>& args, string& err);
 	inline static bool CheckConstructor(HLSVType::PrimType type, const std::vector<Expr*>& args, string& err) {
 		std::vector<HLSVType> atyp{ args.size(), HLSVType::Error };
 		std::transform(args.begin(), args.end(), atyp.data(), [](Expr* e) { return e->type; });
 		return CheckConstructor(type, atyp, err);
 	}
+	inline static bool IsBuiltinFunction(const string& name) {
+		uint32 count;
+		return FindEntries(name, &count) != nullptr;
+	}
 
 private:
-	static void Populate();
+	// Returns the first builtin entry with the name, and the number of adjacent overloads in count
+	static const FunctionEntry* FindEntries(const string& name, uint32* count);
 }; // class FunctionRegistry
 
 } // namespace hlsv
@@ -15,7 +15,25 @@ namespace hlsv
 {
 
 // ====================================================================================================================
-std::map<string, string> Variable::BuiltinNames_ = {};
+// Maps the builtin variable names (without the '$') to their GLSL names, per shader type
+struct BuiltinName final
+{
+	ShaderType type;
+	const char* name;
+	const char* glsl;
+};
+static constexpr BuiltinName BUILTIN_NAMES[] = {
+	{ ShaderType::Graphics, "VertexIndex", "gl_VertexIndex" },
+	{ ShaderType::Graphics, "InstanceIndex", "gl_InstanceIndex" },
+	{ ShaderType::Graphics, "Position", "gl_Position" },
+	{ ShaderType::Graphics, "PointSize", "gl_PointSize" },
+	{ ShaderType::Graphics, "FragCoord", "gl_FragCoord" },
+	{ ShaderType::Graphics, "FrontFacing", "gl_FrontFacing" },
+	{ ShaderType::Graphics, "PointCoord", "gl_PointCoord" },
+	{ ShaderType::Graphics, "FragDepth", "gl_FragDepth" }
+};
+
+// ====================================================================================================================
 ShaderType Variable::LoadedNames_ = (ShaderType)0xFF;
 
 // ====================================================================================================================
@@ -25,7 +43,8 @@ Variable::Variable(const string& name, HLSVType type, VarScope scope) :
 	scope{ scope },
 	constant{ false, 0 },
 	read{ GetDefaultReadStages(scope) },
-	write{ GetDefaultWriteStages(scope) }
+	write{ GetDefaultWriteStages(scope) },
+	symbol{ nullptr }
 {
 	
 }
@@ -37,7 +56,8 @@ Variable::Variable(const string& name, HLSVType type, VarScope scope, ShaderStag
 	scope{ scope },
 	constant{ false, 0 },
 	read{ read },
-	write{ write }
+	write{ write },
+	symbol{ nullptr }
 {
 
 }
@@ -78,23 +98,7 @@ ShaderStages Variable::GetDefaultWriteStages(VarScope scope)
 /* static */
 void Variable::LoadNames(ShaderType type)
 {
-	if (LoadedNames_ == type)
-		return;
-	BuiltinNames_.clear();
 	LoadedNames_ = type;
-
-	if (type == ShaderType::Graphics) {
-		BuiltinNames_.insert({
-			{ "VertexIndex", "gl_VertexIndex" },
-			{ "InstanceIndex", "gl_InstanceIndex" },
-			{ "Position", "gl_Position" },
-			{ "PointSize", "gl_PointSize" },
-			{ "FragCoord", "gl_FragCoord" },
-			{ "FrontFacing", "gl_FrontFacing" },
-			{ "PointCoord", "gl_PointCoord" },
-			{ "FragDepth", "gl_FragDepth" }
-		});
-	}
 }
 
 // ====================================================================================================================
@@ -102,8 +106,11 @@ void Variable::LoadNames(ShaderType type)
 string Variable::GetOutputName(const string& name)
 {
 	if (name[0] == '$') {
-		auto it = BuiltinNames_.find(name.substr(1));
-		return (it != BuiltinNames_.end()) ? it->second : "NAME_ERROR";
+		for (const auto& bn : BUILTIN_NAMES) {
+			if (bn.type == LoadedNames_ && name.compare(1, string::npos, bn.name) == 0)
+				return bn.glsl;
+		}
+		return "NAME_ERROR";
 	}
 	else
 		return name;
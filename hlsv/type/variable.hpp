@@ -12,13 +12,13 @@
 
 #include "../config.hpp"
 #include "typehelper.hpp"
-#include "../../generated/HLSV.h"
-#include <map>
 
 
 namespace hlsv
 {
 
+namespace ir { struct Symbol; }
+
 // The different scopes the variables can have
 enum class VarScope : uint8
 {
@@ -36,7 +36,6 @@ enum class VarScope : uint8
 class Variable final
 {
 private:
-	static std::map<string, string> BuiltinNames_;
 	static ShaderType LoadedNames_;
 
 public:
@@ -57,6 +56,7 @@ public:
 	};
 	ShaderStages read;
 	ShaderStages write;
+	ir::Symbol* symbol; // The IR symbol for the variable, created when the variable is first used
 
 public:
 	Variable(const string& name, HLSVType type, VarScope scope);
@@ -16,6 +16,8 @@
 namespace hlsv
 {
 
+namespace ir { struct Expr; }
+
 // Contains information about an rvalue expresssion in a source tree
 class Expr final
 {
@@ -29,30 +31,30 @@ public:
 		int32 si;
 		uint32 ui;
 	} literal_value; // This must exactly match the "default_value" union in the SpecConstant type
-	string text; // The text used to refer to the expression value
+	ir::Expr* node; // The IR node for the expression
 
 public:
 	Expr() : Expr(HLSVType::Error) { }
 	explicit Expr(HLSVType type) :
 		type{ type }, is_literal{ false }, is_compile_constant{ false }, literal_value{ 0u },
-		text{ "" }
+		node{ nullptr }
 	{ }
 	Expr(const Expr& o) :
 		type{ o.type }, is_literal{ o.is_literal }, is_compile_constant{ o.is_compile_constant },
-		literal_value{ o.literal_value }, text{ o.text }
+		literal_value{ o.literal_value }, node{ o.node }
 	{ }
 
 	inline void set_literal_value(bool b) {
-		is_literal = true; literal_value.ui = b ? 1u : 0u; text = b ? "true" : "false";
+		is_literal = true; literal_value.ui = b ? 1u : 0u;
 	}
 	inline void set_literal_value(float f) {
-		is_literal = true; literal_value.f = f; text = strarg("%f", f);
+		is_literal = true; literal_value.f = f;
 	}
 	inline void set_literal_value(int32 i) {
-		is_literal = true; literal_value.si = i; text = strarg("%d", i);
+		is_literal = true; literal_value.si = i;
 	}
 	inline void set_literal_value(uint32 i) {
-		is_literal = true; literal_value.ui = i; text = strarg("%u", i);
+		is_literal = true; literal_value.ui = i;
 	}
 }; // class Expr
 
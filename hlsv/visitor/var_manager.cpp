@@ -9,12 +9,35 @@
 // This file implements manager.hpp
 
 #include "var_manager.hpp"
+#include <algorithm>
 #include <numeric>
 
 
 namespace hlsv
 {
 
+// ====================================================================================================================
+// Describes a builtin variable that is made available in a specific shader stage
+struct BuiltinVariable final
+{
+	ShaderType type;
+	ShaderStages stage;
+	const char* name;
+	HLSVType::PrimType var_type;
+	ShaderStages read;
+	ShaderStages write;
+};
+static constexpr BuiltinVariable BUILTIN_VARIABLES[] = {
+	{ ShaderType::Graphics, ShaderStages::Vertex, "$VertexIndex", HLSVType::Int, ShaderStages::Vertex, ShaderStages::None },
+	{ ShaderType::Graphics, ShaderStages::Vertex, "$InstanceIndex", HLSVType::Int, ShaderStages::Vertex, ShaderStages::None },
+	{ ShaderType::Graphics, ShaderStages::Vertex, "$Position", HLSVType::Float4, ShaderStages::None, ShaderStages::Vertex },
+	{ ShaderType::Graphics, ShaderStages::Vertex, "$PointSize", HLSVType::Float, ShaderStages::None, ShaderStages::Vertex },
+	{ ShaderType::Graphics, ShaderStages::Fragment, "$FragCoord", HLSVType::Float4, ShaderStages::Fragment, ShaderStages::None },
+	{ ShaderType::Graphics, ShaderStages::Fragment, "$FrontFacing", HLSVType::Bool, ShaderStages::Fragment, ShaderStages::None },
+	{ ShaderType::Graphics, ShaderStages::Fragment, "$PointCoord", HLSVType::Float2, ShaderStages::Fragment, ShaderStages::None },
+	{ ShaderType::Graphics, ShaderStages::Fragment, "$FragDepth", HLSVType::Float, ShaderStages::Fragment, ShaderStages::Fragment }
+};
+
 // ====================================================================================================================
 Variable* VariableManager::VarBlock::find(const string& name)
 {
@@ -105,11 +128,10 @@ void VariableManager::pop_block()
 // ====================================================================================================================
 void VariableManager::push_stage_variables(ShaderType type, ShaderStages stage)
 {
-	auto it = Builtins_.find({ type, stage });
-	if (it != Builtins_.end()) {
-		auto bl = blocks_.back();
-		for (const auto& v : it->second)
-			bl->vars.push_back(v);
+	auto bl = blocks_.back();
+	for (const auto& bv : BUILTIN_VARIABLES) {
+		if (bv.type == type && bv.stage == stage)
+			bl->vars.push_back({ bv.name, bv.var_type, VarScope::Builtin, bv.read, bv.write });
 	}
 }
 
@@ -121,21 +143,4 @@ uint32 VariableManager::get_local_slot_count()
 	});
 }
 
-
-// ====================================================================================================================
-const std::map<std::pair<ShaderType, ShaderStages>, std::vector<Variable>> VariableManager::Builtins_ = {
-	{{ ShaderType::Graphics, ShaderStages::Vertex }, {
-		{ "$VertexIndex", HLSVType::Int, VarScope::Builtin, ShaderStages::Vertex, ShaderStages::None },
-		{ "$InstanceIndex", HLSVType::Int, VarScope::Builtin, ShaderStages::Vertex, ShaderStages::None },
-		{ "$Position", HLSVType::Float4, VarScope::Builtin, ShaderStages::None, ShaderStages::Vertex },
-		{ "$PointSize", HLSVType::Float, VarScope::Builtin, ShaderStages::None, ShaderStages::Vertex }
-	}},
-	{{ ShaderType::Graphics, ShaderStages::Fragment }, {
-		{ "$FragCoord", HLSVType::Float4, VarScope::Builtin, ShaderStages::Fragment, ShaderStages::None },
-		{ "$FrontFacing", HLSVType::Bool, VarScope::Builtin, ShaderStages::Fragment, ShaderStages::None },
-		{ "$PointCoord", HLSVType::Float2, VarScope::Builtin, ShaderStages::Fragment, ShaderStages::None },
-		{ "$FragDepth", HLSVType::Float, VarScope::Builtin, ShaderStages::Fragment, ShaderStages::Fragment }
-	}}
-};
-
 } // namespace hlsv
@@ -14,7 +14,6 @@
 #include "../type/variable.hpp"
 #include "../type/typehelper.hpp"
 #include <vector>
-#include <map>
 
 
 namespace hlsv
@@ -48,7 +47,6 @@ public:
 	}; // class VarBlock
 
 private:
-	static const std::map<std::pair<ShaderType, ShaderStages>, std::vector<Variable>> Builtins_;
 	varvec globals_; // The global variables (all that dont exist in any local scopes)
 	std::vector<VarBlock*> blocks_;
 
@@ -10,8 +10,15 @@
 
 #include "visitor.hpp"
 #include "../type/typehelper.hpp"
+#include "../ir/eval.hpp"
+#include "../ir/passes.hpp"
 #include <stdlib.h>
+#include <algorithm>
 #include <cmath>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 #ifdef HLSV_COMPILER_MSVC
 	// Complaining about not using the return value of 'visit(...)'
@@ -27,25 +34,90 @@
 namespace hlsv
 {
 
+// Constant arrays larger than this (in bytes) are reported by the lint pass
+static const uint32 MAX_CONSTANT_ARRAY_SIZE = 256;
+
 // ====================================================================================================================
 Visitor::Visitor(antlr4::CommonTokenStream* ts, ReflectionInfo** refl, const CompilerOptions* opt) :
 	tokens_{ ts },
 	reflect_{ refl },
 	options_{ opt },
-	gen_{ this },
+	gen_{ this, opt->minify },
 	variables_{ },
 	infer_type_{ HLSVType::Error },
-	current_stage_{ ShaderStages::None }
+	current_stage_{ ShaderStages::None },
+	defer_stages_{ !opt->stream_parse }, // Streaming frees the stage parse trees before they can be deferred
+	deferred_stages_{ },
+	stage_visitors_{ },
+	module_{ },
+	stmt_blocks_{ },
+	constant_deps_{ },
+	func_entries_{ },
+	user_funcs_{ },
+	current_func_{ nullptr },
+	current_func_name_{ },
+	pending_warnings_{ },
+	warnings_{ }
 {
 
 }
 
+// ====================================================================================================================
+Visitor::Visitor(const Visitor& parent, size_t global_count, size_t func_count) :
+	tokens_{ parent.tokens_ },
+	reflect_{ parent.reflect_ },
+	options_{ parent.options_ },
+	gen_{ this, parent.options_->minify },
+	variables_{ },
+	infer_type_{ HLSVType::Error },
+	current_stage_{ ShaderStages::None },
+	defer_stages_{ false },
+	deferred_stages_{ },
+	stage_visitors_{ },
+	module_{ },
+	stmt_blocks_{ },
+	constant_deps_{ },
+	func_entries_{ parent.func_entries_.begin(), parent.func_entries_.begin() + func_count },
+	user_funcs_{ parent.user_funcs_.begin(), parent.user_funcs_.begin() + func_count },
+	current_func_{ nullptr },
+	current_func_name_{ },
+	pending_warnings_{ },
+	warnings_{ }
+{
+	const auto& globals = parent.variables_.get_globals();
+	for (size_t i = 0; i < global_count; ++i)
+		variables_.add_global(globals[i]);
+}
+
 // ====================================================================================================================
 Visitor::~Visitor()
 {
 
 }
 
+// ====================================================================================================================
+ir::Symbol* Visitor::symbol_for(Variable& vrbl)
+{
+	if (!vrbl.symbol) {
+		vrbl.symbol = module_.new_symbol(Variable::GetOutputName(vrbl.name), vrbl.type, vrbl.scope,
+			vrbl.is_local() && vrbl.local.is_flat);
+	}
+	return vrbl.symbol;
+}
+
+// ====================================================================================================================
+void Visitor::visit_body(grammar::HLSV::StatementContext* stmt, grammar::HLSV::BlockContext* block, ir::Block* body)
+{
+	stmt_blocks_.push_back(body);
+	if (block) {
+		for (auto st : block->statement())
+			visit(st);
+	}
+	else
+		visit(stmt);
+	stmt_blocks_.pop_back();
+}
+
 // ====================================================================================================================
 int64 Visitor::parse_integer_literal(antlr4::Token* tk, bool* isuns, bool forceSize) const
 {
@@ -160,6 +232,8 @@ Variable Visitor::parse_variable(grammar::HLSV::VariableDeclarationContext* ctx,
 	auto name = ctx->Name->getText();
 	if (name[0] == '$')
 		ERROR(ctx->Name, "User-declared variables cannot start with '$'.");
+	if (name[0] == '_') // Reserved for the names generated by the optimizer passes
+		ERROR(ctx->Name, "User-declared variables cannot start with '_', it is reserved for internal names.");
 	if (name.length() > 24)
 		ERROR(ctx->Name, "Variable names cannot be longer than 24 characters.");
 
@@ -172,33 +246,367 @@ Variable Visitor::parse_variable(grammar::HLSV::VariableDeclarationContext* ctx,
 }
 
 // ====================================================================================================================
-VISIT_FUNC(File)
+void Visitor::finalize(antlr4::Token* tk)
 {
-	// Visit the version statement first
-	visit(ctx->shaderVersionStatement());
-
-	// Visit all of the top-level statements
-	for (auto tls : ctx->topLevelStatement()) {
-		visit(tls);
+	// Visit the stage functions now that all globals are known, then generate their code
+	visit_deferred_stages();
+	if (OPT->optimize && OPT->hoist_vertex) { // Move the fragment work that is exact under interpolation to the vertex
+		uint32 used_slots = variables_.get_local_slot_count(); // Can be over the limit before packing
+		uint32 free_slots = (used_slots < LIMITS.local_slots) ? (LIMITS.local_slots - used_slots) : 0u;
+		for (auto sym : ir::HoistToVertexStage(module_, free_slots)) {
+			Variable vrbl{ sym->name, sym->type, VarScope::Local };
+			vrbl.local.is_flat = sym->is_flat;
+			vrbl.symbol = sym;
+			variables_.add_global(vrbl);
+		}
+	}
+	ir::SymbolSet passed{ }; // Propagate constant locals, and find the locals that the fragment stage still reads
+	bool linked = OPT->optimize && ir::LinkStages(module_, passed);
+	if (OPT->preshader)
+		emit_preshader();
+	assign_stage_masks();
+	if (OPT->lint)
+		check_warnings();
+	for (auto func : module_.functions()) // Before profiling, so the estimate does not include the counters
+		REFL->perf_stats.push_back(ir::EstimateCost(module_, *func));
+	if (OPT->profile && !OPT->reflect_only)
+		emit_profiling(tk);
+	for (auto func : user_funcs_) { // In definition order, so the functions are declared before they are called
+		if (func->stage != ShaderStages::None)
+			gen_.emit_user_function(*func);
 	}
+	for (auto func : module_.functions())
+		gen_.emit_function(*func);
 
-	// Emit the locals
+	// Emit the locals, skipping the removed ones so the remaining locations are compacted
 	{
-		uint32 base = std::max({ REFL->get_highest_attr_slot() + 1u, (uint32)REFL->outputs.size() });
+		std::vector<const Variable*> locals{ };
 		for (const auto& loc : variables_.get_globals()) {
-			if (loc.is_local()) {
-				gen_.emit_local(loc, base);
-				base += loc.type.get_slot_size();
-			}
+			if (loc.is_local() && (!linked || passed.count(loc.symbol)))
+				locals.push_back(&loc);
 		}
+		emit_locals(tk, locals);
 	}
 
 	// Validate the shader stages
 	if (!(REFL->stages & ShaderStages::MinGraphics))
-		ERROR(ctx, "Missing shader stages - at minimum the vertex and fragment shaders must be defined.");
+		ERROR(tk, "Missing shader stages - at minimum the vertex and fragment shaders must be defined.");
 
 	// Sort the reflection info
 	REFL->sort();
+}
+
+// ====================================================================================================================
+void Visitor::emit_preshader()
+{
+	// Find the first free binding, the preshader is skipped if there is not one
+	uint32 uset = 0, ubind = 0;
+	while (REFL->get_uniform_at(uset, ubind)) {
+		if (++ubind == LIMITS.uniform_bindings) {
+			ubind = 0;
+			if (++uset == LIMITS.uniform_sets)
+				return;
+		}
+	}
+
+	// Extract the values, and add their uniforms in a new block
+	auto symbols = ir::ExtractPreshader(module_, *REFL, LIMITS.uniform_block_size);
+	if (symbols.empty())
+		return;
+	UniformBlock ub{ (uint8)uset, (uint8)ubind };
+	uint8 bindex = (uint8)REFL->blocks.size();
+	bool packed = true;
+	gen_.emit_uniform_block_header(uset, ubind);
+	for (size_t i = 0; i < symbols.size(); ++i) {
+		const auto& val = REFL->preshader[i];
+		uint16 usize = TypeHelper::GetValueTypeSize(val.type.type);
+		packed = packed && (val.offset == ub.size);
+		Uniform uni{ symbols[i]->name, val.type, (uint8)uset, (uint8)ubind, bindex, val.offset, usize };
+		REFL->uniforms.push_back(uni);
+		gen_.emit_value_uniform(uni);
+		ub.members.push_back((uint8)(REFL->uniforms.size() - 1));
+		ub.size = val.offset + usize;
+	}
+	ub.packed = packed;
+	REFL->blocks.push_back(ub);
+	gen_.emit_block_close();
+	REFL->preshader_set = (uint8)uset;
+	REFL->preshader_binding = (uint8)ubind;
+}
+
+// ====================================================================================================================
+void Visitor::emit_profiling(antlr4::Token* tk)
+{
+	// The counter buffer uses the last binding, so its location does not change as the uniforms change
+	uint32 pset = LIMITS.uniform_sets - 1, pbind = LIMITS.uniform_bindings - 1;
+	if (REFL->get_uniform_at(pset, pbind)) {
+		ERROR(tk, strarg("Profiling requires the uniform binding at set %u, binding %u to be free for the counter "
+			"buffer.", pset, pbind));
+	}
+
+	// Instrument the functions that are emitted, the user functions run in all of the stages that call them
+	std::vector<ir::Function*> funcs{ };
+	for (auto func : user_funcs_) {
+		if (func->stage != ShaderStages::None)
+			funcs.push_back(func);
+	}
+	funcs.insert(funcs.end(), module_.functions().begin(), module_.functions().end());
+	if (funcs.empty())
+		return;
+	auto counters = ir::InstrumentProfiling(module_, funcs, *REFL);
+
+	ShaderStages stages = ShaderStages::None;
+	for (const auto& pc : REFL->profile_counters)
+		stages |= pc.stage;
+	gen_.emit_profile_buffer(pset, pbind, *counters, (uint32)REFL->profile_counters.size());
+	gen_.set_resource_stages(GLSLGenerator::ProfileBlockName(), stages);
+	REFL->profile_set = (uint8)pset;
+	REFL->profile_binding = (uint8)pbind;
+}
+
+// ====================================================================================================================
+void Visitor::emit_locals(antlr4::Token* tk, const std::vector<const Variable*>& locals)
+{
+	const uint32 start = std::max({ REFL->get_highest_attr_slot() + 1u, (uint32)REFL->outputs.size() });
+	uint32 base = start;
+	std::vector<uint32> slots(locals.size(), 0u), comps(locals.size(), UINT32_MAX);
+
+	// Locals that fill whole slots are placed first, in declaration order
+	std::vector<size_t> packed{ };
+	for (size_t i = 0; i < locals.size(); ++i) {
+		const auto& type = locals[i]->type;
+		if (OPT->pack_locals && !type.is_array && !type.is_matrix_type() && type.get_component_count() < 4)
+			packed.push_back(i);
+		else {
+			slots[i] = base;
+			base += type.get_slot_size();
+		}
+	}
+
+	// The small locals are packed into the first slot that has space, largest first, and only slots with the same
+	//    component type and interpolation can be shared
+	struct Slot { uint32 location; uint32 used; HLSVType::PrimType comp_type; bool flat; };
+	std::vector<Slot> shared{ };
+	std::stable_sort(packed.begin(), packed.end(), [&locals](size_t l, size_t r) {
+		return locals[l]->type.get_component_count() > locals[r]->type.get_component_count();
+	});
+	for (auto i : packed) {
+		const auto& vrbl = *locals[i];
+		uint32 count = vrbl.type.get_component_count();
+		auto ctype = HLSVType::GetComponentType(vrbl.type.type);
+		auto it = std::find_if(shared.begin(), shared.end(), [&vrbl, count, ctype](const Slot& s) {
+			return s.comp_type == ctype && s.flat == vrbl.local.is_flat && (s.used + count) <= 4;
+		});
+		if (it == shared.end())
+			it = shared.insert(shared.end(), Slot{ base++, 0u, ctype, vrbl.local.is_flat });
+		slots[i] = it->location;
+		comps[i] = it->used;
+		it->used += count;
+	}
+
+	// The slot limit is checked when the locals are declared, unless they are packed
+	if (OPT->pack_locals && (base - start) > LIMITS.local_slots) {
+		ERROR(tk, strarg("The locals use %u slots after packing, only %u slots are available.", base - start,
+			LIMITS.local_slots));
+	}
+
+	for (size_t i = 0; i < locals.size(); ++i) {
+		const auto& vrbl = *locals[i];
+		gen_.emit_local(vrbl, slots[i], comps[i]);
+		REFL->locals.push_back({ vrbl.name, vrbl.type, (uint8)slots[i], (uint8)((comps[i] == UINT32_MAX) ? 0 : comps[i]),
+			vrbl.local.is_flat });
+	}
+}
+
+// ====================================================================================================================
+void Visitor::assign_stage_masks()
+{
+	// Find the stages that use each global by name, the constants used by other global constants are in all stages
+	std::unordered_map<string, ShaderStages> used{ };
+	for (auto func : module_.functions()) {
+		ir::SymbolSet syms{ };
+		ir::FindUsedSymbols(func->body, syms);
+		ir::FunctionSet called{ }; // The user functions that were not inlined are only emitted into their callers
+		ir::FindCalledFunctions(func->body, called);
+		for (auto cf : called) {
+			cf->stage |= func->stage;
+			ir::FindUsedSymbols(cf->body, syms);
+		}
+		for (auto sym : syms)
+			used[sym->name] |= func->stage;
+	}
+	for (auto sym : constant_deps_)
+		used[sym->name] |= REFL->stages;
+	auto mask = [this, &used](const string& name) {
+		if (OPT->reflect_only) // The stage functions are not available, so assume all stages
+			return REFL->stages;
+		auto it = used.find(name);
+		return (it != used.end()) ? it->second : ShaderStages::None;
+	};
+
+	// Apply the masks
+	for (auto& attr : REFL->attributes) {
+		attr.used = mask(attr.name) & ShaderStages::Vertex;
+		if (!attr.used && OPT->strip_attributes)
+			gen_.set_resource_stages(attr.name, ShaderStages::None);
+	}
+	for (auto& uni : REFL->uniforms) {
+		uni.stage_mask = mask(uni.name);
+		gen_.set_resource_stages(uni.name, uni.stage_mask);
+	}
+	for (auto& bl : REFL->blocks) {
+		for (auto mi : bl.members)
+			bl.stage_mask |= REFL->uniforms[mi].stage_mask;
+		gen_.set_resource_stages(GLSLGenerator::BlockName(bl.set, bl.binding), bl.stage_mask);
+	}
+	ShaderStages push_mask = ShaderStages::None;
+	for (auto& pc : REFL->push_constants) {
+		pc.stage_mask = mask(pc.name);
+		push_mask |= pc.stage_mask;
+		gen_.set_resource_stages(pc.name, pc.stage_mask);
+	}
+	gen_.set_resource_stages(GLSLGenerator::PushBlockName(), push_mask);
+	for (auto& sc : REFL->spec_constants) {
+		sc.stage_mask = mask(sc.name);
+		gen_.set_resource_stages(sc.name, sc.stage_mask);
+	}
+}
+
+// ====================================================================================================================
+// Records the stages that contain each statement and expression node of the optimized code
+static void collect_node_stages(const ir::Block& block, ShaderStages stage,
+	std::unordered_map<const void*, ShaderStages>& nodes);
+static void collect_node_stages(const ir::Expr* expr, ShaderStages stage,
+	std::unordered_map<const void*, ShaderStages>& nodes)
+{
+	if (!expr)
+		return;
+	nodes[expr] |= stage;
+	for (uint32 i = 0; i < expr->arg_count; ++i)
+		collect_node_stages(expr->args[i], stage, nodes);
+}
+static void collect_node_stages(const ir::Block& block, ShaderStages stage,
+	std::unordered_map<const void*, ShaderStages>& nodes)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		nodes[stmt] |= stage;
+		collect_node_stages(stmt->target, stage, nodes);
+		collect_node_stages(stmt->value, stage, nodes);
+		collect_node_stages(stmt->init, stage, nodes);
+		collect_node_stages(stmt->updates, stage, nodes);
+		collect_node_stages(stmt->body, stage, nodes);
+		collect_node_stages(stmt->else_body, stage, nodes);
+	}
+}
+
+// ====================================================================================================================
+void Visitor::check_warnings()
+{
+	// Find the nodes that survived optimization, the stages of the user functions are set by assign_stage_masks()
+	std::unordered_map<const void*, ShaderStages> nodes{ };
+	for (auto func : module_.functions())
+		collect_node_stages(func->body, func->stage, nodes);
+	for (auto func : user_funcs_)
+		collect_node_stages(func->body, func->stage, nodes);
+
+	for (const auto& pw : pending_warnings_) {
+		const void* node = pw.expr ? (const void*)pw.expr : (const void*)pw.stmt;
+		if (node) {
+			auto it = nodes.find(node);
+			if (it == nodes.end()) // Removed as dead code, or folded into a constant
+				continue;
+			if (pw.fragment_only && !(it->second & ShaderStages::Fragment))
+				continue;
+		}
+		if (pw.expr && pw.expr->kind == ir::ExprKind::Index && pw.expr->args[1]->is_constant)
+			continue; // The index was folded into a constant
+		if (pw.fragment_only) { // The operator must still be division after optimization
+			auto op = pw.expr ? pw.expr->op : pw.stmt->op;
+			if (op != ir::Op::Div && op != ir::Op::Mod)
+				continue;
+		}
+		warnings_.push_back(pw.warning);
+	}
+	pending_warnings_.clear();
+
+	std::stable_sort(warnings_.begin(), warnings_.end(), [](const CompilerWarning& l, const CompilerWarning& r) {
+		return (l.line < r.line) || ((l.line == r.line) && (l.character < r.character));
+	});
+}
+
+// ====================================================================================================================
+void Visitor::visit_stage_block(grammar::HLSV::BlockContext* block, ShaderStages stage)
+{
+	current_stage_ = stage;
+	auto func = module_.new_function(stage);
+
+	variables_.push_block(VariableManager::BT_Func);
+	variables_.push_stage_variables(ShaderType::Graphics, stage);
+	stmt_blocks_.push_back(&func->body);
+	visit(block);
+	stmt_blocks_.pop_back();
+	variables_.pop_block();
+	ir::OptimizeFunction(module_, *func, *OPT);
+
+	current_stage_ = ShaderStages::None;
+}
+
+// ====================================================================================================================
+void Visitor::visit_deferred_stages()
+{
+	const size_t count = deferred_stages_.size();
+	if (count == 0)
+		return;
+
+	// Each stage gets its own visitor, so the variable scopes and generated code are independent
+	std::vector<std::unique_ptr<Visitor>> visitors{ };
+	std::vector<std::exception_ptr> errors{ count };
+	for (const auto& ds : deferred_stages_)
+		visitors.emplace_back(new Visitor{ *this, ds.global_count, ds.func_count });
+
+	// Visit the stages concurrently, with the last one on this thread
+	std::vector<std::thread> threads{ };
+	auto run_stage = [this, &visitors, &errors](size_t idx) {
+		try {
+			visitors[idx]->visit_stage_block(deferred_stages_[idx].block, deferred_stages_[idx].stage);
+		}
+		catch (...) {
+			errors[idx] = std::current_exception();
+		}
+	};
+	for (size_t i = 0; i < (count - 1); ++i)
+		threads.emplace_back(run_stage, i);
+	run_stage(count - 1);
+	for (auto& th : threads)
+		th.join();
+
+	// Report the first error in source order, otherwise collect the stage functions
+	for (const auto& err : errors) {
+		if (err)
+			std::rethrow_exception(err);
+	}
+	for (auto& vis : visitors) {
+		for (auto func : vis->module_.functions())
+			module_.add_function(func);
+		pending_warnings_.insert(pending_warnings_.end(), vis->pending_warnings_.begin(), vis->pending_warnings_.end());
+		stage_visitors_.push_back(std::move(vis));
+	}
+	deferred_stages_.clear();
+}
+
+// ====================================================================================================================
+VISIT_FUNC(File)
+{
+	// Visit the version statement first
+	visit(ctx->shaderVersionStatement());
+
+	// Visit all of the top-level statements
+	for (auto tls : ctx->topLevelStatement()) {
+		visit(tls);
+	}
+
+	// Finish the shader
+	finalize(ctx->getStart());
 
 	return nullptr;
 }
@@ -257,6 +665,7 @@ VISIT_FUNC(VertexAttributeStatement)
 	// Attribute is good to go
 	Attribute attr{ vrbl.name, vrbl.type, (uint8)index, scount };
 	REFL->attributes.push_back(attr);
+	symbol_for(vrbl);
 	variables_.add_global(vrbl);
 	gen_.emit_attribute(attr);
 
@@ -289,6 +698,7 @@ VISIT_FUNC(FragmentOutputStatement)
 	// Output is good to go
 	Output output{ vrbl.name, vrbl.type, (uint8)index };
 	REFL->outputs.push_back(output);
+	symbol_for(vrbl);
 	variables_.add_global(vrbl);
 	gen_.emit_output(output);
 
@@ -306,14 +716,15 @@ VISIT_FUNC(LocalStatement)
 		ERROR(vdec->Type, strarg("Local '%s' must be a value type.", vrbl.name.c_str()));
 	vrbl.local.is_flat = !!ctx->KW_FLAT() || vrbl.type.is_integer_type();
 
-	// Slot checking
+	// Slot checking, packed locals are checked once their packed size is known
 	uint32 rem = variables_.get_local_slot_count();
-	if ((rem + vrbl.get_slot_count()) > LIMITS.local_slots) {
+	if (!OPT->pack_locals && (rem + vrbl.get_slot_count()) > LIMITS.local_slots) {
 		ERROR(ctx, strarg("Local '%s' is too large (%u slots), only %u slots still available.", vrbl.name.c_str(),
 			vrbl.get_slot_count(), LIMITS.local_slots - rem));
 	}
 
 	// Local is good to go (location gets assigned later)
+	symbol_for(vrbl);
 	variables_.add_global(vrbl);
 
 	return nullptr;
@@ -366,6 +777,7 @@ VISIT_FUNC(UniformStatement)
 			}
 
 			// Add the uniform
+			symbol_for(vrbl);
 			variables_.add_global(vrbl);
 			Uniform uni{ vrbl.name, vrbl.type, (uint8)uset, (uint8)ubind, bindex, boff, usize };
 			REFL->uniforms.push_back(uni);
@@ -399,6 +811,7 @@ VISIT_FUNC(UniformStatement)
 		}
 
 		// Good to go, add the uniform
+		symbol_for(vrbl);
 		variables_.add_global(vrbl);
 		Uniform uni{ vrbl.name, vrbl.type, (uint8)uset, (uint8)ubind, 0, 0, 0 };
 		REFL->uniforms.push_back(uni);
@@ -441,6 +854,7 @@ VISIT_FUNC(PushConstantsStatement)
 		}
 
 		// Add the push constant
+		symbol_for(vrbl);
 		variables_.add_global(vrbl);
 		PushConstant pc{ vrbl.name, vrbl.type, off, usize };
 		gen_.emit_push_constant(pc);
@@ -480,6 +894,8 @@ VISIT_FUNC(ConstantStatement)
 		ERROR(ctx->Value, "Constant expression array size mismatch.");
 
 	// Global constants and specialization constants have different rules
+	if (OPT->optimize)
+		expr->node = ir::FoldExpr(module_, expr->node);
 	if (idx) {
 		if (!TypeHelper::CanPromoteTo(expr->type.type, vrbl.type.type)) {
 			ERROR(ctx->Value, strarg("Expression type '%s' cannot be promoted to variable type '%s'.",
@@ -488,8 +904,10 @@ VISIT_FUNC(ConstantStatement)
 		auto sidx = parse_size_literal(idx);
 		if (sidx >= 256u)
 			ERROR(idx, "Specialization constants cannot be bound above index 255.");
-		if (vrbl.type.type == HLSVType::Float && expr->type.type != HLSVType::Float)
+		if (vrbl.type.type == HLSVType::Float && expr->type.type != HLSVType::Float) {
 			expr->set_literal_value(expr->type.type == HLSVType::Int ? (float)expr->literal_value.si : (float)expr->literal_value.ui);
+			expr->node = module_.new_literal(expr->literal_value.f, get_line(ctx->Value));
+		}
 		vrbl.constant.is_spec = true;
 		vrbl.constant.spec_index = sidx;
 		SpecConstant sc{ vrbl.name, vrbl.type, (uint8)sidx, 0 };
@@ -504,30 +922,139 @@ VISIT_FUNC(ConstantStatement)
 				expr->type.get_type_str().c_str(), vrbl.type.get_type_str().c_str()));
 		}
 		gen_.emit_global_constant(vrbl, *expr);
+		ir::FindUsedSymbols(expr->node, constant_deps_);
+		uint32 bytes = vrbl.type.count * vrbl.type.get_component_count() * 4u;
+		if (vrbl.type.is_array && bytes > MAX_CONSTANT_ARRAY_SIZE) {
+			WARN(ctx, strarg("The constant array '%s' (%u bytes) is copied into every invocation, consider a uniform "
+				"buffer instead.", vrbl.name.c_str(), bytes), nullptr);
+		}
 	}
 
+	auto sym = symbol_for(vrbl);
+	if (!idx && OPT->optimize && ir::IsConstantForm(expr->node))
+		sym->value = expr->node; // Specialization constants are left symbolic
 	variables_.add_global(vrbl);
 	infer_type_ = HLSVType::Error;
 	return nullptr;
 }
 
 // ====================================================================================================================
-VISIT_FUNC(VertFunction)
+// Gets if every path through the block reaches a return statement
+static bool always_returns(const ir::Block& block)
 {
-	if (REFL->stages & ShaderStages::Vertex)
-		ERROR(ctx, "Cannot define more than one vertex function per shader.");
-	REFL->stages |= ShaderStages::Vertex;
-	current_stage_ = ShaderStages::Vertex;
-	gen_.push_indent();
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == ir::StmtKind::Return)
+			return true;
+		if (stmt->kind == ir::StmtKind::If && !stmt->else_body.empty() && always_returns(stmt->body) &&
+				always_returns(stmt->else_body))
+			return true;
+	}
+	return false;
+}
+
+// ====================================================================================================================
+VISIT_FUNC(UserFunction)
+{
+	if (OPT->reflect_only) // The stage functions are not visited, so the functions would never be called
+		return nullptr;
+
+	// Check the return type and name
+	auto rtype = TypeHelper::ParseTypeStr(ctx->RType->getText());
+	if (rtype == HLSVType::Error)
+		ERROR(ctx->RType, strarg("Invalid return type '%s'.", ctx->RType->getText().c_str()));
+	if (rtype == HLSVType::Void)
+		ERROR(ctx->RType, "User functions must return a value, as they cannot have side effects.");
+	if (!HLSVType::IsValueType(rtype))
+		ERROR(ctx->RType, "User functions can only return value types.");
+	auto name = ctx->Name->getText();
+	if (name[0] == '$')
+		ERROR(ctx->Name, "User function names cannot start with '$'.");
+	if (name[0] == '_') // Reserved for the names generated by the optimizer passes
+		ERROR(ctx->Name, "User function names cannot start with '_', it is reserved for internal names.");
+	if (name.length() > 24)
+		ERROR(ctx->Name, "Function names cannot be longer than 24 characters.");
+	if (TypeHelper::ParseTypeStr(name) != HLSVType::Error || FunctionRegistry::IsBuiltinFunction(name))
+		ERROR(ctx->Name, strarg("The name '%s' is already used by a builtin type or function.", name.c_str()));
+	if (ctx->Params.size() > FunctionEntry::MAX_PARAMS)
+		ERROR(ctx, strarg("User functions cannot have more than %u parameters.", FunctionEntry::MAX_PARAMS));
 
+	// Parse the parameters into the function scope
 	variables_.push_block(VariableManager::BT_Func);
-	variables_.push_stage_variables(ShaderType::Graphics, ShaderStages::Vertex);
+	std::vector<ir::Symbol*> params{ };
+	for (auto pctx : ctx->Params) {
+		auto vrbl = parse_variable(pctx, VarScope::Block);
+		if (vrbl.type.is_array || !vrbl.type.is_value_type())
+			ERROR(pctx->Type, "Function parameters can only be non-array value types.");
+		params.push_back(symbol_for(vrbl));
+		variables_.add_variable(vrbl);
+	}
+
+	// Check that the overload is new
+	uint32 overloads = 0;
+	for (const auto& ent : func_entries_) {
+		if (name != ent.name)
+			continue;
+		bool same = (ent.param_count == params.size());
+		for (uint32 i = 0; same && (i < ent.param_count); ++i)
+			same = (ent.params[i].type == params[i]->type);
+		if (same)
+			ERROR(ctx->Name, strarg("An overload of '%s' with the same parameter types already exists.", name.c_str()));
+		++overloads;
+	}
+
+	// Visit the body
+	auto outname = overloads ? strarg("_fn_%s_%u", name.c_str(), overloads) : ("_fn_" + name);
+	auto func = module_.new_user_function(outname, rtype, params);
+	if (ctx->Attr)
+		func->hint = visit(ctx->Attr).as<ir::InlineHint>();
+	current_func_ = func;
+	current_func_name_ = name;
+	stmt_blocks_.push_back(&func->body);
 	visit(ctx->block());
+	stmt_blocks_.pop_back();
 	variables_.pop_block();
+	current_func_ = nullptr;
+	current_func_name_.clear();
+	if (!always_returns(func->body))
+		ERROR(ctx->Name, strarg("Not all paths through the function '%s' return a value.", name.c_str()));
+	ir::OptimizeFunction(module_, *func, *OPT);
+
+	// Register the function, which can only be called by the code after it
+	FunctionEntry entry{ module_.arena().copy_str(name), func->name, HLSVType{ rtype }, { } };
+	for (auto sym : params)
+		entry.params[entry.param_count++] = FunctionParam{ sym->type, false };
+	func_entries_.push_back(entry);
+	user_funcs_.push_back(func);
+	return nullptr;
+}
 
-	gen_.pop_indent();
-	gen_.emit_func_block_close();
-	current_stage_ = ShaderStages::None;
+// ====================================================================================================================
+VISIT_FUNC(FunctionAttribute)
+{
+	auto name = ctx->Name->getText();
+	if (name == "inline")
+		return ir::InlineHint::Inline;
+	if (name == "noinline")
+		return ir::InlineHint::NoInline;
+	ERROR(ctx->Name, strarg("Unknown function attribute '%s', expected 'inline' or 'noinline'.", name.c_str()));
+	return ir::InlineHint::None;
+}
+
+// ====================================================================================================================
+VISIT_FUNC(VertFunction)
+{
+	if (REFL->stages & ShaderStages::Vertex)
+		ERROR(ctx, "Cannot define more than one vertex function per shader.");
+	REFL->stages |= ShaderStages::Vertex;
+	if (OPT->reflect_only) // Only the stage presence is needed for reflection
+		return nullptr;
+	if (defer_stages_) {
+		deferred_stages_.push_back({ ctx->block(), ShaderStages::Vertex, variables_.get_globals().size(),
+			func_entries_.size() });
+		return nullptr;
+	}
+
+	visit_stage_block(ctx->block(), ShaderStages::Vertex);
 	return nullptr;
 }
 
@@ -537,17 +1064,15 @@ VISIT_FUNC(FragFunction)
 	if (REFL->stages & ShaderStages::Fragment)
 		ERROR(ctx, "Cannot define more than one fragment function per shader.");
 	REFL->stages |= ShaderStages::Fragment;
-	current_stage_ = ShaderStages::Fragment;
-	gen_.push_indent();
-
-	variables_.push_block(VariableManager::BT_Func);
-	variables_.push_stage_variables(ShaderType::Graphics, ShaderStages::Fragment);
-	visit(ctx->block());
-	variables_.pop_block();
+	if (OPT->reflect_only) // Only the stage presence is needed for reflection
+		return nullptr;
+	if (defer_stages_) {
+		deferred_stages_.push_back({ ctx->block(), ShaderStages::Fragment, variables_.get_globals().size(),
+			func_entries_.size() });
+		return nullptr;
+	}
 
-	gen_.pop_indent();
-	gen_.emit_func_block_close();
-	current_stage_ = ShaderStages::None;
+	visit_stage_block(ctx->block(), ShaderStages::Fragment);
 	return nullptr;
 }
 
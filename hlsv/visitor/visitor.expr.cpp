@@ -10,7 +10,6 @@
 
 #include "visitor.hpp"
 #include "../type/functions.hpp"
-#include <sstream>
 #include <cmath>
 
 #ifdef HLSV_COMPILER_MSVC
@@ -39,7 +38,7 @@ VISIT_FUNC(PostfixExpr)
 
 	// Good to go
 	NEW_EXPR_T(expr, lval->type.type);
-	expr->text = lval->text + optxt;
+	expr->node = module_.new_unary(ir::ParseUnaryOp(optxt, true), lval->node, expr->type, get_line(ctx));
 	return expr;
 }
 
@@ -55,7 +54,7 @@ VISIT_FUNC(PrefixExpr)
 
 	// Good to go
 	NEW_EXPR_T(expr, lval->type.type);
-	expr->text = optxt + lval->text;
+	expr->node = module_.new_unary(ir::ParseUnaryOp(optxt, false), lval->node, expr->type, get_line(ctx));
 	return expr;
 }
 
@@ -73,7 +72,7 @@ VISIT_FUNC(FactorExpr)
 
 	// Return the value
 	NEW_EXPR_T(expr, vexpr->type);
-	expr->text = ctx->Op->getText() + vexpr->text;
+	expr->node = module_.new_unary(ir::ParseUnaryOp(ctx->Op->getText(), false), vexpr->node, expr->type, get_line(ctx));
 	return expr;
 }
 
@@ -92,7 +91,7 @@ VISIT_FUNC(NegateExpr)
 	// Check the operator
 	auto optxt = ctx->Op->getText();
 	NEW_EXPR_T(expr, vexpr->type.type);
-	expr->text = optxt + vexpr->text;
+	expr->node = module_.new_unary(ir::ParseUnaryOp(optxt, false), vexpr->node, expr->type, get_line(ctx));
 	if (optxt[0] == '!') {
 		if (vexpr->type != HLSVType::Bool)
 			ERROR(ctx, "Operator '!' is only valid for boolean expressions.");
@@ -115,7 +114,10 @@ Expr* Visitor::visit_binary_expr(antlr4::RuleContext* ctx, antlr4::Token* op, st
 
 	// Generate expression
 	NEW_EXPR_T(expr, rtype);
-	expr->text = "(" + left->text + ' ' + op->getText() + ' ' + right->text + ')';
+	expr->node = module_.new_binary(ir::ParseBinaryOp(op->getText()), left->node, right->node, rtype, get_line(ctx));
+	if ((expr->node->op == ir::Op::Div || expr->node->op == ir::Op::Mod) && rtype.is_integer_type())
+		WARN(ctx, "Integer division and modulo are much slower than float operations in fragment code.", expr->node,
+			nullptr, true);
 	return expr;
 }
 
@@ -193,18 +195,17 @@ VISIT_FUNC(TernaryExpr)
 		ERROR(ctx->FExpr, strarg("The ternary false expression type '%s' cannot be promoted to the %s type '%s'.",
 			fexpr->type.get_type_str().c_str(), tstr, ttype.get_type_str().c_str()));
 	}
-	expr->text = "( " + cond->text + " ? ";
-	expr->text += ((texpr->type != ttype) ? strarg("%s( %s )", ttype.get_type_str().c_str(), texpr->text) : texpr->text);
-	expr->text += ((fexpr->type != ttype) ? strarg("%s( %s )", ttype.get_type_str().c_str(), fexpr->text) : fexpr->text);
+	auto line = get_line(ctx);
+	auto tnode = (texpr->type != ttype) ? module_.new_construct(ttype, { texpr->node }, line) : texpr->node;
+	auto fnode = (fexpr->type != ttype) ? module_.new_construct(ttype, { fexpr->node }, line) : fexpr->node;
+	expr->node = module_.new_ternary(cond->node, tnode, fnode, ttype, line);
 	return expr;
 }
 
 // ====================================================================================================================
 VISIT_FUNC(ParenAtom)
 {
-	auto ch = visit(ctx->expression()).as<Expr*>();
-	ch->text = "(" + ch->text + ')';
-	return ch;
+	return visit(ctx->expression()).as<Expr*>(); // Grouping is implicit in the IR tree
 }
 
 // ====================================================================================================================
@@ -240,10 +241,23 @@ VISIT_FUNC(ArrayIndexerAtom)
 
 	// Build the expression
 	NEW_EXPR_T(expr, etype);
-	expr->text = val->text + '[' + idx->text + ']';
+	expr->node = module_.new_index(val->node, idx->node, expr->type, get_line(ctx));
+	lint_array_index(ctx, expr->node);
 	return expr;
 }
 
+// ====================================================================================================================
+void Visitor::lint_array_index(antlr4::RuleContext* ctx, const ir::Expr* index)
+{
+	if (!index->args[0]->type.is_array || index->args[1]->is_constant)
+		return;
+	auto sym = ir::GetBaseSymbol(index->args[0]);
+	if (sym && (sym->scope == VarScope::Local || sym->scope == VarScope::Uniform)) {
+		WARN(ctx, strarg("Dynamically indexing the %s array '%s' can move it into slower memory.",
+			(sym->scope == VarScope::Local) ? "local" : "uniform", sym->name), index);
+	}
+}
+
 // ====================================================================================================================
 VISIT_FUNC(SwizzleAtom)
 {
@@ -260,6 +274,8 @@ VISIT_FUNC(SwizzleAtom)
 	auto cc = val->type.get_component_count();
 
 	// Validate the components
+	uint8 comps[4];
+	uint8 ccount = 0;
 	for (auto sc : stxt) {
 		auto cidx = (sc == 'x' || sc == 'r' || sc == 's') ? 1u :
 					(sc == 'y' || sc == 'g' || sc == 't') ? 2u :
@@ -269,12 +285,13 @@ VISIT_FUNC(SwizzleAtom)
 			ERROR(ctx->atom(), strarg("The type '%s' does not have the '%c' swizzle component.",
 				val->type.get_type_str().c_str(), sc));
 		}
+		comps[ccount++] = (uint8)(cidx - 1);
 	}
 
 	// Build the expression
 	auto nt = HLSVType::MakeVectorType(ct, (uint8)stxt.length());
 	NEW_EXPR_T(expr, nt);
-	expr->text = val->text + '.' + stxt;
+	expr->node = module_.new_swizzle(val->node, comps, ccount, nt, get_line(ctx));
 	return expr;
 }
 
@@ -290,9 +307,8 @@ VISIT_FUNC(InitializerList)
 		auto save_type = infer_type_;
 		infer_type_ = infer_type_.type; // Keeps the type, but sets is_array to false to generate children
 
-		// Visit the children and build init string
-		std::stringstream ss{}; ss << (HLSVType::IsScalarType(infer_type_.type) ? "{ " : TypeHelper::GetGLSLStr(infer_type_.type) + "[]( ");
-		bool first = true;
+		// Visit the children and build the init list
+		std::vector<ir::Expr*> nodes{};
 		bool cconst = true;
 		for (auto c : ctx->Args) {
 			auto aexpr = GET_VISIT_SPTR(c);
@@ -302,18 +318,15 @@ VISIT_FUNC(InitializerList)
 				ERROR(c, strarg("Cannot promote type '%s' to array member type '%s'.", aexpr->type.get_type_str().c_str(),
 					infer_type_.get_type_str().c_str()));
 			}
-			if (!first) ss << ", ";
-			else first = false;
-			ss << aexpr->text;
+			nodes.push_back(aexpr->node);
 			cconst = cconst && aexpr->is_compile_constant;
 		}
-		ss << (HLSVType::IsScalarType(infer_type_.type) ? " }" : " )");
 
 		// Return the expression
 		NEW_EXPR(expr);
 		expr->type = { infer_type_.type, (uint8)ctx->Args.size() };
 		expr->is_compile_constant = cconst;
-		expr->text = ss.str();
+		expr->node = module_.new_init_list(expr->type, nodes, get_line(ctx));
 		infer_type_ = save_type;
 		return expr;
 	}
@@ -321,20 +334,18 @@ VISIT_FUNC(InitializerList)
 		if (HLSVType::IsScalarType(infer_type_.type))
 			ERROR(ctx, "Initializer lists cannot be used on scalar types.");
 
-		// Visit all of the arguments and build the init text
+		// Visit all of the arguments
 		auto save_type = infer_type_;
 		std::vector<Expr*> args{};
-		std::stringstream ss{}; ss << TypeHelper::GetGLSLStr(infer_type_.type) << "( ";
+		std::vector<ir::Expr*> nodes{};
 		infer_type_ = HLSVType::Error;
 		bool cconst = true;
 		for (auto a : ctx->Args) {
 			auto aexpr = visit(a).as<Expr*>();
-			if (args.size() != 0) ss << ", ";
-			ss << aexpr->text;
 			args.push_back(aexpr);
+			nodes.push_back(aexpr->node);
 			cconst = cconst && aexpr->is_compile_constant;
 		}
-		ss << " )";
 		infer_type_ = save_type;
 
 		// Check the arguments
@@ -346,7 +357,7 @@ VISIT_FUNC(InitializerList)
 		for (auto arg : args) delete arg;
 		NEW_EXPR_T(expr, infer_type_.type);
 		expr->is_compile_constant = cconst;
-		expr->text = ss.str();
+		expr->node = module_.new_construct(expr->type, nodes, get_line(ctx));
 		return expr;
 	}
 }
@@ -363,20 +374,18 @@ VISIT_FUNC(FunctionCall)
 		if (!HLSVType::IsValueType(ctype))
 			ERROR(ctx, "Cannot construct non-value types.");
 
-		// Visit all of the arguments and build the init text
+		// Visit all of the arguments
 		auto save_type = infer_type_;
 		std::vector<Expr*> args{};
-		std::stringstream ss{}; ss << TypeHelper::GetGLSLStr(ctype) << "( ";
+		std::vector<ir::Expr*> nodes{};
 		infer_type_ = HLSVType::Error;
 		bool cconst = true;
 		for (auto a : ctx->Args) {
 			auto aexpr = visit(a).as<Expr*>();
-			if (args.size() != 0) ss << ", ";
-			ss << aexpr->text;
 			args.push_back(aexpr);
+			nodes.push_back(aexpr->node);
 			cconst = cconst && aexpr->is_compile_constant;
 		}
-		ss << " )";
 		infer_type_ = save_type;
 
 		// Check the arguments
@@ -388,27 +397,43 @@ VISIT_FUNC(FunctionCall)
 		for (auto arg : args) delete arg;
 		NEW_EXPR_T(expr, ctype);
 		expr->is_compile_constant = cconst;
-		expr->text = ss.str();
+		expr->node = module_.new_construct(expr->type, nodes, get_line(ctx));
 		return expr;
 	}
 	else { // Function call
-		// Visit all of the arguments and build the init text
+		// Visit all of the arguments
 		auto save_type = infer_type_;
 		std::vector<Expr*> args{};
-		std::stringstream ss{}; ss << "( ";
+		std::vector<ir::Expr*> nodes{};
 		infer_type_ = HLSVType::Error;
 		for (auto a : ctx->Args) {
 			auto aexpr = visit(a).as<Expr*>();
-			if (args.size() != 0) ss << ", ";
-			ss << aexpr->text;
 			args.push_back(aexpr);
+			nodes.push_back(aexpr->node);
 		}
-		ss << " )";
 		infer_type_ = save_type;
 
-		// Check the arguments
+		// Check the arguments, against the user functions first
 		string err{ "" };
 		HLSVType rtype{};
+		uint32 findex;
+		if (FunctionRegistry::CheckUserFunction(func_entries_, fname, args, err, rtype, findex)) {
+			// Cast the arguments to the exact parameter types, so the generated call matches the same overload
+			const auto& entry = func_entries_[findex];
+			for (size_t i = 0; i < nodes.size(); ++i) {
+				if (nodes[i]->type != entry.params[i].type)
+					nodes[i] = module_.new_construct(entry.params[i].type, { nodes[i] }, nodes[i]->line);
+			}
+			for (auto arg : args) delete arg;
+			NEW_EXPR_T(expr, rtype);
+			expr->node = module_.new_call(fname, entry.out_name, rtype, nodes, get_line(ctx));
+			expr->node->func = user_funcs_[findex];
+			return expr;
+		}
+		if (!err.empty())
+			ERROR(ctx, err);
+		if (fname == current_func_name_)
+			ERROR(ctx, "User functions cannot call themselves.");
 		string outname{};
 		if (!FunctionRegistry::CheckFunction(fname, args, err, rtype, outname))
 			ERROR(ctx, err);
@@ -416,7 +441,7 @@ VISIT_FUNC(FunctionCall)
 		// Return the expression
 		for (auto arg : args) delete arg;
 		NEW_EXPR_T(expr, rtype);
-		expr->text = outname + ss.str();
+		expr->node = module_.new_call(fname, outname, rtype, nodes, get_line(ctx));
 		return expr;
 	}
 }
@@ -429,11 +454,11 @@ VISIT_FUNC(VariableAtom)
 		ERROR(ctx->IDENTIFIER(), strarg("A variable with the name '%s' does not exist in the current context.",
 			ctx->IDENTIFIER()->getText().c_str()));
 	}
-	if (!(vrbl->can_read(current_stage_)))
+	if (!can_access(*vrbl) || !(vrbl->can_read(current_stage_)))
 		ERROR(ctx, strarg("The variable '%s' cannot be read in the current context.", ctx->IDENTIFIER()->getText().c_str()));
 	NEW_EXPR_T(expr, vrbl->type);
 	expr->is_compile_constant = vrbl->is_constant() || vrbl->is_push_constant();
-	expr->text = Variable::GetOutputName(vrbl->name);
+	expr->node = module_.new_variable(symbol_for(*vrbl), get_line(ctx));
 	return expr;
 }
 
@@ -444,13 +469,16 @@ VISIT_FUNC(ScalarLiteral)
 	expr->is_compile_constant = true;
 	expr->is_literal = true;
 
+	auto line = get_line(ctx);
 	if (ctx->BOOLEAN_LITERAL()) {
 		expr->type = HLSVType::Bool;
 		expr->set_literal_value(ctx->BOOLEAN_LITERAL()->getText() == "true");
+		expr->node = module_.new_literal(expr->literal_value.ui != 0, line);
 	}
 	else if (ctx->FLOAT_LITERAL()) {
 		expr->type = HLSVType::Float;
 		expr->set_literal_value(parse_float_literal(ctx->FLOAT_LITERAL()));
+		expr->node = module_.new_literal(expr->literal_value.f, line);
 	}
 	else { // int
 		bool isuns;
@@ -458,10 +486,12 @@ VISIT_FUNC(ScalarLiteral)
 		if (isuns) {
 			expr->type = HLSVType::UInt;
 			expr->set_literal_value((uint32)lval);
+			expr->node = module_.new_literal(expr->literal_value.ui, line);
 		}
 		else {
 			expr->type = HLSVType::Int;
 			expr->set_literal_value((int32)lval);
+			expr->node = module_.new_literal(expr->literal_value.si, line);
 		}
 	}
 
@@ -13,9 +13,13 @@
 #include "../config.hpp"
 #include "../gen/glsl_generator.hpp"
 #include "var_manager.hpp"
+#include "../ir/passes.hpp"
+#include "../type/functions.hpp"
 #include "../generated/HLSVBaseVisitor.h"
 #include "expr.hpp"
 #include "antlr/CommonTokenStream.h"
+#include <memory>
+#include <vector>
 
 #define VISIT(vtype) antlrcpp::Any visit##vtype(grammar::HLSV::vtype##Context* ctx) override;
 
@@ -59,11 +63,46 @@ private:
 	VariableManager variables_;
 	HLSVType infer_type_; // The type to use when inferring how to interpret an initializer list
 	ShaderStages current_stage_;
+	// Stage functions are deferred until after the global pass, then visited in parallel
+	struct DeferredStage
+	{
+		grammar::HLSV::BlockContext* block;
+		ShaderStages stage;
+		size_t global_count; // The number of globals declared before the stage function
+		size_t func_count;   // The number of user functions defined before the stage function
+	};
+	bool defer_stages_;
+	std::vector<DeferredStage> deferred_stages_;
+	std::vector<std::unique_ptr<Visitor>> stage_visitors_; // Kept alive so their IR remains valid
+	ir::Module module_;
+	std::vector<ir::Block*> stmt_blocks_; // The stack of IR blocks that statements are added to
+	ir::SymbolSet constant_deps_; // The constants read by global constant initializers, which are in all stages
+	std::vector<FunctionEntry> func_entries_; // The user function overloads, in definition order
+	std::vector<ir::Function*> user_funcs_;   // The IR for each user function overload (owned by the parent module)
+	ir::Function* current_func_;              // The user function being visited
+	string current_func_name_;
+	// A lint warning, which is only reported if the IR node that causes it is still in the optimized code
+	struct PendingWarning
+	{
+		CompilerWarning warning;
+		const ir::Expr* expr; // The expression that causes the warning, or nullptr
+		const ir::Stmt* stmt; // The statement that causes the warning, or nullptr (always reported if both are null)
+		bool fragment_only;   // If the warning is only reported for code in the fragment stage
+	};
+	std::vector<PendingWarning> pending_warnings_;
+	std::vector<CompilerWarning> warnings_;
 
 public:
 	Visitor(antlr4::CommonTokenStream* ts, ReflectionInfo** refl, const CompilerOptions* opt);
 	~Visitor();
 
+private:
+	// Creates a visitor for a single deferred stage, which sees the first global_count globals and the first
+	//    func_count user functions of the parent
+	Visitor(const Visitor& parent, size_t global_count, size_t func_count);
+
+public:
+
 	inline void ERROR(antlr4::RuleContext* ctx, const string& msg) const {
 		auto tk = tokens_->get(ctx->getSourceInterval().a);
 		throw VisitError(CompilerError::ES_COMPILER, msg, (uint32)tk->getLine(), (uint32)tk->getCharPositionInLine(), ctx->getText());
@@ -76,7 +115,24 @@ public:
 		throw VisitError(CompilerError::ES_COMPILER, msg, (uint32)tk->getLine(), (uint32)tk->getCharPositionInLine(), node->getText());
 	}
 
+	inline void WARN(antlr4::RuleContext* ctx, const string& msg, const ir::Expr* expr, const ir::Stmt* stmt = nullptr,
+			bool fragment_only = false) {
+		if (!options_->lint)
+			return;
+		auto tk = tokens_->get(ctx->getSourceInterval().a);
+		CompilerWarning warn{ msg, (uint32)tk->getLine(), (uint32)tk->getCharPositionInLine(), ctx->getText() };
+		pending_warnings_.push_back({ warn, expr, stmt, fragment_only });
+	}
+
 	inline GLSLGenerator& get_generator() { return gen_; }
+	inline const std::vector<CompilerWarning>& get_warnings() const { return warnings_; }
+
+	inline uint32 get_line(antlr4::RuleContext* ctx) const {
+		return (uint32)tokens_->get(ctx->getSourceInterval().a)->getLine();
+	}
+	ir::Symbol* symbol_for(Variable& vrbl);
+	inline void emit_stmt(ir::Stmt* stmt) { stmt_blocks_.back()->append(stmt); }
+	void visit_body(grammar::HLSV::StatementContext* stmt, grammar::HLSV::BlockContext* block, ir::Block* body);
 
 	int64 parse_integer_literal(antlr4::Token* tk, bool* isuns, bool forceSize = false) const;
 	int64 parse_integer_literal(antlr4::tree::TerminalNode* tn, bool* isuns, bool forceSize = false) const {
@@ -88,6 +144,28 @@ public:
 	float parse_float_literal(antlr4::tree::TerminalNode* tk) const;
 	Variable parse_variable(grammar::HLSV::VariableDeclarationContext* ctx, VarScope scope);
 
+	// Performs the final checks and emission after all top-level statements are visited, tk is the first file token
+	void finalize(antlr4::Token* tk);
+	// Moves the uniform-only expressions in the stage functions into a new uniform block at the first free binding
+	void emit_preshader();
+	// Adds the profiling counters to the stage and user functions, and emits the counter buffer at the reserved binding
+	void emit_profiling(antlr4::Token* tk);
+	// Assigns the locations of the locals that are passed between the stages, and emits them
+	void emit_locals(antlr4::Token* tk, const std::vector<const Variable*>& locals);
+	// Sets the stages that use each resource, attribute, and user function in the reflection info and generated code
+	void assign_stage_masks();
+	// Reports the pending lint warnings whose IR nodes are still in the optimized code
+	void check_warnings();
+	// Adds the lint warning for indexing a local or uniform array with a non-constant index
+	void lint_array_index(antlr4::RuleContext* ctx, const ir::Expr* index);
+	// User functions can be called from any stage, so they can only access the variables that all stages share
+	inline bool can_access(const Variable& vrbl) const {
+		return !current_func_ || vrbl.is_block() || vrbl.is_constant() || vrbl.is_uniform() || vrbl.is_push_constant();
+	}
+
+	void visit_stage_block(grammar::HLSV::BlockContext* block, ShaderStages stage);
+	void visit_deferred_stages();
+
 	// Core
 	VISIT(File)
 	VISIT(ShaderVersionStatement)
@@ -97,6 +175,8 @@ public:
 	VISIT(UniformStatement)
 	VISIT(PushConstantsStatement)
 	VISIT(ConstantStatement)
+	VISIT(UserFunction)
+	VISIT(FunctionAttribute)
 	VISIT(VertFunction)
 	VISIT(FragFunction)
 
@@ -110,6 +190,8 @@ public:
 	VISIT(DoLoop)
 	VISIT(ForLoop)
 	VISIT(ForLoopUpdate)
+	VISIT(LoopAttribute)
+	VISIT(BranchAttribute)
 	VISIT(ControlStatement)
 
 	// Expr
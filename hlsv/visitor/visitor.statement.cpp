@@ -36,8 +36,10 @@ VISIT_FUNC(VariableDeclaration)
 		ERROR(ctx->Type, "Function locals can only be non-array value types.");
 
 	// Add and emit
+	auto stmt = module_.new_stmt(ir::StmtKind::Declare, get_line(ctx));
+	stmt->symbol = symbol_for(vrbl);
 	variables_.add_variable(vrbl);
-	gen_.emit_variable_declaration(vrbl, nullptr);
+	emit_stmt(stmt);
 
 	return nullptr;
 }
@@ -60,8 +62,11 @@ VISIT_FUNC(VariableDefinition)
 	}
 
 	// Add and emit
+	auto stmt = module_.new_stmt(ir::StmtKind::Declare, get_line(ctx));
+	stmt->symbol = symbol_for(vrbl);
+	stmt->value = expr->node;
 	variables_.add_variable(vrbl);
-	gen_.emit_variable_declaration(vrbl, expr.get());
+	emit_stmt(stmt);
 
 	return nullptr;
 }
@@ -94,7 +99,14 @@ VISIT_FUNC(Assignment)
 	}
 
 	// Write the assignment
-	gen_.emit_assignment(lval->text, ctx->Op->getText(), *expr.get());
+	auto stmt = module_.new_stmt(ir::StmtKind::Assign, get_line(ctx));
+	stmt->op = (ctx->Op->getText() == "=") ? ir::Op::None : ir::ParseBinaryOp(ctx->Op->getText());
+	stmt->target = lval->node;
+	stmt->value = expr->node;
+	emit_stmt(stmt);
+	if ((stmt->op == ir::Op::Div || stmt->op == ir::Op::Mod) && lval->type.is_integer_type())
+		WARN(ctx, "Integer division and modulo are much slower than float operations in fragment code.", nullptr, stmt,
+			true);
 
 	return nullptr;
 }
@@ -107,12 +119,14 @@ VISIT_FUNC(Lvalue)
 		auto vrbl = variables_.find_variable(vname);
 		if (!vrbl)
 			ERROR(ctx->Name, strarg("The variable '%s' does not exist in the current context.", vname.c_str()));
-		if (!vrbl->can_write(current_stage_))
+		if ((current_func_ && !vrbl->is_block()) || !vrbl->can_write(current_stage_))
 			ERROR(ctx->Name, strarg("The variable '%s' cannot be modified in the current context.", vname.c_str()));
 
 		// Send the variable upwards unmodified
 		NEW_EXPR_T(expr, vrbl->type);
-		expr->text = Variable::GetOutputName(vrbl->name);
+		expr->node = module_.new_variable(symbol_for(*vrbl), get_line(ctx));
+		if (vname == "$FragDepth")
+			WARN(ctx, "Writing '$FragDepth' disables early depth testing for the fragment stage.", expr->node);
 		return expr;
 	}
 	else if (ctx->SWIZZLE()) { // Swizzle
@@ -127,6 +141,8 @@ VISIT_FUNC(Lvalue)
 
 		// Validate the components
 		auto stxt = ctx->SWIZZLE()->getText();
+		uint8 comps[4];
+		uint8 ccount = 0;
 		for (auto sc : stxt) {
 			auto cidx = (sc == 'x' || sc == 'r' || sc == 's') ? 1u :
 				(sc == 'y' || sc == 'g' || sc == 't') ? 2u :
@@ -136,11 +152,12 @@ VISIT_FUNC(Lvalue)
 				ERROR(ctx->SWIZZLE(), strarg("The type '%s' does not have the '%c' swizzle component.",
 					lval->type.get_type_str().c_str(), sc));
 			}
+			comps[ccount++] = (uint8)(cidx - 1);
 		}
 
 		// Send the variable upwards with the swizzle applied
 		NEW_EXPR_T(expr, HLSVType::MakeVectorType(ct, (uint8)stxt.length()));
-		expr->text = lval->text + '.' + stxt;
+		expr->node = module_.new_swizzle(lval->node, comps, ccount, expr->type, get_line(ctx));
 		return expr;
 	}
 	else { // Array indexer
@@ -177,7 +194,8 @@ VISIT_FUNC(Lvalue)
 
 		// Send the variable upwards with the array indexer applied
 		NEW_EXPR_T(expr, rtype);
-		expr->text = lval->text + '[' + idx->text + ']';
+		expr->node = module_.new_index(lval->node, idx->node, rtype, get_line(ctx));
+		lint_array_index(ctx, expr->node);
 		return expr;
 	}
 }
@@ -191,18 +209,14 @@ VISIT_FUNC(IfStatement)
 		ERROR(ctx->Cond, "If statement conditional expressions must have a scalar boolean type.");
 
 	// Visit the if block
+	auto stmt = module_.new_stmt(ir::StmtKind::If, get_line(ctx));
+	stmt->value = ifcond->node;
+	if (ctx->Attr)
+		stmt->branch_hint = visit(ctx->Attr).as<ir::BranchHint>();
 	variables_.push_block(VariableManager::BT_Cond);
-	gen_.emit_if_statement(*ifcond.get());
-	gen_.push_indent();
-	if (ctx->block()) {
-		for (auto st : ctx->block()->statement())
-			visit(st);
-	}
-	else
-		visit(ctx->statement());
-	gen_.pop_indent();
-	gen_.emit_func_block_close();
+	visit_body(ctx->statement(), ctx->block(), &stmt->body);
 	variables_.pop_block();
+	emit_stmt(stmt);
 
 	// Visit each of the elif statements
 	for (auto elif : ctx->Elifs) {
@@ -211,34 +225,22 @@ VISIT_FUNC(IfStatement)
 		if (cond->type.is_array || cond->type != HLSVType::Bool)
 			ERROR(elif->Cond, "Elif statement conditional expressions must have a scalar boolean type.");
 
-		// Visit the if block
+		// Visit the if block, chained as the only statement in the else block of the previous branch
+		auto elstmt = module_.new_stmt(ir::StmtKind::If, get_line(elif));
+		elstmt->is_elif = true;
+		elstmt->value = cond->node;
+		elstmt->branch_hint = stmt->branch_hint; // The attribute applies to the whole chain
 		variables_.push_block(VariableManager::BT_Cond);
-		gen_.emit_elif_statement(*cond.get());
-		gen_.push_indent();
-		if (elif->block()) {
-			for (auto st : elif->block()->statement())
-				visit(st);
-		}
-		else
-			visit(elif->statement());
-		gen_.pop_indent();
-		gen_.emit_func_block_close();
+		visit_body(elif->statement(), elif->block(), &elstmt->body);
 		variables_.pop_block();
+		stmt->else_body.append(elstmt);
+		stmt = elstmt;
 	}
 
 	// Visit the else statement
 	if (ctx->Else) {
 		variables_.push_block(VariableManager::BT_Cond);
-		gen_.emit_else_statement();
-		gen_.push_indent();
-		if (ctx->Else->block()) {
-			for (auto st : ctx->Else->block()->statement())
-				visit(st);
-		}
-		else
-			visit(ctx->Else->statement());
-		gen_.pop_indent();
-		gen_.emit_func_block_close();
+		visit_body(ctx->Else->statement(), ctx->Else->block(), &stmt->else_body);
 		variables_.pop_block();
 	}
 
@@ -254,18 +256,16 @@ VISIT_FUNC(WhileLoop)
 		ERROR(ctx->Cond, "While loop requires a scalar boolean type for its condition expression.");
 
 	// Visit the block or statement
+	auto stmt = module_.new_stmt(ir::StmtKind::While, get_line(ctx));
+	stmt->value = cond->node;
+	if (ctx->Attr)
+		stmt->hint = visit(ctx->Attr).as<ir::LoopHint>();
 	variables_.push_block(VariableManager::BT_Loop);
-	gen_.emit_while_loop(*cond.get());
-	gen_.push_indent();
-	if (ctx->block()) {
-		for (auto st : ctx->block()->statement())
-			visit(st);
-	}
-	else
-		visit(ctx->statement());
-	gen_.pop_indent();
-	gen_.emit_func_block_close();
+	visit_body(ctx->statement(), ctx->block(), &stmt->body);
 	variables_.pop_block();
+	emit_stmt(stmt);
+	WARN(ctx, "The 'while' loop does not have a provable bound, use a for loop with a constant trip count.", nullptr,
+		stmt);
 
 	return nullptr;
 }
@@ -279,18 +279,15 @@ VISIT_FUNC(DoLoop)
 		ERROR(ctx->Cond, "While loop requires a scalar boolean type for its condition expression.");
 
 	// Visit the block or statement
+	auto stmt = module_.new_stmt(ir::StmtKind::DoWhile, get_line(ctx));
+	stmt->value = cond->node;
+	if (ctx->Attr)
+		stmt->hint = visit(ctx->Attr).as<ir::LoopHint>();
 	variables_.push_block(VariableManager::BT_Loop);
-	gen_.emit_do_loop();
-	gen_.push_indent();
-	if (ctx->block()) {
-		for (auto st : ctx->block()->statement())
-			visit(st);
-	}
-	else
-		visit(ctx->statement());
-	gen_.pop_indent();
-	gen_.emit_do_loop_close(*cond.get());
+	visit_body(ctx->statement(), ctx->block(), &stmt->body);
 	variables_.pop_block();
+	emit_stmt(stmt);
+	WARN(ctx, "The 'do' loop does not have a provable bound, use a for loop with a constant trip count.", nullptr, stmt);
 
 	return nullptr;
 }
@@ -304,6 +301,10 @@ VISIT_FUNC(ForLoop)
 		ERROR(ctx->Init, "Loop counter variables cannot be arrays.");
 	if ((!vrbl.type.is_vector_type() && !vrbl.type.is_scalar_type()) || vrbl.type.get_component_type() == HLSVType::Bool)
 		ERROR(ctx->Init, "Counter variables must be non-boolean scalar or vector types.");
+	auto stmt = module_.new_stmt(ir::StmtKind::For, get_line(ctx));
+	stmt->symbol = symbol_for(vrbl);
+	if (ctx->Attr)
+		stmt->hint = visit(ctx->Attr).as<ir::LoopHint>();
 	variables_.push_block(VariableManager::BT_Loop);
 	variables_.add_variable(vrbl);
 
@@ -322,24 +323,15 @@ VISIT_FUNC(ForLoop)
 		ERROR(ctx->Cond, "Loop condition must be a scalar boolean type.");
 
 	// Check the update(s)
-	std::vector<string> updates{};
+	stmt->init = init->node;
+	stmt->value = cond->node;
 	for (auto up : ctx->Updates)
-		updates.push_back(visit(up).as<string>());
-
-	// Emit the header and start the new block
-	gen_.emit_for_loop(vrbl, *init.get(), *cond.get(), updates);
-	gen_.push_indent();
+		stmt->updates.append(visit(up).as<ir::Stmt*>());
 
 	// Visit the block, then close it
-	if (ctx->block()) {
-		for (auto st : ctx->block()->statement())
-			visit(st);
-	}
-	else
-		visit(ctx->statement());
+	visit_body(ctx->statement(), ctx->block(), &stmt->body);
 	variables_.pop_block();
-	gen_.pop_indent();
-	gen_.emit_func_block_close();
+	emit_stmt(stmt);
 
 	return nullptr;
 }
@@ -368,33 +360,80 @@ VISIT_FUNC(ForLoopUpdate)
 			if (rtype != lval->type)
 				ERROR(ctx->Assign->Value, "The result of the operation does not match the variable type.");
 		}
-		return strarg("%s %s (%s)", lval->text.c_str(), ctx->Assign->Op->getText().c_str(), uexpr->text.c_str());
+		auto stmt = module_.new_stmt(ir::StmtKind::Assign, get_line(ctx));
+		stmt->op = (ctx->Assign->Op->getText() == "=") ? ir::Op::None : ir::ParseBinaryOp(ctx->Assign->Op->getText());
+		stmt->target = lval->node;
+		stmt->value = uexpr->node;
+		return stmt;
 	}
 	else { // Unary operator
 		auto lval = GET_VISIT_SPTR(ctx->LVal);
 		if (lval->type.is_array || !lval->type.is_integer_type() || !lval->type.is_scalar_type())
 			ERROR(ctx, strarg("Operator '%s' is only valid for non-array scalar integer variables.", ctx->Op->getText().c_str()));
-		return lval->text + ctx->Op->getText();
+		auto stmt = module_.new_stmt(ir::StmtKind::Eval, get_line(ctx));
+		stmt->value = module_.new_unary(ir::ParseUnaryOp(ctx->Op->getText(), true), lval->node, lval->type, stmt->line);
+		return stmt;
 	}
 }
 
+// ====================================================================================================================
+VISIT_FUNC(LoopAttribute)
+{
+	auto name = ctx->Name->getText();
+	if (name == "unroll")
+		return ir::LoopHint::Unroll;
+	if (name == "loop")
+		return ir::LoopHint::DontUnroll;
+	ERROR(ctx->Name, strarg("Unknown loop attribute '%s', expected 'unroll' or 'loop'.", name.c_str()));
+	return ir::LoopHint::None;
+}
+
+// ====================================================================================================================
+VISIT_FUNC(BranchAttribute)
+{
+	auto name = ctx->Name->getText();
+	if (name == "branch")
+		return ir::BranchHint::Branch;
+	if (name == "flatten")
+		return ir::BranchHint::Flatten;
+	ERROR(ctx->Name, strarg("Unknown branch attribute '%s', expected 'branch' or 'flatten'.", name.c_str()));
+	return ir::BranchHint::None;
+}
+
 // ====================================================================================================================
 VISIT_FUNC(ControlStatement)
 {
 	if (ctx->KW_BREAK()) { // 'break'
 		if (!variables_.in_loop_block())
 			ERROR(ctx, "'break' statement cannot be used outside of a loop block.");
-		gen_.emit_control_statement("break");
+		emit_stmt(module_.new_stmt(ir::StmtKind::Break, get_line(ctx)));
 	}
 	else if (ctx->KW_CONTINUE()) { // 'continue'
 		if (!variables_.in_loop_block())
 			ERROR(ctx, "'continue' statement cannot be used outside of a loop block.");
-		gen_.emit_control_statement("continue");
+		emit_stmt(module_.new_stmt(ir::StmtKind::Continue, get_line(ctx)));
+	}
+	else if (ctx->KW_RETURN()) { // 'return'
+		if (!current_func_)
+			ERROR(ctx, "'return' statement can only be used inside of user functions.");
+		auto rtype = current_func_->return_type;
+		infer_type_ = rtype;
+		auto val = GET_VISIT_SPTR(ctx->Value);
+		infer_type_ = HLSVType::Error;
+		if (val->type.is_array || !TypeHelper::CanPromoteTo(val->type.type, rtype.type)) {
+			ERROR(ctx->Value, strarg("The return type '%s' cannot be promoted to the function return type '%s'.",
+				val->type.get_type_str().c_str(), rtype.get_type_str().c_str()));
+		}
+		auto stmt = module_.new_stmt(ir::StmtKind::Return, get_line(ctx));
+		stmt->value = (val->type == rtype) ? val->node : module_.new_construct(rtype, { val->node }, stmt->line);
+		emit_stmt(stmt);
 	}
 	else { // 'discard'
 		if (REFL->shader_type != ShaderType::Graphics || current_stage_ != ShaderStages::Fragment)
 			ERROR(ctx, "'discard' statement can only be used inside of fragment shader functions.");
-		gen_.emit_control_statement("discard");
+		auto stmt = module_.new_stmt(ir::StmtKind::Discard, get_line(ctx));
+		emit_stmt(stmt);
+		WARN(ctx, "'discard' disables early depth writes, and can disable early depth testing.", nullptr, stmt);
 	}
 
 	return nullptr;
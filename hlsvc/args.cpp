@@ -48,6 +48,7 @@ Args::Args() :
 	error{ "" },
 	input_files{},
 	help{ false },
+	time{ false },
 	options{ }
 {
 
@@ -84,6 +85,47 @@ bool Args::Parse(int argc, char** argv, Args& args)
 			else if (flag == "i" || flag == "glsl") {
 				args.options.keep_intermediate = true;
 			}
+			else if (flag == "t" || flag == "time") {
+				args.time = true;
+			}
+			else if (flag == "reflect-only") {
+				args.options.reflect_only = true;
+				args.options.generate_reflection_file = true;
+			}
+			else if (flag == "no-opt") {
+				args.options.optimize = false;
+			}
+			else if (flag == "fast-math") {
+				args.options.fast_math = true;
+			}
+			else if (flag == "hoist-vertex") {
+				args.options.hoist_vertex = true;
+			}
+			else if (flag == "pack-locals") {
+				args.options.pack_locals = true;
+			}
+			else if (flag == "strip-attrs") {
+				args.options.strip_attributes = true;
+			}
+			else if (flag == "preshader") {
+				args.options.preshader = true;
+				args.options.generate_reflection_file = true;
+			}
+			else if (flag == "minify") {
+				args.options.minify = true;
+			}
+			else if (flag == "lint") {
+				args.options.lint = true;
+			}
+			else if (flag == "profile") {
+				args.options.profile = true;
+			}
+			else if (flag == "s" || flag == "stream") {
+				args.options.stream_parse = true;
+			}
+			else if (flag == "profile-parser") {
+				args.options.profile_parser = true;
+			}
 			else if (flag.find("rl-") == 0) { // Resource limit flag
 				const std::string rl = flag.substr(3);
 				uint32_t rlval;
@@ -151,7 +193,36 @@ void Args::PrintHelp()
 		"  > -r;--reflect                        Generate a text file that contains shader reflection info.\n"
 		"  > -b;--binary                         Use a binary format for the reflection file instead of text. This\n"
 		"                                          flag will implicity activate the '--reflect' flag.\n"
+		"  > --reflect-only                      Only generates the reflection file, skipping the stage function\n"
+		"                                          bodies and all code generation. Implies '--reflect'.\n"
 		"  > -i;--glsl                           Generates the intermediate cross-compiled GLSL files.\n"
+		"  > --no-opt                            Disables the optimization passes (such as constant folding) on the\n"
+		"                                          stage functions.\n"
+		"  > --fast-math                         Allows float optimizations that can slightly change results, such as\n"
+		"                                          multiplying by the reciprocal instead of dividing by a constant.\n"
+		"  > --hoist-vertex                      Moves fragment expressions that are exact under interpolation into\n"
+		"                                          the vertex stage, using the free local slots to pass the values.\n"
+		"  > --pack-locals                       Packs the small locals into shared binding slots, so more locals fit\n"
+		"                                          within the local slot limit.\n"
+		"  > --strip-attrs                       Removes the vertex attributes that are not used by the vertex stage\n"
+		"                                          from the generated code (they are still in the reflection info).\n"
+		"  > --preshader                         Moves expressions that only use uniforms and push constants into a new\n"
+		"                                          uniform block, which is calculated on the CPU with the bytecode in\n"
+		"                                          the reflection info. Implies '--reflect'.\n"
+		"  > --minify                            Minifies the generated GLSL by removing whitespace, comments, and extra\n"
+		"                                          parentheses, and renaming internal variables and functions.\n"
+		"  > --lint                              Reports warnings for code with known performance problems, such as\n"
+		"                                          discard, dynamic array indexing, and unbounded loops.\n"
+		"  > --profile                           Adds atomic counters to each branch and loop body of the generated\n"
+		"                                          code, in a storage buffer at the last uniform set and binding.\n"
+		"  > -s;--stream                         Parses and processes the source one top-level statement at a time,\n"
+		"                                          which frees the parse tree of each statement after use. The tokens\n"
+		"                                          for the whole file are still kept in memory.\n"
+		"  > -t;--time                           Reports the time taken to compile each file, and the time from\n"
+		"                                          program start to the end of the first compile, and the peak\n"
+		"                                          memory usage.\n"
+		"  > --profile-parser                    Profiles the grammar decisions made while parsing, and reports the\n"
+		"                                          most expensive rules and decisions.\n"
 		"  > --rl-<type> ARG                     Sets the resource limit for the <type>, ARG must be a integer.\n"
 		"                                          <type> must be one of:\n"
 		"                                            attr - The number of vertex attribute slots (default 16)\n"
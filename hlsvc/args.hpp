@@ -24,6 +24,7 @@ public:
 	str error; // The error encountered while parsing the arguments (if Parse() returns false)
 	strvec input_files; // The HLSV source files to compile (will have at least one if no error occurs)
 	bool help;
+	bool time; // If the compile times should be reported
 	hlsv::CompilerOptions options;
 
 public:
@@ -6,18 +6,116 @@
  * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
  */
 
-// This file is the entry point for hlsvc, the reference command line HLSV compiler tool.
+// This file is the entry point for hlsvc, the reference command line HLSV compiler tool. It compiles each input
+//    file, and reports the timing, parser profile, and lint warnings when requested.
 
 #include <hlsv/hlsv.hpp>
 #include <hlsv/hlsv_reflect.hpp>
 #include "console.hpp"
 #include "args.hpp"
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#if defined(HLSV_OS_WIN)
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <Windows.h>
+#	include <Psapi.h>
+#else
+#	include <sys/resource.h>
+#endif // defined(HLSV_OS_WIN)
+
+#define PROFILE_TOP_COUNT (10u)
+
+
+// ====================================================================================================================
+// Gets the peak resident memory usage of the process, in bytes
+static size_t get_peak_memory()
+{
+#if defined(HLSV_OS_WIN)
+	PROCESS_MEMORY_COUNTERS pmc{};
+	if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.PeakWorkingSetSize;
+#else
+	struct rusage ru{};
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+#	if defined(HLSV_OS_OSX)
+	return (size_t)ru.ru_maxrss; // Reported in bytes
+#	else
+	return (size_t)ru.ru_maxrss * 1024; // Reported in kilobytes
+#	endif // defined(HLSV_OS_OSX)
+#endif // defined(HLSV_OS_WIN)
+}
+
+
+// ====================================================================================================================
+static void print_parser_profile(const std::vector<hlsv::DecisionProfile>& profile)
+{
+	using namespace hlsv;
+
+	if (profile.empty()) {
+		Console::Info("No parser profiling information available.");
+		return;
+	}
+
+	// Accumulate the per-rule totals
+	std::map<string, DecisionProfile> rules{};
+	for (const auto& dp : profile) {
+		auto it = rules.find(dp.rule_name);
+		if (it == rules.end()) {
+			rules.insert({ dp.rule_name, dp });
+			continue;
+		}
+		auto& rp = it->second;
+		rp.invocations += dp.invocations;
+		rp.time += dp.time;
+		rp.sll_lookahead += dp.sll_lookahead;
+		rp.sll_max_lookahead = std::max(rp.sll_max_lookahead, dp.sll_max_lookahead);
+		rp.ll_lookahead += dp.ll_lookahead;
+		rp.ll_max_lookahead = std::max(rp.ll_max_lookahead, dp.ll_max_lookahead);
+		rp.ll_fallbacks += dp.ll_fallbacks;
+		rp.ambiguities += dp.ambiguities;
+	}
+	std::vector<DecisionProfile> rulevec{};
+	for (const auto& pair : rules)
+		rulevec.push_back(pair.second);
+	std::sort(rulevec.begin(), rulevec.end(), [](const DecisionProfile& l, const DecisionProfile& r) {
+		return l.time > r.time;
+	});
+
+	// Print the rules, then the top decisions
+	Console::Info("Parser Profile (by rule):");
+	Console::Infof("  %-24s %10s %12s %10s %10s %10s %10s", "Rule", "Calls", "Time (us)", "SLL Look", "LL Look",
+		"Fallbacks", "Ambig.");
+	for (const auto& rp : rulevec) {
+		Console::Infof("  %-24s %10llu %12.2f %10llu %10llu %10llu %10llu", rp.rule_name.c_str(),
+			(unsigned long long)rp.invocations, rp.time / 1000.0, (unsigned long long)rp.sll_lookahead,
+			(unsigned long long)rp.ll_lookahead, (unsigned long long)rp.ll_fallbacks, (unsigned long long)rp.ambiguities);
+	}
+	Console::Infof("Parser Profile (top %u decisions):", PROFILE_TOP_COUNT);
+	Console::Infof("  %-8s %-24s %10s %12s %12s %12s %10s %10s", "Decision", "Rule", "Calls", "Time (us)", "SLL Max/Tot",
+		"LL Max/Tot", "Fallbacks", "Ambig.");
+	uint32 count = 0;
+	for (const auto& dp : profile) {
+		if (count++ == PROFILE_TOP_COUNT)
+			break;
+		auto sll = Console::StrArg("%llu/%llu", (unsigned long long)dp.sll_max_lookahead, (unsigned long long)dp.sll_lookahead);
+		auto ll = Console::StrArg("%llu/%llu", (unsigned long long)dp.ll_max_lookahead, (unsigned long long)dp.ll_lookahead);
+		Console::Infof("  %-8u %-24s %10llu %12.2f %12s %12s %10llu %10llu", dp.decision, dp.rule_name.c_str(),
+			(unsigned long long)dp.invocations, dp.time / 1000.0, sll.c_str(), ll.c_str(), (unsigned long long)dp.ll_fallbacks,
+			(unsigned long long)dp.ambiguities);
+	}
+}
 
 
 int main(int argc, char** argv)
 {
 	using namespace hlsv;
+	using clock = std::chrono::steady_clock;
+	const auto start_time = clock::now();
 
 	// Parse the arguments, print help and exit if requested
 	Args args;
@@ -32,10 +130,22 @@ int main(int argc, char** argv)
 
 	// Compile the input files
 	Compiler comp{};
+	bool first = true;
 	for (const auto& ifile : args.input_files) {
 		Console::Infof("Compiling file %s.", ifile.c_str());
 		Console::UseIndent(true);
-		if (!comp.compile(ifile, args.options)) {
+		const auto comp_start = clock::now();
+		const bool success = comp.compile(ifile, args.options);
+		if (args.time) {
+			const auto comp_end = clock::now();
+			Console::Infof("Compile time: %.3f ms.", std::chrono::duration<double, std::milli>(comp_end - comp_start).count());
+			if (first) {
+				Console::Infof("Time to first compile: %.3f ms.",
+					std::chrono::duration<double, std::milli>(comp_end - start_time).count());
+			}
+		}
+		first = false;
+		if (!success) {
 			// Report the error
 			auto& err = comp.get_last_error();
 			if (err.source == CompilerError::ES_FILEIO) {
@@ -57,9 +167,32 @@ int main(int argc, char** argv)
 
 			Console::Successf("Successfully compiled %s shader (version %u).",
 				(refl.is_graphics() ? "graphics" : "compute"), refl.shader_version);
+			for (const auto& warn : comp.get_warnings()) {
+				auto bt = (warn.bad_text.length() > 12) ? warn.bad_text.substr(0, 9) + "..." : warn.bad_text;
+				Console::Warnf("[%u:%u] '%s' - %s", warn.line, warn.character, bt.c_str(), warn.message.c_str());
+			}
+			for (const auto& ps : refl.perf_stats) {
+				Console::Infof("%s cost: %u (ALU %u, %u samples, %u fetches, %u image loads, %u image stores, "
+					"%u dynamic indices, %u dynamic loops, %u varying bytes%s).",
+					(ps.stage == ShaderStages::Vertex) ? "Vertex" : "Fragment", ps.get_total_cost(), ps.alu_cost,
+					ps.texture_samples, ps.texture_fetches, ps.image_loads, ps.image_stores, ps.dynamic_indexing,
+					ps.dynamic_loops, (uint32)ps.varying_bytes, ps.uses_discard ? ", discards" : "");
+			}
+			if (refl.has_profiling()) {
+				Console::Infof("Added %u profiling counters (set %u, binding %u).", (uint32)refl.profile_counters.size(),
+					(uint32)refl.profile_set, (uint32)refl.profile_binding);
+			}
+			for (const auto& gs : comp.get_glsl_sizes()) {
+				Console::Infof("Minified %s GLSL: %u -> %u bytes (%.1f%% smaller).", gs.stage.c_str(), gs.full_size,
+					gs.minified_size, gs.full_size ? (100.0 * (gs.full_size - gs.minified_size) / gs.full_size) : 0.0);
+			}
 		}
+		if (args.options.profile_parser)
+			print_parser_profile(comp.get_parser_profile());
 		Console::UseIndent(false);
 	}
+	if (args.time)
+		Console::Infof("Peak memory usage: %.2f MB.", get_peak_memory() / (1024.0 * 1024.0));
 
 	return 0;
 }
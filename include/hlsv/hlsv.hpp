@@ -62,7 +62,7 @@
 
 /* Library Version */
 #define HLSV_VERSION_MAJOR 1
-#define HLSV_VERSION_MINOR 0
+#define HLSV_VERSION_MINOR 1
 #define HLSV_VERSION_PATCH 0
 // This is a 3-digit version in the form MajorMinorPatch, similar to how GLSL defines its versions
 #define HLSV_VERSION ((HLSV_VERSION_MAJOR*100)+(HLSV_VERSION_MINOR*10)+HLSV_VERSION_PATCH)
@@ -143,6 +143,38 @@ public:
 	string get_rule_stack_str() const;
 }; // class CompilerError
 
+// Contains information about a non-fatal warning for a likely GPU performance problem in the source code
+struct _EXPORT CompilerWarning final
+{
+	string message;   // The message explaining the problem
+	uint32 line;      // The line that the warning occured on
+	uint32 character; // The character position of the warning
+	string bad_text;  // The source text that generated the warning
+}; // struct CompilerWarning
+
+// Contains profiling information about a single decision point in the HLSV grammar, collected by the parser
+struct _EXPORT DecisionProfile final
+{
+	uint32 decision;          // The index of the decision in the grammar ATN
+	string rule_name;         // The name of the grammar rule that the decision belongs to
+	uint64 invocations;       // The number of times the decision was evaluated
+	uint64 time;              // The total time spent predicting the decision, in nanoseconds
+	uint64 sll_lookahead;     // The total number of tokens looked at during SLL prediction
+	uint64 sll_max_lookahead; // The largest number of tokens looked at by a single SLL prediction
+	uint64 ll_lookahead;      // The total number of tokens looked at during full-context LL prediction
+	uint64 ll_max_lookahead;  // The largest number of tokens looked at by a single full-context LL prediction
+	uint64 ll_fallbacks;      // The number of times SLL prediction failed and fell back to full-context LL prediction
+	uint64 ambiguities;       // The number of ambiguities reported for the decision
+}; // struct DecisionProfile
+
+// The size of the generated GLSL source for a single shader stage, before and after minification
+struct _EXPORT GLSLSizeInfo final
+{
+	string stage;         // The name of the stage ("vert" or "frag")
+	uint32 full_size;     // The size of the source without minification, in bytes
+	uint32 minified_size; // The size of the minified source that was written, in bytes
+}; // struct GLSLSizeInfo
+
 // Forward declare the reflectioninfo type
 class ReflectionInfo;
 
@@ -169,6 +201,29 @@ public:
 	bool generate_reflection_file; // If the reflection info file should be generated
 	bool use_binary_reflection;    // If the reflection info file should be in binary instead of text
 	bool keep_intermediate;	       // If the intermediate GLSL files should be kept (not deleted)
+	bool profile_parser;           // If the parser should collect profiling information about the grammar decisions
+	bool stream_parse;             // If the source should be parsed and visited one top-level statement at a time, which
+	                               //   frees each statement parse tree after use to reduce peak memory usage (the tokens
+	                               //   for the whole file are still kept, so only the parse trees are freed)
+	bool reflect_only;             // If only the reflection info should be generated, skipping the stage function bodies
+	                               //   and all code generation (implies generate_reflection_file)
+	bool optimize;                 // If the optimization passes should be run on the stage functions (default true)
+	bool fast_math;                // If float optimizations that can change results slightly are allowed, such as
+	                               //   replacing division by a constant with multiplication by its reciprocal
+	bool hoist_vertex;             // If fragment expressions that are exact under interpolation are moved to the vertex
+	                               //   stage, using the free local slots to save fragment work (default false)
+	bool pack_locals;              // If the small non-array locals are packed together into shared binding slots, with the
+	                               //   slot limit applied to the packed size (default false)
+	bool strip_attributes;         // If the vertex attributes that the vertex stage does not read are removed from the
+	                               //   generated code, the reflection info marks them as unused either way
+	bool preshader;                // If expressions that only read uniforms and push constants should be moved into a
+	                               //   new uniform block that is calculated on the CPU (see ReflectionInfo::preshader)
+	bool minify;                   // If the generated GLSL is minified, removing whitespace, comments, and redundant
+	                               //   parentheses, and renaming the variables and functions that are not interface names
+	bool lint;                     // If warnings are generated for known GPU performance problems, such as writing
+	                               //   the fragment depth or dynamically indexing arrays (see Compiler::get_warnings())
+	bool profile;                  // If atomic counters are added to each block of the stage functions, in a storage
+	                               //   buffer at the last uniform set and binding (see ReflectionInfo::profile_counters)
 	Limits limits;                 // The resource limits to apply to the shader
 
 public:
@@ -182,6 +237,9 @@ class _EXPORT Compiler final
 private:
 	CompilerError last_error_;
 	ReflectionInfo* reflect_;
+	std::vector<DecisionProfile> parser_profile_;
+	std::vector<GLSLSizeInfo> glsl_sizes_;
+	std::vector<CompilerWarning> warnings_;
 	struct
 	{
 		string input_filename;
@@ -207,6 +265,15 @@ public:
 	inline bool has_error() const { return last_error_.source != CompilerError::ES_NONE; }
 	// Gets the reflection info for the last call to compile(), will only be populated if the compilation was successful
 	inline const ReflectionInfo& get_reflection_info() const { return *reflect_; }
+	// Gets the grammar decision profiling info for the last call to compile(), sorted by descending prediction time
+	// This will only be populated if CompilerOptions::profile_parser was set, and the source was able to be parsed
+	inline const std::vector<DecisionProfile>& get_parser_profile() const { return parser_profile_; }
+	// Gets the size of the GLSL source generated for each stage by the last call to compile()
+	// This will only be populated if CompilerOptions::minify was set, and the compilation was successful
+	inline const std::vector<GLSLSizeInfo>& get_glsl_sizes() const { return glsl_sizes_; }
+	// Gets the performance warnings for the last call to compile(), sorted by source position
+	// This will only be populated if CompilerOptions::lint was set, and the source was able to be compiled
+	inline const std::vector<CompilerWarning>& get_warnings() const { return warnings_; }
 
 	// Compiles the HLSV file with the given options, returning the success as a boolean
 	// If this function returns false, then the last error will be set for the compiler instance
@@ -214,6 +281,9 @@ public:
 
 private:
 	bool preparePaths(const string& file);
+	bool parseFull(void* parser, void* visitor, void* listener);
+	bool parseStreaming(void* parser, void* visitor, void* listener);
+	void collectParserProfile(void* parser); // void* for the same reason as writeGLSL() below
 	bool writeGLSL(void* gen); // void* is a strange choice, but is needed to prevent the private api from leaking into the public one
 	void cleanGLSL();
 }; // class Compiler
@@ -131,16 +131,16 @@ public:
 	               // IMPORTANT: THIS VALUE SHOULD NOT BE LARGER THAN A BYTE, OR ELSE BINARY REFLECTION WILL BREAK
 
 public:
-	HLSVType() :
+	constexpr HLSVType() :
 		type{ Void }, is_array{ false }, count{ 1 }, extra{ 0 }
 	{ }
-	HLSVType(PrimType type) :
+	constexpr HLSVType(PrimType type) :
 		type{ type }, is_array{ false }, count{ 1 }, extra{ 0 }
 	{ }
-	HLSVType(PrimType type, uint8 array_size) :
+	constexpr HLSVType(PrimType type, uint8 array_size) :
 		type{ type }, is_array{ true }, count{ array_size }, extra{ 0 }
 	{ }
-	HLSVType(PrimType type, PrimType fmt) :
+	constexpr HLSVType(PrimType type, PrimType fmt) :
 		type{ type }, is_array{ false }, count{ 1 }, extra{ fmt }
 	{ }
 	HLSVType& operator = (PrimType type) {
@@ -151,15 +151,15 @@ public:
 		return *this;
 	}
 
-	inline bool is_error() const { return type == Error; } // Gets if the type represents a type error
-	inline bool is_value_type() const { return IsValueType(type); }
-	inline bool is_scalar_type() const { return IsScalarType(type); }
-	inline bool is_vector_type() const { return IsVectorType(type); }
-	inline bool is_matrix_type() const { return IsMatrixType(type); }
-	inline bool is_handle_type() const { return IsHandleType(type); }
-	inline bool is_texture_type() const { return IsTextureType(type); }
-	inline bool is_image_type() const { return IsImageType(type); }
-	inline uint8 get_component_count() const { return GetComponentCount(type); }
+	inline constexpr bool is_error() const { return type == Error; } // Gets if the type represents a type error
+	inline constexpr bool is_value_type() const { return IsValueType(type); }
+	inline constexpr bool is_scalar_type() const { return IsScalarType(type); }
+	inline constexpr bool is_vector_type() const { return IsVectorType(type); }
+	inline constexpr bool is_matrix_type() const { return IsMatrixType(type); }
+	inline constexpr bool is_handle_type() const { return IsHandleType(type); }
+	inline constexpr bool is_texture_type() const { return IsTextureType(type); }
+	inline constexpr bool is_image_type() const { return IsImageType(type); }
+	inline constexpr uint8 get_component_count() const { return GetComponentCount(type); }
 	inline PrimType get_component_type() const { return GetComponentType(type); }
 	inline string get_type_str() const { return GetTypeStr(type); }
 	inline uint32 get_slot_size() const { return GetSlotSize(*this); }
@@ -167,28 +167,28 @@ public:
 	inline bool is_floating_point_type() const { return IsFloatingPointType(type); }
 	inline bool is_boolean_type() const { return IsBooleanType(type); }
 	
-	inline static bool IsValueType(enum PrimType t) {
+	inline static constexpr bool IsValueType(enum PrimType t) {
 		return (t >= VECTOR_TYPE_START && t <= VECTOR_TYPE_END) || (t >= MATRIX_TYPE_START && t <= MATRIX_TYPE_END);
 	}
-	inline static bool IsScalarType(enum PrimType t) {
+	inline static constexpr bool IsScalarType(enum PrimType t) {
 		return (t >= VECTOR_TYPE_START && t <= VECTOR_TYPE_END) && ((t % 4) == 1);
 	}
-	inline static bool IsVectorType(enum PrimType t) {
+	inline static constexpr bool IsVectorType(enum PrimType t) {
 		return (t >= VECTOR_TYPE_START && t <= VECTOR_TYPE_END) && ((t % 4) != 1);
 	}
-	inline static bool IsMatrixType(enum PrimType t) {
+	inline static constexpr bool IsMatrixType(enum PrimType t) {
 		return (t >= MATRIX_TYPE_START && t <= MATRIX_TYPE_END);
 	}
-	inline static bool IsHandleType(enum PrimType t) {
+	inline static constexpr bool IsHandleType(enum PrimType t) {
 		return (t >= HANDLE_TYPE_START && t <= HANDLE_TYPE_END);
 	}
-	inline static bool IsTextureType(enum PrimType t) {
+	inline static constexpr bool IsTextureType(enum PrimType t) {
 		return (t >= TEXTURE_TYPE_START && t <= TEXTURE_TYPE_END);
 	}
-	inline static bool IsImageType(enum PrimType t) {
+	inline static constexpr bool IsImageType(enum PrimType t) {
 		return (t >= IMAGE_TYPE_START && t <= IMAGE_TYPE_END);
 	}
-	inline static uint8 GetComponentCount(enum PrimType t) {
+	inline static constexpr uint8 GetComponentCount(enum PrimType t) {
 		if (IsHandleType(t)) return 1u;
 		if (IsMatrixType(t)) return (t == Mat2) ? 4u : (t == Mat3) ? 9u : 16u;
 		return (((t - 1) % 4) + 1);
@@ -211,7 +211,7 @@ public:
 		auto rc = GetComponentType(r);
 		return lc > rc ? lc : rc;
 	}
-	inline static PrimType MakeVectorType(enum PrimType comp, uint8 count) {
+	inline static constexpr PrimType MakeVectorType(enum PrimType comp, uint8 count) {
 		return (PrimType)(comp + (count - 1));
 	}
 }; // struct HLSVType
@@ -233,9 +233,10 @@ struct _EXPORT Attribute final
 	HLSVType type;    // The attribute type information
 	uint8 location;   // The binding location of the attribute
 	uint8 slot_count; // The number of binding slots taken by the attribute
+	bool used;        // If the vertex stage reads the attribute, unused attributes do not need a vertex buffer binding
 
 	Attribute(const string& name, HLSVType type, uint8 l, uint8 sc) :
-		name{ name }, type{ type }, location{ l }, slot_count{ sc }
+		name{ name }, type{ type }, location{ l }, slot_count{ sc }, used{ true }
 	{ }
 }; // struct Attribute
 
@@ -251,6 +252,20 @@ struct _EXPORT Output final
 	{ }
 }; // struct Output
 
+// Contains information about a local, which passes values from the vertex stage to the fragment stage
+struct _EXPORT Local final
+{
+	string name;
+	HLSVType type;
+	uint8 location;  // The first binding slot of the local
+	uint8 component; // The first component used in the binding slot, which is only non-zero for packed locals
+	bool flat;       // If the local is not interpolated
+
+	Local(const string& name, HLSVType type, uint8 l, uint8 c, bool f) :
+		name{ name }, type{ type }, location{ l }, component{ c }, flat{ f }
+	{ }
+}; // struct Local
+
 // Contains information about a shader uniform
 struct _EXPORT Uniform final
 {
@@ -264,9 +279,10 @@ struct _EXPORT Uniform final
 		uint16 offset; // The offset of the uniform within its block, in bytes
 		uint16 size;   // The size of the uniform within its block, in bytes
 	} block; // Contains block information, only valid for value-type uniforms inside of blocks
+	ShaderStages stage_mask; // The stages that use the uniform
 
 	Uniform(const string& name, HLSVType type, uint8 s, uint8 b, uint8 bl, uint16 o, uint16 sz) :
-		name{ name }, type{ type }, set{ s }, binding{ b }, block{ bl, o, sz }
+		name{ name }, type{ type }, set{ s }, binding{ b }, block{ bl, o, sz }, stage_mask{ ShaderStages::None }
 	{ }
 }; // struct Uniform
 
@@ -278,9 +294,10 @@ struct _EXPORT UniformBlock final
 	uint16 size;				// Total size of the block in bytes
 	bool packed;				// If the members in the block are tightly packed
 	std::vector<uint8> members; // The indices into the reflection uniforms array for the members of this block
+	ShaderStages stage_mask;    // The stages that use any member of the block
 
 	UniformBlock(uint8 s, uint8 b) :
-		set{ s }, binding{ b }, size{ 0 }, packed{ false }, members{ }
+		set{ s }, binding{ b }, size{ 0 }, packed{ false }, members{ }, stage_mask{ ShaderStages::None }
 	{ }
 }; // struct UniformBlock
 
@@ -291,9 +308,10 @@ struct _EXPORT PushConstant final
 	HLSVType type;
 	uint16 offset;
 	uint16 size;
+	ShaderStages stage_mask; // The stages that use the push constant, for building the per-stage push constant ranges
 
 	PushConstant(const string& name, HLSVType type, uint16 o, uint16 s) :
-		name{ name }, type{ type }, offset{ o }, size{ s }
+		name{ name }, type{ type }, offset{ o }, size{ s }, stage_mask{ ShaderStages::None }
 	{ }
 }; // struct PushConstant
 
@@ -310,12 +328,80 @@ struct _EXPORT SpecConstant final
 		int32 si;  // The default signed integer value
 		uint32 ui; // The default unsigned integer value
 	} default_value; // The default value for the spec constant
+	ShaderStages stage_mask; // The stages that use the spec constant
 
 	SpecConstant(const string& name, HLSVType type, uint8 i, uint16 s) :
-		name{ name }, type{ type }, index{ i }, size{ s }, default_value{ 0u }
+		name{ name }, type{ type }, index{ i }, size{ s }, default_value{ 0u }, stage_mask{ ShaderStages::None }
 	{ }
 }; // struct SpecConstant
 
+// Contains information about a value calculated on the CPU from other uniforms and push constants, which is stored in
+//    the preshader uniform block
+struct _EXPORT PreshaderValue final
+{
+	HLSVType type;
+	uint16 offset;           // The offset of the value within the preshader block, in bytes
+	std::vector<uint8> code; // The bytecode that calculates the value
+
+	PreshaderValue(HLSVType type, uint16 o) :
+		type{ type }, offset{ o }, code{ }
+	{ }
+}; // struct PreshaderValue
+
+// Contains the static cost estimate of a single shader stage, which is calculated from the generated code without
+//    running it, so the bodies of loops without a constant trip count are only counted once
+struct _EXPORT PerfStats final
+{
+	static constexpr uint32 SAMPLE_COST = 16; // The cost of a filtered texture sample, in arithmetic units
+	static constexpr uint32 MEMORY_COST = 8;  // The cost of an unfiltered texel fetch, or an image load or store
+	static constexpr uint32 INDEX_COST = 2;   // The cost of a dynamic array index, in arithmetic units
+
+	ShaderStages stage;
+	uint32 alu_cost;         // The arithmetic cost, in multiply-add units (transcendental functions cost more)
+	uint32 texture_samples;  // The number of filtered texture samples
+	uint32 texture_fetches;  // The number of unfiltered texel fetches and subpass input loads
+	uint32 image_loads;      // The number of storage image loads
+	uint32 image_stores;     // The number of storage image stores
+	uint32 dynamic_indexing; // The number of array indexing operations with non-constant indices
+	uint32 dynamic_loops;    // The number of loops that do not have a constant trip count
+	bool uses_discard;       // If the stage can discard fragments, which can disable early depth testing
+	uint16 varying_bytes;    // The size of the locals that are written (vertex) or read (fragment) by the stage
+
+	PerfStats(ShaderStages s) :
+		stage{ s }, alu_cost{ 0 }, texture_samples{ 0 }, texture_fetches{ 0 }, image_loads{ 0 }, image_stores{ 0 },
+		dynamic_indexing{ 0 }, dynamic_loops{ 0 }, uses_discard{ false }, varying_bytes{ 0 }
+	{ }
+
+	// Gets the single budget number for the stage, with the memory accesses converted into arithmetic units
+	inline uint32 get_total_cost() const {
+		return alu_cost + (texture_samples * SAMPLE_COST) + ((texture_fetches + image_loads + image_stores) * MEMORY_COST) +
+			(dynamic_indexing * INDEX_COST);
+	}
+}; // struct PerfStats
+
+// Contains the source location of a profiling counter, for shaders compiled with profiling instrumentation
+struct _EXPORT ProfileCounter final
+{
+	uint32 line;        // The source line of the first statement in the block that increments the counter
+	ShaderStages stage; // The stages that run the block (more than one for blocks in user functions)
+
+	ProfileCounter(uint32 l, ShaderStages s) :
+		line{ l }, stage{ s }
+	{ }
+}; // struct ProfileCounter
+
+// A single source line in a profiling report, with the total count of the blocks that start on the line
+struct _EXPORT ProfileLine final
+{
+	uint32 line;
+	ShaderStages stage;
+	uint64 count; // The number of times the blocks on the line were run
+
+	ProfileLine(uint32 l, ShaderStages s) :
+		line{ l }, stage{ s }, count{ 0 }
+	{ }
+}; // struct ProfileLine
+
 // The core reflection type that contains all reflection information about an HSLV shader
 class _EXPORT ReflectionInfo final
 {
@@ -326,12 +412,20 @@ public:
 	ShaderStages stages;    // The stages that are present in the shader
 	std::vector<Attribute> attributes; // The vertex attributes for the shader
 	std::vector<Output> outputs;       // The fragment outputs for the shader
+	std::vector<Local> locals;         // The locals passed between the stages of the shader
 	std::vector<Uniform> uniforms;     // The uniforms for the shader
 	std::vector<UniformBlock> blocks;  // The uniform blocks for the shader
 	std::vector<PushConstant> push_constants; // The push constants for the shader
 	std::vector<SpecConstant> spec_constants; // The specialization constants for the shader
 	bool push_constants_packed; // If the push constants are tightly packed
 	uint16 push_constants_size; // The total size of the push constant block, in bytes
+	std::vector<PreshaderValue> preshader; // The values calculated on the CPU, empty if the preshader was not generated
+	uint8 preshader_set;     // The uniform set of the preshader block
+	uint8 preshader_binding; // The uniform binding of the preshader block
+	std::vector<PerfStats> perf_stats; // The static cost estimate of each stage, empty for reflection-only compiles
+	std::vector<ProfileCounter> profile_counters; // The locations of the profiling counters, in counter buffer order
+	uint8 profile_set;     // The uniform set of the profiling counter storage buffer
+	uint8 profile_binding; // The uniform binding of the profiling counter storage buffer
 
 public:
 	ReflectionInfo(ShaderType type, uint32 tv, uint32 sv);
@@ -343,6 +437,8 @@ public:
 	inline bool is_graphics() const { return shader_type == ShaderType::Graphics; }
 
 	inline bool has_push_constants() const { return push_constants.size() > 0; }
+	inline bool has_preshader() const { return preshader.size() > 0; }
+	inline bool has_profiling() const { return profile_counters.size() > 0; }
 
 	// Gets the highest binding slot that is occupied by the vertex attributes of the shader
 	uint32 get_highest_attr_slot() const;
@@ -350,6 +446,19 @@ public:
 	const Uniform* get_uniform_at(uint32 set, uint32 binding) const;
 	// Gets the subpass input for the given index, or nullptr if there is not one
 	const Uniform* get_subpass_input(uint32 index) const;
+	// Calculates the preshader block contents from the uniform block data (in the same order as the blocks vector, the
+	//    entry for the preshader block is ignored) and the push constant data, which must be updated whenever any of
+	//    the input values change. Values that are undefined in GLSL (such as division by zero) are written as zero, and
+	//    cause the function to return false.
+	bool evaluate_preshader(const void* const* block_data, const void* push_data, void* preshader_data) const;
+	// Builds the hot-line report from the contents of the profiling counter buffer read back from the device, which
+	//    must contain a value for each of the profile counters. The lines are sorted by count, the highest first, and
+	//    lines that never ran are skipped.
+	std::vector<ProfileLine> get_profile_report(const uint32* counter_data) const;
+
+	// Checks that the data starts with a valid binary reflection header written by this version of the library. The
+	//    binary layout can change between versions, so files with a different version must be regenerated, not read.
+	static bool CheckBinaryHeader(const void* data, size_t size);
 }; // class ReflectionInfo
 
 } // namespace hlsv
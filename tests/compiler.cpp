@@ -0,0 +1,298 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests that run the full compiler on shader source files
+
+#include "test.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Builds a shader with the given number of user functions, all called from the fragment stage
+static string make_shader(uint32 func_count)
+{
+	std::stringstream ss{ };
+	ss << "shader 100 graphics;\n"
+		"attr(0) float3 pos;\n"
+		"attr(1) float2 uv;\n"
+		"local float2 v_uv;\n"
+		"frag(0) float4 color;\n"
+		"unif(0, 0) tex2D diffuse;\n"
+		"unif(0, 1) block { mat4 mvp; float4 tint; };\n"
+		"const float SCALE = 2.0;\n";
+	for (uint32 i = 0; i < func_count; ++i)
+		ss << "float shade" << i << "(float x) { return x * SCALE + " << i << ".0; }\n";
+	ss << "@vert {\n"
+		"\t$Position = mvp * float4(pos, 1.0);\n"
+		"\tv_uv = uv;\n"
+		"}\n"
+		"@frag {\n"
+		"\tfloat4 c = load(diffuse, v_uv) * tint;\n"
+		"\tfor (int i = 0; i < 4; i++) {\n"
+		"\t\tc.x += float(i);\n"
+		"\t}\n";
+	for (uint32 i = 0; i < func_count; ++i)
+		ss << "\tc.y += shade" << i << "(c.x);\n";
+	ss << "\tcolor = c;\n"
+		"}\n";
+	return ss.str();
+}
+
+// ====================================================================================================================
+static string read_file(const string& path)
+{
+	std::ifstream file{ path, std::ios::in | std::ios::binary };
+	std::stringstream ss{ };
+	ss << file.rdbuf();
+	return ss.str();
+}
+
+// ====================================================================================================================
+// Compiles the file, and returns the generated GLSL and text reflection info
+static bool compile_outputs(const string& path, bool stream, string& out)
+{
+	CompilerOptions options{ };
+	options.keep_intermediate = true;
+	options.generate_reflection_file = true;
+	options.stream_parse = stream;
+	Compiler comp{ };
+	if (!comp.compile(path, options))
+		return false;
+	out = read_file("hlsvtest_stream.vert") + read_file("hlsvtest_stream.frag") + read_file("hlsvtest_stream.refl");
+	std::remove("hlsvtest_stream.vert");
+	std::remove("hlsvtest_stream.frag");
+	std::remove("hlsvtest_stream.refl");
+	return true;
+}
+
+// ====================================================================================================================
+TEST(stream_parse_matches_full_parse)
+{
+	const string path{ "hlsvtest_stream.hlsv" };
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::trunc };
+		file << make_shader(32);
+	}
+	string full{ }, streamed{ };
+	bool full_ok = compile_outputs(path, false, full);
+	bool stream_ok = compile_outputs(path, true, streamed);
+	std::remove(path.c_str());
+	CHECK(full_ok && stream_ok);
+	CHECK(!full.empty());
+	CHECK(full == streamed);
+}
+
+// ====================================================================================================================
+// Compiles the source text, and gets the generated GLSL for each stage if the compile succeeded
+static bool compile_source(Compiler& comp, const string& src, CompilerOptions options, string* vert = nullptr,
+	string* frag = nullptr)
+{
+	const string path{ "hlsvtest_source.hlsv" };
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::trunc };
+		file << src;
+	}
+	options.keep_intermediate = true;
+	bool ok = comp.compile(path, options);
+	if (ok && vert)
+		*vert = read_file("hlsvtest_source.vert");
+	if (ok && frag)
+		*frag = read_file("hlsvtest_source.frag");
+	std::remove(path.c_str());
+	std::remove("hlsvtest_source.vert");
+	std::remove("hlsvtest_source.frag");
+	return ok;
+}
+
+// ====================================================================================================================
+// A shader where each resource is only used by one stage, except for the block that both stages read from
+static const string STAGE_SHADER =
+	"shader 100 graphics;\n"
+	"attr(0) float3 pos;\n"
+	"attr(1) float2 uv;\n"
+	"attr(2) float3 unused_nrm;\n"
+	"local float2 v_uv;\n"
+	"frag(0) float4 color;\n"
+	"unif(0, 0) tex2D diffuse;\n"
+	"unif(0, 1) block { mat4 mvp; float4 tint; };\n"
+	"push block { float4 push_vert; float4 push_frag; };\n"
+	"@vert {\n"
+	"\t$Position = mvp * float4(pos, 1.0) + push_vert;\n"
+	"\tv_uv = uv;\n"
+	"}\n"
+	"@frag {\n"
+	"\tcolor = load(diffuse, v_uv) * tint + push_frag;\n"
+	"}\n";
+
+// ====================================================================================================================
+TEST(compile_resource_stage_masks)
+{
+	Compiler comp{ };
+	string vert{ }, frag{ };
+	CHECK(compile_source(comp, STAGE_SHADER, CompilerOptions{ }, &vert, &frag));
+	const auto& refl = comp.get_reflection_info();
+	auto uniform_mask = [&refl](const string& name) {
+		for (const auto& uni : refl.uniforms) {
+			if (uni.name == name)
+				return uni.stage_mask;
+		}
+		return ShaderStages::None;
+	};
+	auto push_mask = [&refl](const string& name) {
+		for (const auto& pc : refl.push_constants) {
+			if (pc.name == name)
+				return pc.stage_mask;
+		}
+		return ShaderStages::None;
+	};
+	CHECK(uniform_mask("diffuse") == ShaderStages::Fragment);
+	CHECK(uniform_mask("mvp") == ShaderStages::Vertex && uniform_mask("tint") == ShaderStages::Fragment);
+	CHECK(refl.blocks.size() == 1 && refl.blocks[0].stage_mask == (ShaderStages::Vertex | ShaderStages::Fragment));
+	CHECK(push_mask("push_vert") == ShaderStages::Vertex && push_mask("push_frag") == ShaderStages::Fragment);
+
+	// Blocks are declared whole in each stage that uses them, the other resources only where they are used
+	CHECK(vert.find("diffuse") == string::npos && frag.find("diffuse") != string::npos);
+	CHECK(vert.find("tint") != string::npos && frag.find("mvp") != string::npos);
+	CHECK(vert.find("push_frag") == string::npos && frag.find("push_vert") == string::npos);
+	CHECK(vert.find("layout(offset = 0) vec4 push_vert") != string::npos);
+	CHECK(frag.find("layout(offset = 16) vec4 push_frag") != string::npos);
+}
+
+// ====================================================================================================================
+TEST(compile_unused_attributes)
+{
+	// The unused attribute is reported, and only removed from the GLSL when stripping
+	for (bool strip : { false, true }) {
+		Compiler comp{ };
+		CompilerOptions options{ };
+		options.strip_attributes = strip;
+		string vert{ };
+		CHECK(compile_source(comp, STAGE_SHADER, options, &vert));
+		const auto& attrs = comp.get_reflection_info().attributes;
+		CHECK(attrs.size() == 3);
+		for (const auto& attr : attrs)
+			CHECK(attr.used == (attr.name != "unused_nrm"));
+		CHECK(vert.find("in vec3 pos;") != string::npos);
+		CHECK((vert.find("unused_nrm") == string::npos) == strip);
+	}
+}
+
+// ====================================================================================================================
+// The small locals can share slots, but only with the same component type and interpolation
+static const string PACK_SHADER =
+	"shader 100 graphics;\n"
+	"attr(0) float3 pos;\n"
+	"attr(1) float2 uv;\n"
+	"local float la;\n"
+	"local float lb;\n"
+	"local flat float lc;\n"
+	"local int ld;\n"
+	"local float2 le;\n"
+	"local float4 lf;\n"
+	"frag(0) float4 color;\n"
+	"@vert {\n"
+	"\t$Position = float4(pos, 1.0);\n"
+	"\tla = pos.x;\n"
+	"\tlb = pos.y;\n"
+	"\tlc = pos.z;\n"
+	"\tld = int(uv.x);\n"
+	"\tle = uv;\n"
+	"\tlf = float4(pos, uv.y);\n"
+	"}\n"
+	"@frag {\n"
+	"\tcolor = lf + float4(le, la + lb, lc + float(ld));\n"
+	"}\n";
+
+// ====================================================================================================================
+TEST(compile_packed_locals)
+{
+	Compiler comp{ };
+	CompilerOptions options{ };
+	options.pack_locals = true;
+	string vert{ };
+	CHECK(compile_source(comp, PACK_SHADER, options, &vert));
+	const auto& locals = comp.get_reflection_info().locals;
+	auto check_local = [&locals](const string& name, uint32 loc, uint32 comp, bool flat) {
+		for (const auto& local : locals) {
+			if (local.name == name)
+				return local.location == loc && local.component == comp && local.flat == flat;
+		}
+		return false;
+	};
+	// The attributes end at slot 1, the full slot local comes first, then the others largest first
+	CHECK(locals.size() == 6);
+	CHECK(check_local("lf", 2, 0, false));
+	CHECK(check_local("le", 3, 0, false) && check_local("la", 3, 2, false) && check_local("lb", 3, 3, false));
+	CHECK(check_local("lc", 4, 0, true)); // Flat floats do not share with interpolated floats
+	CHECK(check_local("ld", 5, 0, true)); // Integers do not share with floats
+	CHECK(vert.find("layout(location = 3, component = 2) out float la;") != string::npos);
+
+	// Without packing each local gets its own slots
+	Compiler plain{ };
+	CHECK(compile_source(plain, PACK_SHADER, CompilerOptions{ }, &vert));
+	CHECK(vert.find("component") == string::npos);
+	CHECK(plain.get_reflection_info().locals.size() == 6);
+
+	// The limit is checked against the packed slots
+	Compiler limited{ };
+	options.limits.local_slots = 3;
+	CHECK(!compile_source(limited, PACK_SHADER, options));
+	CHECK(limited.get_last_error().message == "The locals use 4 slots after packing, only 3 slots are available.");
+	options.limits.local_slots = 4;
+	CHECK(compile_source(limited, PACK_SHADER, options));
+}
+
+// ====================================================================================================================
+// The loop on line 13 and the discard on line 17 are reported, the discard on line 20 is removed as dead code
+static const string LINT_SHADER =
+	"shader 100 graphics;\n"
+	"attr(0) float3 pos;\n"
+	"local float2 v_uv;\n"
+	"frag(0) float4 color;\n"
+	"unif(0, 0) tex2D diffuse;\n"
+	"@vert {\n"
+	"\t$Position = float4(pos, 1.0);\n"
+	"\tv_uv = pos.xy;\n"
+	"}\n"
+	"@frag {\n"
+	"\tfloat4 c = load(diffuse, v_uv);\n"
+	"\tfloat x = c.x;\n"
+	"\twhile (x < 1.0) {\n"
+	"\t\tx += 0.25;\n"
+	"\t}\n"
+	"\tif (c.w < 0.5) {\n"
+	"\t\tdiscard;\n"
+	"\t}\n"
+	"\tif (false) {\n"
+	"\t\tdiscard;\n"
+	"\t}\n"
+	"\tcolor = c * x;\n"
+	"}\n";
+
+// ====================================================================================================================
+TEST(compile_lint_warnings)
+{
+	Compiler comp{ };
+	CompilerOptions options{ };
+	options.lint = true;
+	CHECK(compile_source(comp, LINT_SHADER, options));
+	const auto& warns = comp.get_warnings();
+	CHECK(warns.size() == 2);
+	CHECK(warns[0].line == 13 && warns[0].message.find("'while' loop") != string::npos);
+	CHECK(warns[1].line == 17 && warns[1].message.find("'discard'") != string::npos);
+
+	// The warnings are only collected with lint enabled
+	Compiler quiet{ };
+	CHECK(compile_source(quiet, LINT_SHADER, CompilerOptions{ }));
+	CHECK(quiet.get_warnings().empty());
+}
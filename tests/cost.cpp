@@ -0,0 +1,64 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the static cost estimate
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(cost_small_function)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto m = ir.sym("m", HLSVType::Mat4, VarScope::Uniform), v = ir.sym("v", HLSVType::Float4, VarScope::Uniform);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Uniform), b = ir.sym("b", HLSVType::Float, VarScope::Uniform);
+	auto tex = ir.sym("tex", HLSVType::Tex2D, VarScope::Uniform);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Uniform);
+	auto u = ir.sym("u", HLSVType::Int, VarScope::Uniform);
+	auto l = ir.sym("l", HLSVType::Float3, VarScope::Local);
+	auto o4 = ir.sym("o4", HLSVType::Float4, VarScope::Output), o = ir.sym("o", HLSVType::Float, VarScope::Output);
+
+	ir.assign(func->body, ir.var(o4), ir.bin(ir::Op::Mul, ir.var(m), ir.var(v), HLSVType::Float4)); // 16
+	ir.assign(func->body, ir.var(o), ir.bin(ir::Op::Div, ir.var(a), ir.var(b), HLSVType::Float)); // 4
+	ir.assign(func->body, ir.var(o4), ir.call("sin", HLSVType::Float4, { ir.var(v) })); // 4 components * 4
+	ir.assign(func->body, ir.var(o4), ir.call("texture", HLSVType::Float4, { ir.var(tex), ir.var(v) })); // Sample
+	ir.assign(func->body, ir.var(o), ir.index(ir.var(arr), ir.var(u), HLSVType::Float)); // Dynamic index
+
+	// for (int i = 0; i < 4; i++) { o += a * b; } -- (1 compare + 1 increment + 2 for the body) * 4 trips
+	auto i = ir.sym("i", HLSVType::Int);
+	auto loop = ir.loop(func->body, ir::StmtKind::For, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(4), HLSVType::Bool));
+	loop->symbol = i;
+	loop->init = ir.lit(0);
+	auto inc = ir.module.new_stmt(ir::StmtKind::Eval, 1);
+	inc->value = ir.module.new_unary(ir::Op::PostInc, ir.var(i), HLSVType::Int, 1);
+	loop->updates.append(inc);
+	ir.assign(loop->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float), ir::Op::Add);
+
+	// while (o < 1.0) { o += 1.0; } -- counted once, as a dynamic loop
+	auto wl = ir.loop(func->body, ir::StmtKind::While, ir.bin(ir::Op::Lt, ir.var(o), ir.lit(1.0f), HLSVType::Bool));
+	ir.assign(wl->body, ir.var(o), ir.lit(1.0f), ir::Op::Add);
+
+	// if (a > b) { discard; } o += l.x;
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(a), ir.var(b), HLSVType::Bool));
+	br->body.append(ir.module.new_stmt(ir::StmtKind::Discard, 1));
+	uint8 x[1] = { 0 };
+	ir.assign(func->body, ir.var(o), ir.module.new_swizzle(ir.var(l), x, 1, HLSVType::Float, 1));
+
+	auto stats = ir::EstimateCost(ir.module, *func);
+	CHECK(stats.stage == ShaderStages::Fragment);
+	CHECK(stats.alu_cost == (16 + 4 + 16 + 16 + 2 + 1));
+	CHECK(stats.texture_samples == 1 && stats.texture_fetches == 0);
+	CHECK(stats.image_loads == 0 && stats.image_stores == 0);
+	CHECK(stats.dynamic_indexing == 1 && stats.dynamic_loops == 1);
+	CHECK(stats.uses_discard);
+	CHECK(stats.varying_bytes == 12);
+}
@@ -0,0 +1,271 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the constant evaluator and the constant folding pass
+
+#include "test.hpp"
+#include "ir/eval.hpp"
+#include <cmath>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// A single evaluation, and the expected value of one component if it can be folded
+struct EvalCase final
+{
+	const char* desc;
+	ir::Expr* (*build)(IRBuilder& ir);
+	bool folds;
+	HLSVType::PrimType type;
+	uint32 comp;
+	double value;
+};
+
+// Short names for building the cases
+static ir::Expr* U(IRBuilder& ir, uint32 u) { return ir.module.new_literal(u, 1); }
+static ir::Expr* B(IRBuilder& ir, bool b) { return ir.module.new_literal(b, 1); }
+static ir::Expr* V(IRBuilder& ir, HLSVType type, const std::vector<ir::Expr*>& args) {
+	return ir.module.new_construct(type, args, 1);
+}
+static ir::Expr* F3(IRBuilder& ir) { return V(ir, HLSVType::Float3, { ir.lit(1.0f), ir.lit(2.0f), ir.lit(3.0f) }); }
+static ir::Expr* M2(IRBuilder& ir) { // Columns (1, 2) and (3, 4)
+	return V(ir, HLSVType::Mat2, { ir.lit(1.0f), ir.lit(2.0f), ir.lit(3.0f), ir.lit(4.0f) });
+}
+
+// The cases, including the ones that must not fold because the result is undefined or cannot be written as a literal
+static const EvalCase EVAL_CASES[] = {
+	// Integer arithmetic
+	{ "2 + 3", [](IRBuilder& ir) { return ir.bin(ir::Op::Add, ir.lit(2), ir.lit(3), HLSVType::Int); },
+		true, HLSVType::Int, 0, 5 },
+	{ "int max + 1 wraps", [](IRBuilder& ir) {
+		return ir.bin(ir::Op::Add, ir.lit(INT32_MAX), ir.lit(1), HLSVType::Int); }, true, HLSVType::Int, 0, INT32_MIN },
+	{ "-7 / 2 truncates", [](IRBuilder& ir) { return ir.bin(ir::Op::Div, ir.lit(-7), ir.lit(2), HLSVType::Int); },
+		true, HLSVType::Int, 0, -3 },
+	{ "1 / 0", [](IRBuilder& ir) { return ir.bin(ir::Op::Div, ir.lit(1), ir.lit(0), HLSVType::Int); },
+		false, HLSVType::Int, 0, 0 },
+	{ "int min / -1", [](IRBuilder& ir) { return ir.bin(ir::Op::Div, ir.lit(INT32_MIN), ir.lit(-1), HLSVType::Int); },
+		false, HLSVType::Int, 0, 0 },
+	{ "7 % 3", [](IRBuilder& ir) { return ir.bin(ir::Op::Mod, ir.lit(7), ir.lit(3), HLSVType::Int); },
+		true, HLSVType::Int, 0, 1 },
+	{ "-7 % 3", [](IRBuilder& ir) { return ir.bin(ir::Op::Mod, ir.lit(-7), ir.lit(3), HLSVType::Int); },
+		false, HLSVType::Int, 0, 0 },
+	{ "-8 >> 1 sign extends", [](IRBuilder& ir) { return ir.bin(ir::Op::Shr, ir.lit(-8), ir.lit(1), HLSVType::Int); },
+		true, HLSVType::Int, 0, -4 },
+	{ "1u << 32", [](IRBuilder& ir) { return ir.bin(ir::Op::Shl, U(ir, 1), U(ir, 32), HLSVType::UInt); },
+		false, HLSVType::UInt, 0, 0 },
+	{ "1 << -1", [](IRBuilder& ir) { return ir.bin(ir::Op::Shl, ir.lit(1), ir.lit(-1), HLSVType::Int); },
+		false, HLSVType::Int, 0, 0 },
+	{ "0u - 1u wraps", [](IRBuilder& ir) { return ir.bin(ir::Op::Sub, U(ir, 0), U(ir, 1), HLSVType::UInt); },
+		true, HLSVType::UInt, 0, 4294967295.0 },
+	// Float arithmetic
+	{ "1.0 / 0.0", [](IRBuilder& ir) { return ir.bin(ir::Op::Div, ir.lit(1.0f), ir.lit(0.0f), HLSVType::Float); },
+		false, HLSVType::Float, 0, 0 },
+	{ "3e38 * 10 overflows", [](IRBuilder& ir) {
+		return ir.bin(ir::Op::Mul, ir.lit(3e38f), ir.lit(10.0f), HLSVType::Float); }, false, HLSVType::Float, 0, 0 },
+	{ "2 + 0.5 promotes", [](IRBuilder& ir) { return ir.bin(ir::Op::Add, ir.lit(2), ir.lit(0.5f), HLSVType::Float); },
+		true, HLSVType::Float, 0, 2.5 },
+	{ "1 < 2.5", [](IRBuilder& ir) { return ir.bin(ir::Op::Lt, ir.lit(1), ir.lit(2.5f), HLSVType::Bool); },
+		true, HLSVType::Bool, 0, 1 },
+	{ "-2.0", [](IRBuilder& ir) { return ir.module.new_unary(ir::Op::Neg, ir.lit(2.0f), HLSVType::Float, 1); },
+		true, HLSVType::Float, 0, -2 },
+	// Conversions
+	{ "int(2.9)", [](IRBuilder& ir) { return V(ir, HLSVType::Int, { ir.lit(2.9f) }); }, true, HLSVType::Int, 0, 2 },
+	{ "int(-2.9)", [](IRBuilder& ir) { return V(ir, HLSVType::Int, { ir.lit(-2.9f) }); }, true, HLSVType::Int, 0, -2 },
+	{ "int(3e9)", [](IRBuilder& ir) { return V(ir, HLSVType::Int, { ir.lit(3e9f) }); }, false, HLSVType::Int, 0, 0 },
+	{ "uint(-1.0)", [](IRBuilder& ir) { return V(ir, HLSVType::UInt, { ir.lit(-1.0f) }); },
+		false, HLSVType::UInt, 0, 0 },
+	{ "uint(-1)", [](IRBuilder& ir) { return V(ir, HLSVType::UInt, { ir.lit(-1) }); },
+		true, HLSVType::UInt, 0, 4294967295.0 },
+	{ "bool(2)", [](IRBuilder& ir) { return V(ir, HLSVType::Bool, { ir.lit(2) }); }, true, HLSVType::Bool, 0, 1 },
+	{ "float(4000000000u)", [](IRBuilder& ir) { return V(ir, HLSVType::Float, { U(ir, 4000000000u) }); },
+		true, HLSVType::Float, 0, 4e9 },
+	// Vectors and matrices
+	{ "float3(1, 2, 3) * 2", [](IRBuilder& ir) { return ir.bin(ir::Op::Mul, F3(ir), ir.lit(2.0f), HLSVType::Float3); },
+		true, HLSVType::Float3, 2, 6 },
+	{ "float2(1).y", [](IRBuilder& ir) { return V(ir, HLSVType::Float2, { ir.lit(1.0f) }); },
+		true, HLSVType::Float2, 1, 1 },
+	{ "float3(int2, 5)", [](IRBuilder& ir) {
+		return V(ir, HLSVType::Float3, { V(ir, HLSVType::Int2, { ir.lit(3), ir.lit(4) }), ir.lit(5) }); },
+		true, HLSVType::Float3, 1, 4 },
+	{ "mat2(2) off diagonal", [](IRBuilder& ir) { return V(ir, HLSVType::Mat2, { ir.lit(2.0f) }); },
+		true, HLSVType::Mat2, 1, 0 },
+	{ "mat2(2) diagonal", [](IRBuilder& ir) { return V(ir, HLSVType::Mat2, { ir.lit(2.0f) }); },
+		true, HLSVType::Mat2, 3, 2 },
+	{ "mat2 * float2", [](IRBuilder& ir) {
+		auto ones = V(ir, HLSVType::Float2, { ir.lit(1.0f), ir.lit(1.0f) });
+		return ir.bin(ir::Op::Mul, M2(ir), ones, HLSVType::Float2); },
+		true, HLSVType::Float2, 1, 6 },
+	{ "mat2 * mat2", [](IRBuilder& ir) { return ir.bin(ir::Op::Mul, M2(ir), M2(ir), HLSVType::Mat2); },
+		true, HLSVType::Mat2, 2, 15 }, // Column 1 = M * (3, 4) = (15, 22)
+	{ "mat3(mat2) resize", [](IRBuilder& ir) { return V(ir, HLSVType::Mat3, { M2(ir) }); },
+		true, HLSVType::Mat3, 8, 1 },
+	// Indexing and swizzles
+	{ "float3[1]", [](IRBuilder& ir) { return ir.index(F3(ir), ir.lit(1), HLSVType::Float); },
+		true, HLSVType::Float, 0, 2 },
+	{ "float3[-1]", [](IRBuilder& ir) { return ir.index(F3(ir), ir.lit(-1), HLSVType::Float); },
+		false, HLSVType::Float, 0, 0 },
+	{ "float3[3]", [](IRBuilder& ir) { return ir.index(F3(ir), ir.lit(3), HLSVType::Float); },
+		false, HLSVType::Float, 0, 0 },
+	{ "mat2[1]", [](IRBuilder& ir) { return ir.index(M2(ir), ir.lit(1), HLSVType::Float2); },
+		true, HLSVType::Float2, 1, 4 },
+	{ "float3.zx", [](IRBuilder& ir) {
+		const uint8 zx[] = { 2, 0 };
+		return ir.module.new_swizzle(F3(ir), zx, 2, HLSVType::Float2, 1); }, true, HLSVType::Float2, 0, 3 },
+	{ "true ? 1 : 2", [](IRBuilder& ir) {
+		return ir.module.new_ternary(B(ir, true), ir.lit(1), ir.lit(2), HLSVType::Int, 1); },
+		true, HLSVType::Int, 0, 1 },
+	// Builtin functions
+	{ "sqrt(4)", [](IRBuilder& ir) { return ir.call("sqrt", HLSVType::Float, { ir.lit(4.0f) }); },
+		true, HLSVType::Float, 0, 2 },
+	{ "sqrt(-1)", [](IRBuilder& ir) { return ir.call("sqrt", HLSVType::Float, { ir.lit(-1.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "log(0)", [](IRBuilder& ir) { return ir.call("log", HLSVType::Float, { ir.lit(0.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "pow(-2, 2)", [](IRBuilder& ir) { return ir.call("pow", HLSVType::Float, { ir.lit(-2.0f), ir.lit(2.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "exp(100) overflows", [](IRBuilder& ir) { return ir.call("exp", HLSVType::Float, { ir.lit(100.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "atan(1, 1)", [](IRBuilder& ir) { return ir.call("atan", HLSVType::Float, { ir.lit(1.0f), ir.lit(1.0f) }); },
+		true, HLSVType::Float, 0, 0.78539816339744831 },
+	{ "atan(1, -1)", [](IRBuilder& ir) { return ir.call("atan", HLSVType::Float, { ir.lit(1.0f), ir.lit(-1.0f) }); },
+		true, HLSVType::Float, 0, 2.35619449019234492 },
+	{ "atan(0, 0)", [](IRBuilder& ir) { return ir.call("atan", HLSVType::Float, { ir.lit(0.0f), ir.lit(0.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "atan(1)", [](IRBuilder& ir) { return ir.call("atan", HLSVType::Float, { ir.lit(1.0f) }); },
+		true, HLSVType::Float, 0, 0.78539816339744831 },
+	{ "round(2.5)", [](IRBuilder& ir) { return ir.call("round", HLSVType::Float, { ir.lit(2.5f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "roundEven(2.5)", [](IRBuilder& ir) { return ir.call("roundEven", HLSVType::Float, { ir.lit(2.5f) }); },
+		true, HLSVType::Float, 0, 2 },
+	{ "mod(-1, 3)", [](IRBuilder& ir) { return ir.call("mod", HLSVType::Float, { ir.lit(-1.0f), ir.lit(3.0f) }); },
+		true, HLSVType::Float, 0, 2 },
+	{ "clamp(0.5, 2, 1)", [](IRBuilder& ir) {
+		return ir.call("clamp", HLSVType::Float, { ir.lit(0.5f), ir.lit(2.0f), ir.lit(1.0f) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "clamp(-5, 0, 3)", [](IRBuilder& ir) {
+		return ir.call("clamp", HLSVType::Int, { ir.lit(-5), ir.lit(0), ir.lit(3) }); }, true, HLSVType::Int, 0, 0 },
+	{ "abs(int min)", [](IRBuilder& ir) { return ir.call("abs", HLSVType::Int, { ir.lit(INT32_MIN) }); },
+		false, HLSVType::Int, 0, 0 },
+	{ "max(3u, 4000000000u)", [](IRBuilder& ir) {
+		return ir.call("max", HLSVType::UInt, { U(ir, 3), U(ir, 4000000000u) }); },
+		true, HLSVType::UInt, 0, 4000000000.0 },
+	{ "mix select", [](IRBuilder& ir) {
+		return ir.call("mix", HLSVType::Int, { ir.lit(1), ir.lit(2), B(ir, true) }); }, true, HLSVType::Int, 0, 2 },
+	{ "smoothstep(0, 1, 0.5)", [](IRBuilder& ir) {
+		return ir.call("smoothstep", HLSVType::Float, { ir.lit(0.0f), ir.lit(1.0f), ir.lit(0.5f) }); },
+		true, HLSVType::Float, 0, 0.5 },
+	{ "length(float2(3, 4))", [](IRBuilder& ir) {
+		return ir.call("length", HLSVType::Float, { V(ir, HLSVType::Float2, { ir.lit(3.0f), ir.lit(4.0f) }) }); },
+		true, HLSVType::Float, 0, 5 },
+	{ "dot(float3, float3)", [](IRBuilder& ir) { return ir.call("dot", HLSVType::Float, { F3(ir), F3(ir) }); },
+		true, HLSVType::Float, 0, 14 },
+	{ "normalize(float2(0))", [](IRBuilder& ir) {
+		return ir.call("normalize", HLSVType::Float2, { V(ir, HLSVType::Float2, { ir.lit(0.0f) }) }); },
+		false, HLSVType::Float2, 0, 0 },
+	{ "cross(x, y).z", [](IRBuilder& ir) {
+		auto x = V(ir, HLSVType::Float3, { ir.lit(1.0f), ir.lit(0.0f), ir.lit(0.0f) });
+		auto y = V(ir, HLSVType::Float3, { ir.lit(0.0f), ir.lit(1.0f), ir.lit(0.0f) });
+		return ir.call("cross", HLSVType::Float3, { x, y }); }, true, HLSVType::Float3, 2, 1 },
+	{ "determinant(mat2)", [](IRBuilder& ir) { return ir.call("determinant", HLSVType::Float, { M2(ir) }); },
+		true, HLSVType::Float, 0, -2 },
+	{ "determinant(mat4)", [](IRBuilder& ir) {
+		return ir.call("determinant", HLSVType::Float, { V(ir, HLSVType::Mat4, { ir.lit(1.0f) }) }); },
+		false, HLSVType::Float, 0, 0 },
+	{ "transpose(mat2)", [](IRBuilder& ir) { return ir.call("transpose", HLSVType::Mat2, { M2(ir) }); },
+		true, HLSVType::Mat2, 1, 3 },
+	{ "lessThan(int2, int2).y", [](IRBuilder& ir) {
+		return ir.call("lessThan", HLSVType::Bool2, { V(ir, HLSVType::Int2, { ir.lit(1), ir.lit(5) }),
+			V(ir, HLSVType::Int2, { ir.lit(2), ir.lit(3) }) }); }, true, HLSVType::Bool2, 1, 0 },
+	{ "isnan(1.0)", [](IRBuilder& ir) { return ir.call("isnan", HLSVType::Bool, { ir.lit(1.0f) }); },
+		true, HLSVType::Bool, 0, 0 },
+	{ "unknown builtin", [](IRBuilder& ir) { return ir.call("dFdx", HLSVType::Float, { ir.lit(1.0f) }); },
+		false, HLSVType::Float, 0, 0 }
+};
+
+// ====================================================================================================================
+static bool check_component(const ir::ConstValue& val, const EvalCase& ec)
+{
+	auto c = val.comps[ec.comp];
+	switch (HLSVType::GetComponentType(ec.type))
+	{
+	case HLSVType::Float: return std::fabs(c.f - ec.value) <= 1e-6 * std::fmax(1.0, std::fabs(ec.value));
+	case HLSVType::Int: return c.si == (int32)ec.value;
+	default: return c.ui == (uint32)ec.value;
+	}
+}
+
+// ====================================================================================================================
+TEST(eval_constant_table)
+{
+	for (const auto& ec : EVAL_CASES) {
+		IRBuilder ir{ };
+		ir::ConstValue val;
+		bool folds = ir::EvaluateConstant(ec.build(ir), val);
+		if (folds != ec.folds)
+			throw TestFailure{ strarg("'%s' %s", ec.desc, folds ? "folded" : "did not fold") };
+		if (folds && (val.type != ec.type || !check_component(val, ec)))
+			throw TestFailure{ strarg("'%s' has the wrong value", ec.desc) };
+	}
+}
+
+// ====================================================================================================================
+TEST(eval_constant_variables)
+{
+	// Only symbols with a known value fold, converted to the variable type
+	IRBuilder ir{ };
+	auto known = ir.sym("k", HLSVType::Float), unknown = ir.sym("u", HLSVType::Float);
+	known->value = ir.lit(3);
+	ir::ConstValue val;
+	CHECK(ir::EvaluateConstant(ir.var(known), val) && val.type == HLSVType::Float && val.comps[0].f == 3.0f);
+	CHECK(!ir::EvaluateConstant(ir.var(unknown), val));
+	auto inc = ir.module.new_unary(ir::Op::PostInc, ir.var(known), HLSVType::Float, 1);
+	CHECK(!ir::EvaluateConstant(inc, val));
+}
+
+// ====================================================================================================================
+TEST(fold_expr_forms)
+{
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float), b = ir.sym("b", HLSVType::Bool);
+
+	// Constant subexpressions fold into literals, the rest stays
+	auto sum = ir.bin(ir::Op::Add, ir.var(x), ir.bin(ir::Op::Mul, ir.lit(2.0f), ir.lit(3.0f), HLSVType::Float),
+		HLSVType::Float);
+	CHECK(ir::FoldExpr(ir.module, sum) == sum);
+	CHECK(sum->args[1]->is_literal() && sum->args[1]->value.f == 6.0f);
+
+	// Fully constant vectors become the compact constructor forms
+	auto fill = ir::FoldExpr(ir.module, ir.bin(ir::Op::Mul, V(ir, HLSVType::Float3, { ir.lit(1.0f) }), ir.lit(2.0f),
+		HLSVType::Float3));
+	CHECK(fill->kind == ir::ExprKind::Construct && fill->arg_count == 1 && fill->args[0]->value.f == 2.0f);
+	auto full = ir::FoldExpr(ir.module, ir.bin(ir::Op::Add, F3(ir), ir.lit(1.0f), HLSVType::Float3));
+	CHECK(full->kind == ir::ExprKind::Construct && full->arg_count == 3 && full->args[2]->value.f == 4.0f);
+	CHECK(ir::IsConstantForm(fill) && ir::IsConstantForm(full));
+
+	// Undefined results are left for the GPU
+	auto div = ir.bin(ir::Op::Div, ir.lit(1.0f), ir.lit(0.0f), HLSVType::Float);
+	CHECK(ir::FoldExpr(ir.module, div) == div);
+
+	// Constant ternary conditions and short-circuits keep only the evaluated side
+	auto tern = ir.module.new_ternary(B(ir, false), ir.var(x), ir.lit(1.0f), HLSVType::Float, 1);
+	auto folded = ir::FoldExpr(ir.module, tern);
+	CHECK(folded->is_literal() && folded->value.f == 1.0f);
+	auto land = ir.bin(ir::Op::LogAnd, B(ir, true), ir.var(b), HLSVType::Bool);
+	CHECK(ir::FoldExpr(ir.module, land)->is_variable());
+	auto lor = ir.bin(ir::Op::LogOr, ir.var(b), B(ir, true), HLSVType::Bool);
+	folded = ir::FoldExpr(ir.module, lor);
+	CHECK(folded->is_literal() && folded->value.ui == 1u);
+
+	// The side effects on the left of a short-circuit are kept
+	auto a = ir.sym("a", HLSVType::Int);
+	auto side = ir.bin(ir::Op::Gt, ir.module.new_unary(ir::Op::PostInc, ir.var(a), HLSVType::Int, 1), ir.lit(0),
+		HLSVType::Bool);
+	auto keep = ir.bin(ir::Op::LogOr, side, B(ir, true), HLSVType::Bool);
+	CHECK(ir::FoldExpr(ir.module, keep) == keep);
+}
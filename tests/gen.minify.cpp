@@ -0,0 +1,236 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the round-trip tests for the minified GLSL output, which parse the minified text back and check
+//    that it has the same meaning as the original IR
+
+#include "test.hpp"
+#include "gen/glsl_generator.hpp"
+#include "ir/eval.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <random>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// The multi-character GLSL operators, longest first
+static const char* const MULTI_OPS[] = {
+	"<<=", ">>=", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "+=", "-=", "*=", "/=", "%=", "&=", "|=",
+	"^="
+};
+
+// ====================================================================================================================
+// Splits GLSL source into tokens, skipping whitespace, comments, and preprocessor lines
+static std::vector<string> tokenize(const string& src)
+{
+	std::vector<string> tokens{ };
+	size_t i = 0;
+	while (i < src.length()) {
+		char c = src[i];
+		if (std::isspace((unsigned char)c))
+			++i;
+		else if (c == '#' || src.compare(i, 2, "//") == 0)
+			i = src.find('\n', i);
+		else if (std::isalnum((unsigned char)c) || c == '_' || c == '.') {
+			size_t start = i;
+			while (i < src.length() && (std::isalnum((unsigned char)src[i]) || src[i] == '_' ||
+					(src[i] == '.' && (i == start || std::isdigit((unsigned char)src[i - 1])))))
+				++i;
+			if (i == start) // A member access dot
+				++i;
+			tokens.push_back(src.substr(start, i - start));
+		}
+		else {
+			size_t len = 1;
+			for (auto op : MULTI_OPS) {
+				if (src.compare(i, std::strlen(op), op) == 0) {
+					len = std::strlen(op);
+					break;
+				}
+			}
+			tokens.push_back(src.substr(i, len));
+			i += len;
+		}
+		if (i == string::npos)
+			break;
+	}
+	return tokens;
+}
+
+// Parses and evaluates minified unsigned integer expressions, with the GLSL precedence rules
+struct ExprParser final
+{
+	std::vector<string> tokens;
+	size_t pos;
+
+	// The binary operators by precedence level, lowest first
+	uint32 parse(int level = 0) {
+		static const std::vector<std::vector<string>> LEVELS = {
+			{ "|" }, { "^" }, { "&" }, { "<<", ">>" }, { "+", "-" }, { "*" }
+		};
+		if (level == (int)LEVELS.size())
+			return parse_unary();
+		uint32 val = parse(level + 1);
+		while (pos < tokens.size()) {
+			const auto& ops = LEVELS[level];
+			auto op = std::find(ops.begin(), ops.end(), tokens[pos]);
+			if (op == ops.end())
+				break;
+			++pos;
+			uint32 rhs = parse(level + 1);
+			val = apply(*op, val, rhs);
+		}
+		return val;
+	}
+	uint32 parse_unary() {
+		const auto& tk = tokens[pos++];
+		if (tk == "~")
+			return ~parse_unary();
+		if (tk == "(") {
+			uint32 val = parse();
+			++pos; // ')'
+			return val;
+		}
+		return (uint32)std::strtoul(tk.c_str(), nullptr, 10);
+	}
+	static uint32 apply(const string& op, uint32 l, uint32 r) {
+		if (op == "|") return l | r;
+		if (op == "^") return l ^ r;
+		if (op == "&") return l & r;
+		if (op == "<<") return l << (r & 31u);
+		if (op == ">>") return l >> (r & 31u);
+		if (op == "+") return l + r;
+		if (op == "-") return l - r;
+		return l * r;
+	}
+};
+
+// ====================================================================================================================
+// Builds a random unsigned integer expression tree, shifts only use small constant amounts
+static ir::Expr* random_expr(IRBuilder& ir, std::mt19937& rng, uint32 depth)
+{
+	static const ir::Op OPS[] = {
+		ir::Op::Add, ir::Op::Sub, ir::Op::Mul, ir::Op::Shl, ir::Op::Shr, ir::Op::BitAnd, ir::Op::BitOr, ir::Op::BitXor
+	};
+	if (depth == 0 || (rng() % 4) == 0)
+		return ir.module.new_literal((uint32)(rng() % 1000), 1);
+	if ((rng() % 6) == 0)
+		return ir.module.new_unary(ir::Op::BitNot, random_expr(ir, rng, depth - 1), HLSVType::UInt, 1);
+	auto op = OPS[rng() % 8];
+	auto left = random_expr(ir, rng, depth - 1);
+	auto right = (op == ir::Op::Shl || op == ir::Op::Shr) ? ir.module.new_literal((uint32)(rng() % 8), 1) :
+		random_expr(ir, rng, depth - 1);
+	return ir.bin(op, left, right, HLSVType::UInt);
+}
+
+// ====================================================================================================================
+TEST(minify_expr_precedence_round_trip)
+{
+	IRBuilder ir{ };
+	std::mt19937 rng{ 12345u };
+	uint32 checked = 0;
+	for (uint32 i = 0; i < 500; ++i) {
+		auto expr = random_expr(ir, rng, 5);
+		ir::ConstValue expect;
+		if (!ir::EvaluateConstant(expr, expect))
+			continue;
+		auto full = GLSLGenerator::ExprStr(expr, false), min = GLSLGenerator::ExprStr(expr, true);
+		CHECK(min.length() <= full.length());
+		for (auto str : { full, min }) {
+			for (auto& ch : str) { // Remove the unsigned suffixes for the parser
+				if (ch == 'u')
+					ch = ' ';
+			}
+			ExprParser parser{ tokenize(str), 0 };
+			CHECK(parser.parse() == expect.comps[0].ui);
+			CHECK(parser.pos == parser.tokens.size());
+		}
+		++checked;
+	}
+	CHECK(checked > 400);
+}
+
+// ====================================================================================================================
+// Checks that the minified source has the same tokens as the original (except for parentheses), with the internal
+//    names consistently renamed, and returns the number of renamed names
+static size_t check_same_tokens(const string& full, const string& min)
+{
+	auto strip_parens = [](std::vector<string> tokens) {
+		tokens.erase(std::remove_if(tokens.begin(), tokens.end(), [](const string& tk) {
+			return tk == "(" || tk == ")";
+		}), tokens.end());
+		return tokens;
+	};
+	auto ftokens = strip_parens(tokenize(full)), mtokens = strip_parens(tokenize(min));
+	CHECK(ftokens.size() == mtokens.size());
+	std::map<string, string> names{ }, reverse{ };
+	for (size_t i = 0; i < ftokens.size(); ++i) {
+		if (ftokens[i] == mtokens[i])
+			continue;
+		CHECK(ftokens[i][0] == '_'); // Only the internal names can differ
+		auto& name = names[ftokens[i]];
+		auto& orig = reverse[mtokens[i]];
+		CHECK((name.empty() || name == mtokens[i]) && (orig.empty() || orig == ftokens[i]));
+		name = mtokens[i];
+		orig = ftokens[i];
+	}
+	return names.size();
+}
+
+// ====================================================================================================================
+TEST(minify_function_round_trip)
+{
+	// The interface names must be unchanged
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto tmp = ir.sym("_cse0", HLSVType::Float), out = ir.sym("out_color", HLSVType::Float, VarScope::Output);
+	auto scale = ir.sym("scale", HLSVType::Float, VarScope::Uniform);
+	auto sum = ir.bin(ir::Op::Add, ir.var(scale), ir.lit(1.0f), HLSVType::Float);
+	ir.declare(func->body, tmp, ir.bin(ir::Op::Mul, ir.var(scale), sum, HLSVType::Float));
+	auto neg = ir.module.new_unary(ir::Op::Neg, ir.var(tmp), HLSVType::Float, 1);
+	ir.assign(func->body, ir.var(out), ir.bin(ir::Op::Sub, ir.var(tmp), neg, HLSVType::Float));
+
+	GLSLGenerator gen{ nullptr, true };
+	gen.emit_function(*func);
+	auto full = gen.stage_str(ShaderStages::Fragment, false), min = gen.frag_str();
+	CHECK(min.length() < full.length());
+	CHECK(min.find("_cse0") == string::npos);
+	CHECK(min.find("out_color") != string::npos && min.find("scale") != string::npos);
+	CHECK(check_same_tokens(full, min) == 1);
+}
+
+// ====================================================================================================================
+TEST(minify_inc_dec_round_trip)
+{
+	// The increment, decrement, and negation operators must not merge with the neighboring operators
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto cnt = ir.sym("_cnt", HLSVType::Int), out = ir.sym("out_val", HLSVType::Int, VarScope::Output);
+	auto x = ir.sym("x", HLSVType::Int, VarScope::Uniform);
+	ir.declare(func->body, cnt, ir.var(x));
+	auto eval = ir.module.new_stmt(ir::StmtKind::Eval, 1);
+	eval->value = ir.module.new_unary(ir::Op::PostInc, ir.var(cnt), HLSVType::Int, 1);
+	func->body.append(eval);
+	auto predec = ir.module.new_unary(ir::Op::PreDec, ir.var(cnt), HLSVType::Int, 1);
+	ir.assign(func->body, ir.var(out), ir.bin(ir::Op::Sub, ir.var(x), predec, HLSVType::Int));
+	auto preinc = ir.module.new_unary(ir::Op::PreInc, ir.var(cnt), HLSVType::Int, 1);
+	ir.assign(func->body, ir.var(out), ir.bin(ir::Op::Add, ir.var(x), preinc, HLSVType::Int), ir::Op::Add);
+	auto postdec = ir.module.new_unary(ir::Op::PostDec, ir.var(cnt), HLSVType::Int, 1);
+	auto neg = ir.module.new_unary(ir::Op::Neg, ir.var(x), HLSVType::Int, 1);
+	ir.assign(func->body, ir.var(out), ir.bin(ir::Op::Sub, postdec, neg, HLSVType::Int), ir::Op::Sub);
+
+	GLSLGenerator gen{ nullptr, true };
+	gen.emit_function(*func);
+	auto full = gen.stage_str(ShaderStages::Fragment, false), min = gen.frag_str();
+	CHECK(min.length() < full.length());
+	CHECK(check_same_tokens(full, min) == 1);
+}
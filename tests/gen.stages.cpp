@@ -0,0 +1,65 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the per-stage global declarations in the GLSL generator
+
+#include "test.hpp"
+#include "gen/glsl_generator.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(gen_stage_declarations)
+{
+	GLSLGenerator gen{ nullptr, false };
+	gen.emit_handle_uniform({ "diffuse", HLSVType::Tex2D, 0, 0, 0, 0, 0 });
+	gen.emit_handle_uniform({ "shared_tex", HLSVType::Tex2D, 0, 1, 0, 0, 0 });
+	gen.emit_uniform_block_header(0, 2);
+	gen.emit_value_uniform({ "mvp", HLSVType::Mat4, 0, 2, 0, 0, 64 });
+	gen.emit_value_uniform({ "tint", HLSVType::Float4, 0, 2, 0, 64, 16 });
+	gen.emit_block_close();
+	gen.emit_push_constant_block_header();
+	gen.emit_push_constant({ "push_vert", HLSVType::Float4, 0, 16 });
+	gen.emit_push_constant({ "push_frag", HLSVType::Float, 16, 4 });
+	gen.emit_block_close();
+
+	gen.set_resource_stages("diffuse", ShaderStages::Fragment);
+	gen.set_resource_stages(GLSLGenerator::BlockName(0, 2), ShaderStages::Vertex);
+	gen.set_resource_stages("push_vert", ShaderStages::Vertex);
+	gen.set_resource_stages("push_frag", ShaderStages::Fragment);
+	gen.set_resource_stages(GLSLGenerator::PushBlockName(), ShaderStages::Vertex | ShaderStages::Fragment);
+	auto vert = gen.vert_str(), frag = gen.frag_str();
+
+	// Resources without a mask are declared in all stages, blocks are declared whole
+	CHECK(vert.find("diffuse") == string::npos && frag.find("diffuse") != string::npos);
+	CHECK(vert.find("shared_tex") != string::npos && frag.find("shared_tex") != string::npos);
+	CHECK(vert.find("Block_0_2") != string::npos && vert.find("tint") != string::npos);
+	CHECK(frag.find("Block_0_2") == string::npos && frag.find("mvp") == string::npos);
+	CHECK(vert.find("layout(offset = 0) vec4 push_vert;") != string::npos && vert.find("push_frag") == string::npos);
+	CHECK(frag.find("layout(offset = 16) float push_frag;") != string::npos && frag.find("push_vert") == string::npos);
+
+	// A block that no stage uses is not declared at all
+	gen.set_resource_stages(GLSLGenerator::PushBlockName(), ShaderStages::None);
+	CHECK(gen.vert_str().find("PushConstants") == string::npos);
+	CHECK(gen.frag_str().find("PushConstants") == string::npos);
+}
+
+// ====================================================================================================================
+TEST(gen_stripped_attributes)
+{
+	GLSLGenerator gen{ nullptr, false };
+	gen.emit_attribute({ "pos", HLSVType::Float3, 0, 1 });
+	gen.emit_attribute({ "unused_nrm", HLSVType::Float3, 1, 1 });
+	gen.set_resource_stages("unused_nrm", ShaderStages::None); // Set when stripping the unused attributes
+	auto vert = gen.vert_str();
+	CHECK(vert.find("layout(location = 0) in vec3 pos;") != string::npos);
+	CHECK(vert.find("unused_nrm") == string::npos);
+	CHECK(gen.frag_str().find("pos") == string::npos);
+}
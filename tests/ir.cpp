@@ -0,0 +1,54 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the IR containers and utilities
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(ir_block_insert_remove)
+{
+	IRBuilder ir{ };
+	ir::Block block{ nullptr, nullptr };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto a = ir.assign(block, ir.var(x), ir.lit(1.0f));
+	auto b = ir.assign(block, ir.var(x), ir.lit(2.0f));
+	auto c = ir.module.new_stmt(ir::StmtKind::Discard, 1);
+	block.insert_before(a, c);
+	CHECK(block.first == c && c->next == a && a->prev == c);
+	block.remove(a);
+	CHECK(CountStmts(block) == 2 && c->next == b && b->prev == c && block.last == b);
+	block.remove(b);
+	CHECK(block.last == c && !c->next);
+}
+
+// ====================================================================================================================
+TEST(ir_base_symbol)
+{
+	IRBuilder ir{ };
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float4, 4 });
+	auto idx = ir.index(ir.var(arr), ir.lit(2), HLSVType::Float4);
+	CHECK(ir::GetBaseSymbol(idx) == arr);
+}
+
+// ====================================================================================================================
+TEST(ir_modified_symbols)
+{
+	IRBuilder ir{ };
+	ir::Block block{ nullptr, nullptr };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto y = ir.sym("y", HLSVType::Float);
+	ir.assign(block, ir.var(x), ir.var(y));
+	ir::SymbolSet modified{ };
+	ir::FindModifiedSymbols(block, modified);
+	CHECK(modified.count(x) == 1 && modified.count(y) == 0);
+}
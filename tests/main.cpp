@@ -0,0 +1,58 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file is the entry point for hlsvtest, which runs the unit tests for the compiler internals. Passing '--bench'
+//    runs the benchmarks instead, and any other argument only runs the tests whose names contain it.
+
+#include "test.hpp"
+#include <cstdio>
+#include <cstring>
+
+
+namespace hlsvtest
+{
+
+// ====================================================================================================================
+std::vector<TestEntry>& GetTests()
+{
+	static std::vector<TestEntry> tests{ };
+	return tests;
+}
+
+} // namespace hlsvtest
+
+
+// ====================================================================================================================
+int main(int argc, char** argv)
+{
+	bool bench = false;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "--bench"))
+			bench = true;
+		else
+			filter = argv[i];
+	}
+
+	hlsv::uint32 run = 0, failed = 0;
+	for (const auto& test : hlsvtest::GetTests()) {
+		if (test.bench != bench || (filter && !std::strstr(test.name, filter)))
+			continue;
+		++run;
+		try {
+			test.func();
+			std::printf("[PASS] %s\n", test.name);
+		}
+		catch (const hlsvtest::TestFailure& fail) {
+			++failed;
+			std::printf("[FAIL] %s - %s\n", test.name, fail.message.c_str());
+		}
+	}
+	std::printf("%u of %u %s passed.\n", run - failed, run, bench ? "benchmarks" : "tests");
+	return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the matrix reassociation pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Runs the pass on 'o = <value>', and returns the new value
+static ir::Expr* reassociate(IRBuilder& ir, ir::Expr* value, bool fast_math)
+{
+	auto func = ir.module.new_function(ShaderStages::Vertex);
+	auto o = ir.sym("o", value->type, VarScope::Local);
+	auto stmt = ir.assign(func->body, ir.var(o), value);
+	CompilerOptions options{ };
+	options.fast_math = fast_math;
+	ir::ReassociateMatrices(ir.module, *func, options);
+	return stmt->value;
+}
+
+// ====================================================================================================================
+static bool is_mul(const ir::Expr* expr, const ir::Expr* left, const ir::Expr* right)
+{
+	return expr->kind == ir::ExprKind::Binary && expr->op == ir::Op::Mul && expr->args[0] == left &&
+		expr->args[1] == right;
+}
+
+// ====================================================================================================================
+TEST(algebra_matrix_chain)
+{
+	// (P * V * M) * v -> P * (V * (M * v)), only with fast math
+	for (bool fast : { false, true }) {
+		IRBuilder ir{ };
+		auto P = ir.var(ir.sym("P", HLSVType::Mat4, VarScope::Uniform));
+		auto V = ir.var(ir.sym("V", HLSVType::Mat4, VarScope::Uniform));
+		auto M = ir.var(ir.sym("M", HLSVType::Mat4, VarScope::Uniform));
+		auto v = ir.var(ir.sym("v", HLSVType::Float4, VarScope::Attribute));
+		auto pvm = ir.bin(ir::Op::Mul, ir.bin(ir::Op::Mul, P, V, HLSVType::Mat4), M, HLSVType::Mat4);
+		auto prod = ir.bin(ir::Op::Mul, pvm, v, HLSVType::Float4);
+		auto res = reassociate(ir, prod, fast);
+		if (!fast) {
+			CHECK(res == prod && prod->args[0] == pvm);
+			continue;
+		}
+		CHECK(is_mul(res, P, res->args[1]));
+		CHECK(is_mul(res->args[1], V, res->args[1]->args[1]));
+		CHECK(is_mul(res->args[1]->args[1], M, v));
+	}
+
+	// v * (A * B) -> (v * A) * B, only with fast math
+	for (bool fast : { false, true }) {
+		IRBuilder ir{ };
+		auto A = ir.var(ir.sym("A", HLSVType::Mat3, VarScope::Uniform));
+		auto B = ir.var(ir.sym("B", HLSVType::Mat3, VarScope::Uniform));
+		auto v = ir.var(ir.sym("v", HLSVType::Float3, VarScope::Attribute));
+		auto prod = ir.bin(ir::Op::Mul, v, ir.bin(ir::Op::Mul, A, B, HLSVType::Mat3), HLSVType::Float3);
+		auto res = reassociate(ir, prod, fast);
+		if (!fast)
+			CHECK(res == prod);
+		else
+			CHECK(is_mul(res, res->args[0], B) && is_mul(res->args[0], v, A));
+	}
+}
+
+// ====================================================================================================================
+TEST(algebra_transpose_identities)
+{
+	// The transpose rewrites are exact, so they do not need fast math
+	for (bool fast : { false, true }) {
+		IRBuilder ir{ };
+		auto M = ir.var(ir.sym("M", HLSVType::Mat4, VarScope::Uniform));
+		auto tt = ir.call("transpose", HLSVType::Mat4, { ir.call("transpose", HLSVType::Mat4, { M }) });
+		CHECK(reassociate(ir, tt, fast) == M);
+
+		// transpose(M) * v -> v * M, and v * transpose(M) -> M * v
+		auto v = ir.var(ir.sym("v", HLSVType::Float4, VarScope::Attribute));
+		auto tv = ir.bin(ir::Op::Mul, ir.call("transpose", HLSVType::Mat4, { M }), v, HLSVType::Float4);
+		CHECK(is_mul(reassociate(ir, tv, fast), v, M));
+		auto vt = ir.bin(ir::Op::Mul, v, ir.call("transpose", HLSVType::Mat4, { M }), HLSVType::Float4);
+		CHECK(is_mul(reassociate(ir, vt, fast), M, v));
+	}
+}
+
+// ====================================================================================================================
+TEST(algebra_inverse_identity)
+{
+	// inverse(inverse(M)) is not exactly M in floating point, so it is only removed with fast math
+	for (bool fast : { false, true }) {
+		IRBuilder ir{ };
+		auto M = ir.var(ir.sym("M", HLSVType::Mat4, VarScope::Uniform));
+		auto ii = ir.call("inverse", HLSVType::Mat4, { ir.call("inverse", HLSVType::Mat4, { M }) });
+		auto res = reassociate(ir, ii, fast);
+		CHECK(fast ? (res == M) : (res == ii && res->args[0]->args[0] == M));
+	}
+}
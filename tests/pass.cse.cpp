@@ -0,0 +1,47 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the common subexpression elimination pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(cse_reuses_repeated_expr)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float), b = ir.sym("b", HLSVType::Float);
+	auto o1 = ir.sym("o1", HLSVType::Float), o2 = ir.sym("o2", HLSVType::Float);
+	ir.assign(func->body, ir.var(o1), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float));
+	ir.assign(func->body, ir.var(o2), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float));
+	ir::EliminateCommonSubexprs(ir.module, *func);
+	CHECK(func->body.first->kind == ir::StmtKind::Declare);
+	CHECK(func->body.last->value->kind == ir::ExprKind::Variable);
+}
+
+// ====================================================================================================================
+TEST(cse_lvalue_increment_invalidates)
+{
+	// o1 = i * b; arr[i++] = 1.0; o2 = i * b; -- the second product reads the new value of i
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto i = ir.sym("i", HLSVType::Int), b = ir.sym("b", HLSVType::Int);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 });
+	auto o1 = ir.sym("o1", HLSVType::Int), o2 = ir.sym("o2", HLSVType::Int);
+	ir.assign(func->body, ir.var(o1), ir.bin(ir::Op::Mul, ir.var(i), ir.var(b), HLSVType::Int));
+	auto inc = ir.module.new_unary(ir::Op::PostInc, ir.var(i), HLSVType::Int, 1);
+	ir.assign(func->body, ir.index(ir.var(arr), inc, HLSVType::Float), ir.lit(1.0f));
+	ir.assign(func->body, ir.var(o2), ir.bin(ir::Op::Mul, ir.var(i), ir.var(b), HLSVType::Int));
+	ir::EliminateCommonSubexprs(ir.module, *func);
+	CHECK(CountStmts(func->body) == 3);
+	CHECK(func->body.last->value->kind == ir::ExprKind::Binary);
+}
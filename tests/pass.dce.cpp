@@ -0,0 +1,206 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the constant propagation and dead code elimination passes
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Checks that every block variable that is used still has its declaration
+static bool all_uses_declared(const ir::Block& block, ir::SymbolSet& declared)
+{
+	for (auto stmt = block.first; stmt; stmt = stmt->next) {
+		if (stmt->kind == ir::StmtKind::Declare)
+			declared.insert(stmt->symbol);
+		ir::SymbolSet used{ };
+		ir::FindUsedSymbols(stmt->target, used);
+		ir::FindUsedSymbols(stmt->value, used);
+		ir::FindUsedSymbols(stmt->init, used);
+		for (auto sym : used) {
+			if (sym->scope == VarScope::Block && !declared.count(sym))
+				return false;
+		}
+		if (!all_uses_declared(stmt->updates, declared) || !all_uses_declared(stmt->body, declared) ||
+				!all_uses_declared(stmt->else_body, declared))
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+TEST(propagate_marks_unmodified_constants)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float, VarScope::Local);
+	auto k = ir.sym("k", HLSVType::Float), m = ir.sym("m", HLSVType::Float), n = ir.sym("n", HLSVType::Float);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 2 });
+	ir.declare(func->body, k, ir.lit(2.0f));
+	ir.declare(func->body, m, ir.lit(1.0f));
+	ir.assign(func->body, ir.var(m), ir.lit(3.0f));
+	ir.declare(func->body, n, ir.var(x));
+	auto list = ir.module.new_init_list(HLSVType{ HLSVType::Float, 2 }, { ir.lit(1.0f), ir.lit(2.0f) }, 1);
+	ir.declare(func->body, arr, list);
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(x), ir.lit(0.0f), HLSVType::Bool));
+	auto inner = ir.sym("inner", HLSVType::Float);
+	ir.declare(br->body, inner, ir.lit(4.0f));
+
+	CHECK(ir::PropagateConstants(*func));
+	CHECK(k->value && inner->value);
+	CHECK(!m->value && !n->value && !arr->value);
+	CHECK(!ir::PropagateConstants(*func)); // Nothing new on the second run
+}
+
+// ====================================================================================================================
+TEST(dce_propagated_uses_are_folded)
+{
+	// The declarations of propagated locals are removed, which is only valid if folding replaced every use
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float, VarScope::Local), o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Local);
+	auto k = ir.sym("k", HLSVType::Float), i = ir.sym("i", HLSVType::Int), v = ir.sym("v", HLSVType::Float3);
+	ir.declare(func->body, k, ir.lit(2.0f));
+	ir.declare(func->body, i, ir.lit(1));
+	auto vec = ir.module.new_construct(HLSVType::Float3, { ir.lit(1.0f), ir.lit(2.0f), ir.lit(3.0f) }, 1);
+	ir.declare(func->body, v, vec);
+	ir.assign(func->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(k), ir.var(x), HLSVType::Float));
+	ir.assign(func->body, ir.index(ir.var(arr), ir.var(i), HLSVType::Float), ir.var(k));
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(x), ir.var(k), HLSVType::Bool));
+	uint8 comps[1] = { 1 };
+	ir.assign(br->body, ir.var(o), ir.module.new_swizzle(ir.var(v), comps, 1, HLSVType::Float, 1), ir::Op::Add);
+
+	CompilerOptions options{ };
+	ir::OptimizeFunction(ir.module, *func, options);
+	ir::SymbolSet used{ }, declared{ };
+	ir::FindUsedSymbols(func->body, used);
+	CHECK(!used.count(k) && !used.count(i) && !used.count(v));
+	CHECK(all_uses_declared(func->body, declared));
+	CHECK(CountStmts(func->body) == 3);
+}
+
+// ====================================================================================================================
+TEST(dce_constant_branches)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto b1 = ir.branch(func->body, ir.module.new_literal(true, 1)); // Spliced
+	ir.assign(b1->body, ir.var(o), ir.lit(1.0f));
+	ir.assign(b1->else_body, ir.var(o), ir.lit(2.0f));
+	auto b2 = ir.branch(func->body, ir.module.new_literal(false, 1)); // Removed
+	ir.assign(b2->body, ir.var(o), ir.lit(3.0f));
+	auto b3 = ir.branch(func->body, ir.module.new_literal(false, 1)); // Else spliced
+	ir.assign(b3->body, ir.var(o), ir.lit(4.0f));
+	ir.assign(b3->else_body, ir.var(o), ir.lit(5.0f));
+
+	CHECK(ir::EliminateDeadCode(ir.module, *func));
+	CHECK(CountStmts(func->body) == 2);
+	CHECK(func->body.first->kind == ir::StmtKind::Assign && func->body.first->value->value.f == 1.0f);
+	CHECK(func->body.last->kind == ir::StmtKind::Assign && func->body.last->value->value.f == 5.0f);
+	CHECK(!ir::EliminateDeadCode(ir.module, *func));
+}
+
+// ====================================================================================================================
+TEST(dce_keeps_declaring_branch_scope)
+{
+	// if (false) { ... } else { float t = x; o = t; } -- the taken branch keeps its own scope
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float, VarScope::Local), o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto t = ir.sym("t", HLSVType::Float);
+	auto br = ir.branch(func->body, ir.module.new_literal(false, 1));
+	ir.assign(br->body, ir.var(o), ir.lit(1.0f));
+	ir.declare(br->else_body, t, ir.var(x));
+	ir.assign(br->else_body, ir.var(o), ir.var(t));
+
+	CHECK(ir::EliminateDeadCode(ir.module, *func));
+	CHECK(CountStmts(func->body) == 1 && func->body.first == br);
+	CHECK(br->value->kind == ir::ExprKind::Literal && br->value->value.ui != 0u);
+	CHECK(br->else_body.empty() && CountStmts(br->body) == 2);
+	CHECK(br->body.first->symbol == t);
+	CHECK(!ir::EliminateDeadCode(ir.module, *func)); // The single scoped branch is left alone
+}
+
+// ====================================================================================================================
+TEST(dce_constant_local_in_branch)
+{
+	// if (x > 0) { float k = 2.0; o = k * x; } -- k is folded, the branch stays
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float, VarScope::Local), o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto k = ir.sym("k", HLSVType::Float);
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(x), ir.lit(0.0f), HLSVType::Bool));
+	ir.declare(br->body, k, ir.lit(2.0f));
+	ir.assign(br->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(k), ir.var(x), HLSVType::Float));
+
+	CHECK(ir::PropagateConstants(*func));
+	ir::FoldConstants(ir.module, *func);
+	CHECK(ir::EliminateDeadCode(ir.module, *func));
+	CHECK(CountStmts(func->body) == 1 && func->body.first->kind == ir::StmtKind::If);
+	CHECK(CountStmts(br->body) == 1 && br->body.first->kind == ir::StmtKind::Assign);
+	ir::SymbolSet used{ };
+	ir::FindUsedSymbols(br->body, used);
+	CHECK(!used.count(k) && used.count(x));
+}
+
+// ====================================================================================================================
+TEST(dce_removes_dead_loops)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto w = ir.loop(func->body, ir::StmtKind::While, ir.module.new_literal(false, 1)); // Removed
+	ir.assign(w->body, ir.var(o), ir.lit(1.0f));
+	auto d1 = ir.loop(func->body, ir::StmtKind::DoWhile, ir.module.new_literal(false, 1)); // Spliced
+	ir.assign(d1->body, ir.var(o), ir.lit(2.0f));
+	auto d2 = ir.loop(func->body, ir::StmtKind::DoWhile, ir.module.new_literal(false, 1)); // Kept, has break
+	auto brk = ir.branch(d2->body, ir.bin(ir::Op::Gt, ir.var(o), ir.lit(0.0f), HLSVType::Bool));
+	brk->body.append(ir.module.new_stmt(ir::StmtKind::Break, 1));
+	ir.assign(d2->body, ir.var(o), ir.lit(3.0f));
+
+	// for (int i = init; i < 3; i++) { o += 1.0; }
+	auto add_for = [&](int32 init) {
+		auto i = ir.sym("i", HLSVType::Int);
+		auto loop = ir.loop(func->body, ir::StmtKind::For, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(3), HLSVType::Bool));
+		loop->symbol = i;
+		loop->init = ir.lit(init);
+		auto inc = ir.module.new_stmt(ir::StmtKind::Eval, 1);
+		inc->value = ir.module.new_unary(ir::Op::PostInc, ir.var(i), HLSVType::Int, 1);
+		loop->updates.append(inc);
+		ir.assign(loop->body, ir.var(o), ir.lit(1.0f), ir::Op::Add);
+		return loop;
+	};
+	add_for(5); // Removed, zero trips
+	auto f2 = add_for(0);
+
+	CHECK(ir::EliminateDeadCode(ir.module, *func));
+	CHECK(CountStmts(func->body) == 3);
+	CHECK(func->body.first->kind == ir::StmtKind::Assign && func->body.first->value->value.f == 2.0f);
+	CHECK(func->body.first->next == d2 && func->body.last == f2);
+}
+
+// ====================================================================================================================
+TEST(dce_removes_unreachable)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Local);
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(o), ir.lit(0.0f), HLSVType::Bool));
+	br->body.append(ir.module.new_stmt(ir::StmtKind::Discard, 1));
+	ir.assign(br->body, ir.var(o), ir.lit(1.0f));
+	ir.assign(func->body, ir.var(o), ir.lit(2.0f));
+
+	CHECK(ir::EliminateDeadCode(ir.module, *func));
+	CHECK(CountStmts(br->body) == 1 && br->body.first->kind == ir::StmtKind::Discard);
+	CHECK(CountStmts(func->body) == 2);
+}
@@ -0,0 +1,106 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for moving fragment expressions into the vertex stage
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// Uniforms a and b, the interpolated local l, and the flat local f, with empty vertex and fragment functions
+struct FrequencyFixture final
+{
+	IRBuilder ir;
+	ir::Function *vert, *frag;
+	ir::Symbol *a, *b, *l, *f;
+
+	FrequencyFixture() :
+		ir{ }
+	{
+		vert = ir.module.new_function(ShaderStages::Vertex);
+		frag = ir.module.new_function(ShaderStages::Fragment);
+		a = ir.sym("a", HLSVType::Float, VarScope::Uniform);
+		b = ir.sym("b", HLSVType::Float, VarScope::Uniform);
+		l = ir.sym("l", HLSVType::Float, VarScope::Local);
+		f = ir.module.new_symbol("f", HLSVType::Float, VarScope::Local, true);
+	}
+
+	// Adds 'o = <value>' to the fragment function
+	ir::Stmt* output(ir::Expr* value) {
+		return ir.assign(frag->body, ir.var(ir.sym("o", value->type, VarScope::Output)), value);
+	}
+};
+
+// ====================================================================================================================
+TEST(frequency_hoists_affine)
+{
+	// a * l + b is the same when interpolated, so it moves into a new interpolated local
+	FrequencyFixture fx{ };
+	auto& ir = fx.ir;
+	auto value = ir.bin(ir::Op::Add, ir.bin(ir::Op::Mul, ir.var(fx.a), ir.var(fx.l), HLSVType::Float), ir.var(fx.b),
+		HLSVType::Float);
+	auto stmt = fx.output(value);
+	auto syms = ir::HoistToVertexStage(ir.module, 4);
+	CHECK(syms.size() == 1 && !syms[0]->is_flat && syms[0]->scope == VarScope::Local);
+	CHECK(stmt->value->kind == ir::ExprKind::Variable && stmt->value->symbol == syms[0]);
+	CHECK(CountStmts(fx.vert->body) == 1);
+	CHECK(fx.vert->body.first->target->symbol == syms[0] && fx.vert->body.first->value == value);
+}
+
+// ====================================================================================================================
+TEST(frequency_hoists_flat)
+{
+	// f * a only reads a flat local, so it moves into a new flat local
+	FrequencyFixture fx{ };
+	auto& ir = fx.ir;
+	auto stmt = fx.output(ir.bin(ir::Op::Mul, ir.var(fx.f), ir.var(fx.a), HLSVType::Float));
+	auto syms = ir::HoistToVertexStage(ir.module, 4);
+	CHECK(syms.size() == 1 && syms[0]->is_flat);
+	CHECK(stmt->value->kind == ir::ExprKind::Variable);
+}
+
+// ====================================================================================================================
+TEST(frequency_keeps_nonlinear)
+{
+	FrequencyFixture fx{ };
+	auto& ir = fx.ir;
+	const std::vector<ir::Expr*> values{
+		ir.bin(ir::Op::Mul, ir.var(fx.l), ir.var(fx.l), HLSVType::Float), // Quadratic
+		ir.call("sin", HLSVType::Float, { ir.var(fx.l) }),
+		ir.call("dFdx", HLSVType::Float, { ir.var(fx.l) }),
+		ir.bin(ir::Op::Mul, ir.var(fx.l), ir.var(fx.f), HLSVType::Float), // Coefficient changes between vertices
+		ir.bin(ir::Op::Add, ir.var(fx.l), ir.var(fx.f), HLSVType::Float),
+		ir.bin(ir::Op::Div, ir.var(fx.a), ir.var(fx.l), HLSVType::Float)
+	};
+	std::vector<ir::Stmt*> stmts{ };
+	for (auto val : values)
+		stmts.push_back(fx.output(val));
+	CHECK(ir::HoistToVertexStage(ir.module, 16).empty());
+	CHECK(fx.vert->body.empty());
+	for (size_t i = 0; i < values.size(); ++i)
+		CHECK(stmts[i]->value == values[i]);
+}
+
+// ====================================================================================================================
+TEST(frequency_free_slots)
+{
+	// Only one slot is free, so the second expression stays, but the repeat of the first still shares its local
+	FrequencyFixture fx{ };
+	auto& ir = fx.ir;
+	auto s1 = fx.output(ir.bin(ir::Op::Add, ir.var(fx.l), ir.var(fx.a), HLSVType::Float));
+	auto second = ir.bin(ir::Op::Sub, ir.var(fx.l), ir.var(fx.b), HLSVType::Float);
+	auto s2 = fx.output(second);
+	auto s3 = fx.output(ir.bin(ir::Op::Add, ir.var(fx.l), ir.var(fx.a), HLSVType::Float));
+	auto syms = ir::HoistToVertexStage(ir.module, 1);
+	CHECK(syms.size() == 1 && CountStmts(fx.vert->body) == 1);
+	CHECK(s1->value->kind == ir::ExprKind::Variable && s3->value->kind == ir::ExprKind::Variable);
+	CHECK(s1->value->symbol == s3->value->symbol && s2->value == second);
+	CHECK(ir::HoistToVertexStage(ir.module, 0).empty());
+}
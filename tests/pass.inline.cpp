@@ -0,0 +1,83 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the user function inlining pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Creates 'float twice(float v) { return v * 2.0; }'
+static ir::Function* make_twice(IRBuilder& ir, ir::InlineHint hint = ir::InlineHint::None)
+{
+	auto param = ir.sym("v", HLSVType::Float);
+	auto func = ir.module.new_user_function("twice", HLSVType::Float, { param });
+	func->hint = hint;
+	auto ret = ir.module.new_stmt(ir::StmtKind::Return, 1);
+	ret->value = ir.bin(ir::Op::Mul, ir.var(param), ir.lit(2.0f), HLSVType::Float);
+	func->body.append(ret);
+	return func;
+}
+
+// ====================================================================================================================
+static ir::Expr* call_func(IRBuilder& ir, ir::Function* func, ir::Expr* arg)
+{
+	auto call = ir.call(func->name, func->return_type, { arg });
+	call->func = func;
+	return call;
+}
+
+// ====================================================================================================================
+TEST(inline_small_function)
+{
+	IRBuilder ir{ };
+	auto twice = make_twice(ir);
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float), out = ir.sym("out", HLSVType::Float, VarScope::Output);
+	auto stmt = ir.assign(func->body, ir.var(out), call_func(ir, twice, ir.var(x)));
+	CHECK(ir::InlineFunctions(ir.module, *func));
+	CHECK(stmt->value->kind == ir::ExprKind::Binary && stmt->value->args[0]->symbol == x);
+}
+
+// ====================================================================================================================
+TEST(inline_noinline_hint)
+{
+	IRBuilder ir{ };
+	auto twice = make_twice(ir, ir::InlineHint::NoInline);
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto x = ir.sym("x", HLSVType::Float), out = ir.sym("out", HLSVType::Float, VarScope::Output);
+	ir.assign(func->body, ir.var(out), call_func(ir, twice, ir.var(x)));
+	CHECK(!ir::InlineFunctions(ir.module, *func));
+}
+
+// ====================================================================================================================
+TEST(inline_skips_conditional_calls)
+{
+	// out = c ? twice(x) : 0.0; and out = c && (twice(x) > 1.0); -- the calls must stay guarded
+	IRBuilder ir{ };
+	auto twice = make_twice(ir, ir::InlineHint::Inline);
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto c = ir.sym("c", HLSVType::Bool), x = ir.sym("x", HLSVType::Float);
+	auto out = ir.sym("out", HLSVType::Float, VarScope::Output), flag = ir.sym("flag", HLSVType::Bool);
+	auto sel = ir.module.new_ternary(ir.var(c), call_func(ir, twice, ir.var(x)), ir.lit(0.0f), HLSVType::Float, 1);
+	ir.assign(func->body, ir.var(out), sel);
+	auto cmp = ir.bin(ir::Op::Gt, call_func(ir, twice, ir.var(x)), ir.lit(1.0f), HLSVType::Bool);
+	ir.assign(func->body, ir.var(flag), ir.bin(ir::Op::LogAnd, ir.var(c), cmp, HLSVType::Bool));
+	CHECK(!ir::InlineFunctions(ir.module, *func));
+	CHECK(CountStmts(func->body) == 2);
+	CHECK(sel->args[1]->kind == ir::ExprKind::Call && cmp->args[0]->kind == ir::ExprKind::Call);
+
+	// The condition of the ternary always runs, so it is still inlined
+	auto func2 = ir.module.new_function(ShaderStages::Fragment);
+	auto cond = ir.bin(ir::Op::Gt, call_func(ir, twice, ir.var(x)), ir.lit(1.0f), HLSVType::Bool);
+	ir.assign(func2->body, ir.var(out), ir.module.new_ternary(cond, ir.var(x), ir.lit(0.0f), HLSVType::Float, 1));
+	CHECK(ir::InlineFunctions(ir.module, *func2));
+}
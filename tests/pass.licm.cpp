@@ -0,0 +1,136 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the loop invariant code motion pass
+
+#include "test.hpp"
+#include <cstring>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Builds 'while (o < 10.0) { }' at the end of the function
+static ir::Stmt* make_while(IRBuilder& ir, ir::Function* func, ir::Symbol* o)
+{
+	return ir.loop(func->body, ir::StmtKind::While, ir.bin(ir::Op::Lt, ir.var(o), ir.lit(10.0f), HLSVType::Bool));
+}
+
+// ====================================================================================================================
+// Counts the temporaries declared before the loop
+static uint32 count_hoisted(const ir::Function* func, const ir::Stmt* loop)
+{
+	uint32 count = 0;
+	for (auto stmt = func->body.first; stmt != loop; stmt = stmt->next) {
+		if (stmt->kind == ir::StmtKind::Declare && std::strncmp(stmt->symbol->name, "_licm", 5) == 0)
+			++count;
+	}
+	return count;
+}
+
+// ====================================================================================================================
+TEST(licm_hoists_invariant)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Uniform), b = ir.sym("b", HLSVType::Float, VarScope::Uniform);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	auto loop = make_while(ir, func, o);
+	ir.assign(loop->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float), ir::Op::Add);
+	CHECK(ir::HoistLoopInvariants(ir.module, *func));
+	CHECK(count_hoisted(func, loop) == 1);
+	CHECK(loop->body.first->value->kind == ir::ExprKind::Variable);
+	CHECK(loop->body.first->value->symbol == func->body.first->symbol);
+}
+
+// ====================================================================================================================
+TEST(licm_written_variable_is_variant)
+{
+	// while (o < 10) { o += a * b; if (o > 5) { a = 1.0; } } -- the write after the use still blocks hoisting
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float), b = ir.sym("b", HLSVType::Float, VarScope::Uniform);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	ir.declare(func->body, a, ir.var(b));
+	auto loop = make_while(ir, func, o);
+	auto use = ir.assign(loop->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float),
+		ir::Op::Add);
+	auto br = ir.branch(loop->body, ir.bin(ir::Op::Gt, ir.var(o), ir.lit(5.0f), HLSVType::Bool));
+	ir.assign(br->body, ir.var(a), ir.lit(1.0f));
+	CHECK(!ir::HoistLoopInvariants(ir.module, *func));
+	CHECK(use->value->kind == ir::ExprKind::Binary);
+
+	// The variables declared in the loop are also variant
+	auto loop2 = make_while(ir, func, o);
+	auto t = ir.sym("t", HLSVType::Float);
+	ir.declare(loop2->body, t, ir.var(o));
+	ir.assign(loop2->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(t), ir.var(b), HLSVType::Float));
+	CHECK(!ir::HoistLoopInvariants(ir.module, *func));
+}
+
+// ====================================================================================================================
+TEST(licm_image_load_with_stores)
+{
+	// imageLoad is only hoisted if the loop does not store to any image
+	for (bool store : { false, true }) {
+		IRBuilder ir{ };
+		auto func = ir.module.new_function(ShaderStages::Fragment);
+		auto img = ir.sym("img", HLSVType::Image2D, VarScope::Uniform);
+		auto c = ir.sym("c", HLSVType::Int2, VarScope::Uniform);
+		auto o = ir.sym("o", HLSVType::Float4, VarScope::Output);
+		auto loop = ir.loop(func->body, ir::StmtKind::While,
+			ir.bin(ir::Op::Lt, ir.index(ir.var(o), ir.lit(0), HLSVType::Float), ir.lit(10.0f), HLSVType::Bool));
+		auto load = ir.call("imageLoad", HLSVType::Float4, { ir.var(img), ir.var(c) });
+		ir.assign(loop->body, ir.var(o), load, ir::Op::Add);
+		if (store) {
+			auto eval = ir.module.new_stmt(ir::StmtKind::Eval, 1);
+			eval->value = ir.call("imageStore", HLSVType::Void, { ir.var(img), ir.var(c), ir.var(o) });
+			loop->body.append(eval);
+		}
+		CHECK(ir::HoistLoopInvariants(ir.module, *func) == !store);
+		CHECK(count_hoisted(func, loop) == (store ? 0u : 1u));
+		CHECK((loop->body.first->value == load) == store);
+	}
+}
+
+// ====================================================================================================================
+TEST(licm_dynamic_index)
+{
+	// arr[u] * s is not hoisted, as the index is only known to be in range when the loop runs, arr[1] * s is
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Uniform);
+	auto u = ir.sym("u", HLSVType::Int, VarScope::Uniform), s = ir.sym("s", HLSVType::Float, VarScope::Uniform);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	auto loop = make_while(ir, func, o);
+	auto dyn = ir.bin(ir::Op::Mul, ir.index(ir.var(arr), ir.var(u), HLSVType::Float), ir.var(s), HLSVType::Float);
+	auto fixed = ir.bin(ir::Op::Mul, ir.index(ir.var(arr), ir.lit(1), HLSVType::Float), ir.var(s), HLSVType::Float);
+	auto s1 = ir.assign(loop->body, ir.var(o), dyn, ir::Op::Add);
+	auto s2 = ir.assign(loop->body, ir.var(o), fixed, ir::Op::Add);
+	CHECK(ir::HoistLoopInvariants(ir.module, *func));
+	CHECK(count_hoisted(func, loop) == 1 && func->body.first->value == fixed);
+	CHECK(s1->value == dyn && s2->value->kind == ir::ExprKind::Variable);
+}
+
+// ====================================================================================================================
+TEST(licm_shares_identical_temps)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Uniform), b = ir.sym("b", HLSVType::Float, VarScope::Uniform);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output), p = ir.sym("p", HLSVType::Float, VarScope::Output);
+	auto loop = make_while(ir, func, o);
+	auto s1 = ir.assign(loop->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float), ir::Op::Add);
+	auto br = ir.branch(loop->body, ir.bin(ir::Op::Gt, ir.var(o), ir.lit(5.0f), HLSVType::Bool));
+	auto s2 = ir.assign(br->body, ir.var(p), ir.bin(ir::Op::Mul, ir.var(a), ir.var(b), HLSVType::Float));
+	CHECK(ir::HoistLoopInvariants(ir.module, *func));
+	CHECK(count_hoisted(func, loop) == 1);
+	CHECK(s1->value->kind == ir::ExprKind::Variable && s2->value->kind == ir::ExprKind::Variable);
+	CHECK(s1->value->symbol == s2->value->symbol);
+}
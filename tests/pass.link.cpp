@@ -0,0 +1,83 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the stage linking pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(link_folds_constant_locals)
+{
+	// vert: c = 2.0; -- frag: o = c * x; becomes o = 2.0 * x, and c is no longer passed
+	IRBuilder ir{ };
+	auto vert = ir.module.new_function(ShaderStages::Vertex);
+	auto frag = ir.module.new_function(ShaderStages::Fragment);
+	auto c = ir.sym("c", HLSVType::Float, VarScope::Local), x = ir.sym("x", HLSVType::Float, VarScope::Uniform);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	ir.assign(vert->body, ir.var(c), ir.lit(2.0f));
+	auto stmt = ir.assign(frag->body, ir.var(o), ir.bin(ir::Op::Mul, ir.var(c), ir.var(x), HLSVType::Float));
+
+	ir::SymbolSet passed{ };
+	CHECK(ir::LinkStages(ir.module, passed));
+	CHECK(passed.empty() && vert->body.empty());
+	auto left = stmt->value->args[0];
+	CHECK(left->is_literal() && left->value.f == 2.0f && stmt->value->args[1]->symbol == x);
+}
+
+// ====================================================================================================================
+TEST(link_removes_unread_locals)
+{
+	// vert: u = a * 2.0; w = u + 1.0; z = a; -- frag: o = w; -- u is only used by the vertex stage, z is never read
+	IRBuilder ir{ };
+	auto vert = ir.module.new_function(ShaderStages::Vertex);
+	auto frag = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Attribute);
+	auto u = ir.sym("u", HLSVType::Float, VarScope::Local), w = ir.sym("w", HLSVType::Float, VarScope::Local);
+	auto z = ir.sym("z", HLSVType::Float, VarScope::Local), o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	ir.assign(vert->body, ir.var(u), ir.bin(ir::Op::Mul, ir.var(a), ir.lit(2.0f), HLSVType::Float));
+	ir.assign(vert->body, ir.var(w), ir.bin(ir::Op::Add, ir.var(u), ir.lit(1.0f), HLSVType::Float));
+	ir.assign(vert->body, ir.var(z), ir.var(a));
+	ir.assign(frag->body, ir.var(o), ir.var(w));
+
+	ir::SymbolSet passed{ };
+	CHECK(ir::LinkStages(ir.module, passed));
+	CHECK(passed.size() == 1 && passed.count(w));
+	CHECK(CountStmts(vert->body) == 3);
+	auto decl = vert->body.first;
+	CHECK(decl->kind == ir::StmtKind::Declare && decl->symbol == u && !decl->value);
+	CHECK(u->scope == VarScope::Block && w->scope == VarScope::Local);
+	CHECK(decl->next->target->symbol == u && vert->body.last->target->symbol == w);
+}
+
+// ====================================================================================================================
+TEST(link_keeps_conditional_locals)
+{
+	// vert: if (a > 0) { c = 1.0; } d = 1.0; d = 2.0; -- frag: o = c + d; -- neither is always the same constant
+	IRBuilder ir{ };
+	auto vert = ir.module.new_function(ShaderStages::Vertex);
+	auto frag = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Attribute);
+	auto c = ir.sym("c", HLSVType::Float, VarScope::Local), d = ir.sym("d", HLSVType::Float, VarScope::Local);
+	auto o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	auto br = ir.branch(vert->body, ir.bin(ir::Op::Gt, ir.var(a), ir.lit(0.0f), HLSVType::Bool));
+	ir.assign(br->body, ir.var(c), ir.lit(1.0f));
+	ir.assign(vert->body, ir.var(d), ir.lit(1.0f));
+	ir.assign(vert->body, ir.var(d), ir.lit(2.0f));
+	auto sum = ir.bin(ir::Op::Add, ir.var(c), ir.var(d), HLSVType::Float);
+	auto stmt = ir.assign(frag->body, ir.var(o), sum);
+
+	ir::SymbolSet passed{ };
+	CHECK(ir::LinkStages(ir.module, passed));
+	CHECK(passed.size() == 2 && passed.count(c) && passed.count(d));
+	CHECK(stmt->value == sum && sum->args[0]->is_variable() && sum->args[1]->is_variable());
+	CHECK(CountStmts(vert->body) == 3 && CountStmts(br->body) == 1);
+}
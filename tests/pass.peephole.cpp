@@ -0,0 +1,204 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests and the benchmark for the peephole pass, with one test for each rule
+
+#include "test.hpp"
+#include <cstdio>
+#include <cstring>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Runs the pass on the single assignment 'out = expr', and returns the new value
+static ir::Expr* run_peephole(IRBuilder& ir, ir::Expr* expr, bool fast_math = false)
+{
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto out = ir.sym("out", expr->type, VarScope::Output);
+	auto stmt = ir.assign(func->body, ir.var(out), expr);
+	CompilerOptions options{ };
+	options.fast_math = fast_math;
+	ir::OptimizePeephole(ir.module, *func, options);
+	return stmt->value;
+}
+
+// ====================================================================================================================
+static inline bool is_call_to(const ir::Expr* expr, const char* name)
+{
+	return expr->kind == ir::ExprKind::Call && !std::strcmp(expr->out_name, name);
+}
+
+// ====================================================================================================================
+TEST(peephole_div_exact_reciprocal)
+{
+	IRBuilder ir{ };
+	auto x = ir.var(ir.sym("x", HLSVType::Float));
+	auto res = run_peephole(ir, ir.bin(ir::Op::Div, x, ir.lit(4.0f), HLSVType::Float));
+	CHECK(res->op == ir::Op::Mul && res->args[1]->value.f == 0.25f);
+}
+
+// ====================================================================================================================
+TEST(peephole_div_inexact_reciprocal)
+{
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto res = run_peephole(ir, ir.bin(ir::Op::Div, ir.var(x), ir.lit(3.0f), HLSVType::Float));
+	CHECK(res->op == ir::Op::Div);
+	res = run_peephole(ir, ir.bin(ir::Op::Div, ir.var(x), ir.lit(3.0f), HLSVType::Float), true);
+	CHECK(res->op == ir::Op::Mul);
+}
+
+// ====================================================================================================================
+TEST(peephole_pow_one)
+{
+	IRBuilder ir{ };
+	auto x = ir.var(ir.sym("x", HLSVType::Float));
+	CHECK(run_peephole(ir, ir.call("pow", HLSVType::Float, { x, ir.lit(1.0f) })) == x);
+}
+
+// ====================================================================================================================
+TEST(peephole_pow_two)
+{
+	IRBuilder ir{ };
+	auto x = ir.var(ir.sym("x", HLSVType::Float));
+	auto res = run_peephole(ir, ir.call("pow", HLSVType::Float, { x, ir.lit(2.0f) }));
+	CHECK(res->op == ir::Op::Mul);
+	CHECK(res->args[0] != res->args[1]); // The operands must not share a node
+	CHECK(res->args[0]->symbol == res->args[1]->symbol);
+}
+
+// ====================================================================================================================
+TEST(peephole_pow_sqrt_fast_math)
+{
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float);
+	CHECK(is_call_to(run_peephole(ir, ir.call("pow", HLSVType::Float, { ir.var(x), ir.lit(0.5f) })), "pow"));
+	CHECK(is_call_to(run_peephole(ir, ir.call("pow", HLSVType::Float, { ir.var(x), ir.lit(0.5f) }), true), "sqrt"));
+	CHECK(is_call_to(run_peephole(ir, ir.call("pow", HLSVType::Float, { ir.var(x), ir.lit(-0.5f) })), "pow"));
+	CHECK(is_call_to(run_peephole(ir, ir.call("pow", HLSVType::Float, { ir.var(x), ir.lit(-0.5f) }), true),
+		"inversesqrt"));
+}
+
+// ====================================================================================================================
+TEST(peephole_mul_one)
+{
+	IRBuilder ir{ };
+	auto x = ir.var(ir.sym("x", HLSVType::Float));
+	CHECK(run_peephole(ir, ir.bin(ir::Op::Mul, ir.lit(1.0f), x, HLSVType::Float)) == x);
+}
+
+// ====================================================================================================================
+TEST(peephole_add_zero)
+{
+	// x + 0 is +0 for x = -0, so only -0 is removed without fast math, integers are always exact
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto res = run_peephole(ir, ir.bin(ir::Op::Add, ir.var(x), ir.lit(0.0f), HLSVType::Float));
+	CHECK(res->op == ir::Op::Add);
+	res = run_peephole(ir, ir.bin(ir::Op::Add, ir.var(x), ir.lit(-0.0f), HLSVType::Float));
+	CHECK(res->kind == ir::ExprKind::Variable);
+	res = run_peephole(ir, ir.bin(ir::Op::Add, ir.var(x), ir.lit(0.0f), HLSVType::Float), true);
+	CHECK(res->kind == ir::ExprKind::Variable);
+	auto i = ir.sym("i", HLSVType::Int);
+	res = run_peephole(ir, ir.bin(ir::Op::Add, ir.lit(0), ir.var(i), HLSVType::Int));
+	CHECK(res->kind == ir::ExprKind::Variable);
+}
+
+// ====================================================================================================================
+TEST(peephole_sub_zero)
+{
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto res = run_peephole(ir, ir.bin(ir::Op::Sub, ir.var(x), ir.lit(0.0f), HLSVType::Float));
+	CHECK(res->kind == ir::ExprKind::Variable);
+	res = run_peephole(ir, ir.bin(ir::Op::Sub, ir.var(x), ir.lit(-0.0f), HLSVType::Float));
+	CHECK(res->op == ir::Op::Sub);
+}
+
+// ====================================================================================================================
+TEST(peephole_saturate)
+{
+	IRBuilder ir{ };
+	auto x = ir.sym("x", HLSVType::Float);
+	auto inner = ir.call("max", HLSVType::Float, { ir.var(x), ir.lit(0.0f) });
+	auto res = run_peephole(ir, ir.call("min", HLSVType::Float, { inner, ir.lit(1.0f) }));
+	CHECK(is_call_to(res, "clamp") && res->args[0]->symbol == x);
+}
+
+// ====================================================================================================================
+TEST(peephole_double_negation)
+{
+	IRBuilder ir{ };
+	auto x = ir.var(ir.sym("x", HLSVType::Float));
+	auto neg = ir.module.new_unary(ir::Op::Neg, x, HLSVType::Float, 1);
+	CHECK(run_peephole(ir, ir.module.new_unary(ir::Op::Neg, neg, HLSVType::Float, 1)) == x);
+}
+
+// ====================================================================================================================
+TEST(peephole_chained_swizzle)
+{
+	// v.zyx.yx -> v.yz
+	IRBuilder ir{ };
+	auto v = ir.var(ir.sym("v", HLSVType::Float4));
+	const uint8 first[] = { 2, 1, 0 }, second[] = { 1, 0 };
+	auto sw = ir.module.new_swizzle(v, first, 3, HLSVType::Float3, 1);
+	auto res = run_peephole(ir, ir.module.new_swizzle(sw, second, 2, HLSVType::Float2, 1));
+	CHECK(res->kind == ir::ExprKind::Swizzle && res->args[0] == v);
+	CHECK(res->swizzle[0] == 1 && res->swizzle[1] == 2);
+}
+
+// ====================================================================================================================
+TEST(peephole_identity_swizzle)
+{
+	IRBuilder ir{ };
+	auto v = ir.var(ir.sym("v", HLSVType::Float3));
+	const uint8 comps[] = { 0, 1, 2 };
+	CHECK(run_peephole(ir, ir.module.new_swizzle(v, comps, 3, HLSVType::Float3, 1)) == v);
+}
+
+// ====================================================================================================================
+TEST(peephole_same_type_cast)
+{
+	IRBuilder ir{ };
+	auto v = ir.var(ir.sym("v", HLSVType::Float2));
+	CHECK(run_peephole(ir, ir.module.new_construct(HLSVType::Float2, { v }, 1)) == v);
+}
+
+// ====================================================================================================================
+BENCH(peephole_pass)
+{
+	// A material-style function that repeats the patterns the pass targets, reports the nodes and cost saved
+	const uint32 COUNT = 256;
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto uv = ir.sym("uv", HLSVType::Float2), col = ir.sym("col", HLSVType::Float, VarScope::Output);
+	const uint8 xy[] = { 0, 1 }, x[] = { 0 };
+	for (uint32 i = 0; i < COUNT; ++i) {
+		auto sw = ir.module.new_swizzle(ir.module.new_swizzle(ir.var(uv), xy, 2, HLSVType::Float2, 1), x, 1,
+			HLSVType::Float, 1);
+		auto scaled = ir.bin(ir::Op::Div, ir.bin(ir::Op::Mul, sw, ir.lit(1.0f), HLSVType::Float), ir.lit(2.0f),
+			HLSVType::Float);
+		auto sq = ir.call("pow", HLSVType::Float, { scaled, ir.lit(2.0f) });
+		auto sat = ir.call("min", HLSVType::Float, { ir.call("max", HLSVType::Float, { sq, ir.lit(0.0f) }),
+			ir.lit(1.0f) });
+		ir.assign(func->body, ir.var(col), sat, ir::Op::Add);
+	}
+
+	auto before = ir::EstimateCost(ir.module, *func);
+	uint32 nodes_before = ir::GetBlockSize(func->body);
+	CompilerOptions options{ };
+	ir::OptimizePeephole(ir.module, *func, options);
+	auto after = ir::EstimateCost(ir.module, *func);
+	uint32 nodes_after = ir::GetBlockSize(func->body);
+	double ns = TimeRuns(100, [&]() { ir::OptimizePeephole(ir.module, *func, options); });
+	std::printf("  nodes: %u -> %u, alu cost: %u -> %u, %.1f us per pass over %u statements\n", nodes_before,
+		nodes_after, before.alu_cost, after.alu_cost, ns / 1000.0, COUNT);
+	CHECK(after.alu_cost < before.alu_cost);
+}
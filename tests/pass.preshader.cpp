@@ -0,0 +1,166 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the preshader bytecode and the preshader extraction pass
+
+#include "test.hpp"
+#include "ir/preshader.hpp"
+#include <cstring>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// A uniform block with s (float, 0), v (vec4, 16), and arr (float[4], 32), and push constants p (float, 0) and
+//    pv (vec2, 8), with the symbols given the same values so the compile time evaluation can be compared
+struct PreshaderFixture final
+{
+	IRBuilder ir;
+	ReflectionInfo refl;
+	float block[16];
+	float push[4];
+	ir::Symbol *s, *v, *arr, *p, *pv;
+
+	PreshaderFixture() :
+		ir{ }, refl{ ShaderType::Graphics, HLSV_VERSION, 100 },
+		block{ 1.5f, 0, 0, 0, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f },
+		push{ 0.25f, 0, -1.0f, 10.0f }
+	{
+		refl.blocks.emplace_back(0, 0);
+		refl.blocks[0].size = 64;
+		refl.uniforms.emplace_back("s", HLSVType::Float, 0, 0, 0, 0, 4);
+		refl.uniforms.emplace_back("v", HLSVType::Float4, 0, 0, 0, 16, 16);
+		refl.uniforms.emplace_back("arr", HLSVType{ HLSVType::Float, 4 }, 0, 0, 0, 32, 16);
+		refl.push_constants.emplace_back("p", HLSVType::Float, 0, 4);
+		refl.push_constants.emplace_back("pv", HLSVType::Float2, 8, 8);
+		refl.push_constants_size = 16;
+
+		s = ir.sym("s", HLSVType::Float, VarScope::Uniform);
+		v = ir.sym("v", HLSVType::Float4, VarScope::Uniform);
+		arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Uniform);
+		p = ir.sym("p", HLSVType::Float, VarScope::PushConstant);
+		pv = ir.sym("pv", HLSVType::Float2, VarScope::PushConstant);
+		s->value = ir.lit(1.5f);
+		v->value = ir.module.new_construct(HLSVType::Float4,
+			{ ir.lit(2.0f), ir.lit(3.0f), ir.lit(4.0f), ir.lit(5.0f) }, 1);
+		p->value = ir.lit(0.25f);
+		pv->value = ir.module.new_construct(HLSVType::Float2, { ir.lit(-1.0f), ir.lit(10.0f) }, 1);
+	}
+
+	bool evaluate(const ir::Expr* expr, ir::ConstValue& val) {
+		std::vector<uint8> code{ };
+		const void* blocks[1] = { block };
+		return ir::EncodePreshader(expr, refl, code) && ir::EvaluatePreshader(code, refl, blocks, push, val);
+	}
+};
+
+// ====================================================================================================================
+static bool same_value(const ir::ConstValue& l, const ir::ConstValue& r)
+{
+	if (l.type != r.type)
+		return false;
+	for (uint32 i = 0; i < l.count(); ++i) {
+		if (l.comps[i].ui != r.comps[i].ui)
+			return false;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+TEST(preshader_matches_constant_eval)
+{
+	PreshaderFixture fx{ };
+	auto& ir = fx.ir;
+	uint8 zx[2] = { 2, 0 };
+	const std::vector<ir::Expr*> exprs{
+		ir.bin(ir::Op::Add, ir.bin(ir::Op::Mul, ir.var(fx.s), ir.lit(2.0f), HLSVType::Float), ir.lit(1.0f),
+			HLSVType::Float), // Uniform, Const, Binary
+		ir.bin(ir::Op::Sub, ir.var(fx.p), ir.var(fx.s), HLSVType::Float), // Push
+		ir.bin(ir::Op::Mul, ir.module.new_swizzle(ir.var(fx.v), zx, 2, HLSVType::Float2, 1), ir.var(fx.pv),
+			HLSVType::Float2), // Swizzle
+		ir.bin(ir::Op::Mul, ir.index(ir.var(fx.v), ir.lit(1), HLSVType::Float), ir.var(fx.p), HLSVType::Float), // Index
+		ir.call("max", HLSVType::Float, { ir.var(fx.s), ir.index(ir.var(fx.pv), ir.lit(1), HLSVType::Float) }), // Call
+		ir.call("dot", HLSVType::Float, { ir.var(fx.v), ir.var(fx.v) }),
+		ir.module.new_construct(HLSVType::Float3, { ir.var(fx.pv), ir.var(fx.s) }, 1), // Construct
+		ir.module.new_ternary(ir.bin(ir::Op::Gt, ir.var(fx.s), ir.var(fx.p), HLSVType::Bool), ir.var(fx.s),
+			ir.var(fx.p), HLSVType::Float, 1), // Ternary
+		ir.module.new_unary(ir::Op::Neg, ir.var(fx.pv), HLSVType::Float2, 1) // Unary
+	};
+	for (size_t i = 0; i < exprs.size(); ++i) {
+		ir::ConstValue pre, ref;
+		if (!fx.evaluate(exprs[i], pre) || !ir::EvaluateConstant(exprs[i], ref) || !same_value(pre, ref))
+			throw TestFailure{ strarg("Preshader expression %u does not match the constant value", (uint32)i) };
+	}
+
+	// Arrays are loaded element by element with constant indices
+	ir::ConstValue val;
+	auto elem = ir.bin(ir::Op::Mul, ir.index(ir.var(fx.arr), ir.lit(2), HLSVType::Float), ir.var(fx.s),
+		HLSVType::Float);
+	CHECK(fx.evaluate(elem, val) && val.type == HLSVType::Float && val.comps[0].f == 12.0f);
+}
+
+// ====================================================================================================================
+TEST(preshader_refuses_unknown_values)
+{
+	PreshaderFixture fx{ };
+	auto& ir = fx.ir;
+	auto local = ir.sym("t", HLSVType::Float);
+	std::vector<uint8> code{ };
+	CHECK(!ir::EncodePreshader(ir.bin(ir::Op::Mul, ir.var(local), ir.var(fx.s), HLSVType::Float), fx.refl, code));
+	code.clear();
+	auto u = ir.sym("u", HLSVType::Int, VarScope::Uniform); // Not in the reflection info
+	CHECK(!ir::EncodePreshader(ir.index(ir.var(fx.arr), ir.var(u), HLSVType::Float), fx.refl, code));
+	code.clear();
+	CHECK(!ir::EncodePreshader(ir.index(ir.var(fx.arr), ir.lit(4), HLSVType::Float), fx.refl, code));
+
+	// Division by zero is undefined, so the evaluation fails
+	ir::ConstValue val;
+	auto div = ir.bin(ir::Op::Div, ir.var(fx.s), ir.bin(ir::Op::Sub, ir.var(fx.p), ir.var(fx.p), HLSVType::Float),
+		HLSVType::Float);
+	CHECK(!fx.evaluate(div, val));
+}
+
+// ====================================================================================================================
+TEST(preshader_block_limits)
+{
+	// o1 = s * 2, o2 = s * 3, o3 = v * s, o4 = s * 2 -- an 8 byte block only fits the two floats, the repeat is shared
+	PreshaderFixture fx{ };
+	auto& ir = fx.ir;
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	std::vector<ir::Stmt*> stmts{ };
+	const std::vector<ir::Expr*> values{
+		ir.bin(ir::Op::Mul, ir.var(fx.s), ir.lit(2.0f), HLSVType::Float),
+		ir.bin(ir::Op::Mul, ir.var(fx.s), ir.lit(3.0f), HLSVType::Float),
+		ir.bin(ir::Op::Mul, ir.var(fx.v), ir.var(fx.s), HLSVType::Float4),
+		ir.bin(ir::Op::Mul, ir.var(fx.s), ir.lit(2.0f), HLSVType::Float)
+	};
+	for (auto val : values)
+		stmts.push_back(ir.assign(func->body, ir.var(ir.sym("o", val->type, VarScope::Output)), val));
+	auto syms = ir::ExtractPreshader(ir.module, fx.refl, 8);
+	CHECK(syms.size() == 2 && fx.refl.preshader.size() == 2);
+	CHECK(fx.refl.preshader[0].offset == 0 && fx.refl.preshader[1].offset == 4);
+	CHECK(stmts[0]->value->kind == ir::ExprKind::Variable && stmts[0]->value->symbol == syms[0]);
+	CHECK(stmts[1]->value->kind == ir::ExprKind::Variable && stmts[1]->value->symbol == syms[1]);
+	CHECK(stmts[2]->value == values[2]); // Stays on the GPU
+	CHECK(stmts[3]->value->kind == ir::ExprKind::Variable && stmts[3]->value->symbol == syms[0]);
+
+	// Only 255 uniforms can be reflected, including the new preshader uniforms
+	PreshaderFixture full{ };
+	while (full.refl.uniforms.size() < 254) {
+		auto name = strarg("pad%u", (uint32)full.refl.uniforms.size());
+		full.refl.uniforms.emplace_back(name, HLSVType::Float, 1, 0, 1, 0, 4);
+	}
+	auto func2 = full.ir.module.new_function(ShaderStages::Fragment);
+	auto o = full.ir.sym("o", HLSVType::Float, VarScope::Output);
+	auto first = full.ir.assign(func2->body, full.ir.var(o),
+		full.ir.bin(ir::Op::Mul, full.ir.var(full.s), full.ir.lit(2.0f), HLSVType::Float));
+	auto second = full.ir.assign(func2->body, full.ir.var(o),
+		full.ir.bin(ir::Op::Mul, full.ir.var(full.s), full.ir.lit(3.0f), HLSVType::Float));
+	CHECK(ir::ExtractPreshader(full.ir.module, full.refl, 256).size() == 1);
+	CHECK(first->value->kind == ir::ExprKind::Variable && second->value->kind == ir::ExprKind::Binary);
+}
@@ -0,0 +1,97 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the profiling instrumentation and the profiling report
+
+#include "test.hpp"
+#include <cstring>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Checks that the statement increments the counter with the given index
+static bool is_counter(const ir::Stmt* stmt, const ir::Symbol* counters, uint32 index)
+{
+	if (!stmt || stmt->kind != ir::StmtKind::Eval || stmt->value->kind != ir::ExprKind::Call ||
+			std::strcmp(stmt->value->out_name, "atomicAdd") != 0)
+		return false;
+	auto elem = stmt->value->args[0];
+	return elem->kind == ir::ExprKind::Index && elem->args[0]->symbol == counters && elem->args[1]->is_literal() &&
+		elem->args[1]->value.ui == index;
+}
+
+// ====================================================================================================================
+TEST(profile_counter_placement)
+{
+	// 10: o = 1.0;
+	// 11: if (a > 0.0) { 12: o = 2.0; }
+	// 13: elif (a < 0.0) { 14: o = 3.0; }
+	// 15: else { 16: o = 4.0; }
+	// 18: for (...) { 19: o += 1.0; }
+	// 21: while (a > o) { }
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto a = ir.sym("a", HLSVType::Float, VarScope::Uniform), o = ir.sym("o", HLSVType::Float, VarScope::Output);
+	ir.assign(func->body, ir.var(o), ir.lit(1.0f))->line = 10;
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Gt, ir.var(a), ir.lit(0.0f), HLSVType::Bool));
+	br->line = 11;
+	ir.assign(br->body, ir.var(o), ir.lit(2.0f))->line = 12;
+	auto elif = ir.branch(br->else_body, ir.bin(ir::Op::Lt, ir.var(a), ir.lit(0.0f), HLSVType::Bool));
+	elif->line = 13;
+	elif->is_elif = true;
+	ir.assign(elif->body, ir.var(o), ir.lit(3.0f))->line = 14;
+	ir.assign(elif->else_body, ir.var(o), ir.lit(4.0f))->line = 16;
+	auto i = ir.sym("i", HLSVType::Int);
+	auto loop = ir.loop(func->body, ir::StmtKind::For, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(4), HLSVType::Bool));
+	loop->line = 18;
+	loop->symbol = i;
+	loop->init = ir.lit(0);
+	ir.assign(loop->updates, ir.var(i), ir.lit(1), ir::Op::Add);
+	ir.assign(loop->body, ir.var(o), ir.lit(1.0f), ir::Op::Add)->line = 19;
+	auto wl = ir.loop(func->body, ir::StmtKind::While, ir.bin(ir::Op::Gt, ir.var(a), ir.var(o), HLSVType::Bool));
+	wl->line = 21;
+
+	ReflectionInfo refl{ ShaderType::Graphics, HLSV_VERSION, 100 };
+	auto counters = ir::InstrumentProfiling(ir.module, { func }, refl);
+	CHECK(counters && counters->scope == VarScope::Uniform);
+
+	// One counter for the function, each branch arm, and each loop body, in order
+	const uint32 lines[] = { 10, 12, 14, 16, 19, 21 };
+	CHECK(refl.profile_counters.size() == 6);
+	for (uint32 c = 0; c < 6; ++c)
+		CHECK(refl.profile_counters[c].line == lines[c] && refl.profile_counters[c].stage == ShaderStages::Fragment);
+	CHECK(is_counter(func->body.first, counters, 0));
+	CHECK(is_counter(br->body.first, counters, 1));
+	CHECK(br->else_body.first == elif && elif->is_elif); // The elif chain is not broken by a counter
+	CHECK(is_counter(elif->body.first, counters, 2));
+	CHECK(is_counter(elif->else_body.first, counters, 3));
+	CHECK(is_counter(loop->body.first, counters, 4) && CountStmts(loop->updates) == 1);
+	CHECK(is_counter(wl->body.first, counters, 5) && CountStmts(wl->body) == 1);
+}
+
+// ====================================================================================================================
+TEST(profile_report)
+{
+	ReflectionInfo refl{ ShaderType::Graphics, HLSV_VERSION, 100 };
+	const uint32 lines[] = { 10, 12, 14, 16, 19, 12 };
+	for (auto line : lines)
+		refl.profile_counters.push_back({ line, ShaderStages::Fragment });
+	refl.profile_counters.push_back({ 10, ShaderStages::Vertex });
+
+	// Counters on the same line and stage are summed, lines that never ran are skipped, the highest count is first
+	const uint32 data[] = { 1, 5, 0, 2, 40, 50, 3 };
+	auto report = refl.get_profile_report(data);
+	CHECK(report.size() == 5);
+	CHECK(report[0].line == 12 && report[0].count == 55);
+	CHECK(report[1].line == 19 && report[1].count == 40);
+	CHECK(report[2].line == 10 && report[2].count == 3 && report[2].stage == ShaderStages::Vertex);
+	CHECK(report[3].line == 16 && report[3].count == 2);
+	CHECK(report[4].line == 10 && report[4].count == 1 && report[4].stage == ShaderStages::Fragment);
+}
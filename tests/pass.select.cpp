@@ -0,0 +1,77 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the select conversion pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(select_if_else_assign)
+{
+	// if (c) x = a; else x = b; -> x = c ? a : b;
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto c = ir.sym("c", HLSVType::Bool), x = ir.sym("x", HLSVType::Float);
+	auto a = ir.sym("a", HLSVType::Float), b = ir.sym("b", HLSVType::Float);
+	auto br = ir.branch(func->body, ir.var(c));
+	ir.assign(br->body, ir.var(x), ir.var(a));
+	ir.assign(br->else_body, ir.var(x), ir.var(b));
+	CHECK(ir::ConvertSelects(ir.module, *func));
+	CHECK(CountStmts(func->body) == 1 && func->body.first->kind == ir::StmtKind::Assign);
+	CHECK(func->body.first->value->kind == ir::ExprKind::Ternary);
+}
+
+// ====================================================================================================================
+TEST(select_if_without_else)
+{
+	// if (c) x = a; -> x = c ? a : x;
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto c = ir.sym("c", HLSVType::Bool), x = ir.sym("x", HLSVType::Float), a = ir.sym("a", HLSVType::Float);
+	auto br = ir.branch(func->body, ir.var(c));
+	ir.assign(br->body, ir.var(x), ir.var(a));
+	CHECK(ir::ConvertSelects(ir.module, *func));
+	auto sel = func->body.first->value;
+	CHECK(sel->kind == ir::ExprKind::Ternary && sel->args[2]->symbol == x);
+}
+
+// ====================================================================================================================
+TEST(select_branch_hint)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto c = ir.sym("c", HLSVType::Bool), x = ir.sym("x", HLSVType::Float), a = ir.sym("a", HLSVType::Float);
+	auto br = ir.branch(func->body, ir.var(c));
+	br->branch_hint = ir::BranchHint::Branch;
+	ir.assign(br->body, ir.var(x), ir.var(a));
+	CHECK(!ir::ConvertSelects(ir.module, *func));
+}
+
+// ====================================================================================================================
+TEST(select_guarded_dynamic_index)
+{
+	// if (i < 4) arr[i] = a; -- the condition guards the index, so the write must stay conditional
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto i = ir.sym("i", HLSVType::Int), a = ir.sym("a", HLSVType::Float);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 });
+	auto br = ir.branch(func->body, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(4), HLSVType::Bool));
+	ir.assign(br->body, ir.index(ir.var(arr), ir.var(i), HLSVType::Float), ir.var(a));
+	CHECK(!ir::ConvertSelects(ir.module, *func));
+	CHECK(func->body.first->kind == ir::StmtKind::If);
+
+	// A constant index is still converted
+	auto func2 = ir.module.new_function(ShaderStages::Fragment);
+	auto br2 = ir.branch(func2->body, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(4), HLSVType::Bool));
+	ir.assign(br2->body, ir.index(ir.var(arr), ir.lit(1), HLSVType::Float), ir.var(a));
+	CHECK(ir::ConvertSelects(ir.module, *func2));
+}
@@ -0,0 +1,165 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the loop unrolling pass
+
+#include "test.hpp"
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+// Builds 'for (int i = init; i < end; <step>) { arr[i] = 1.0; }', the step is i++ if zero, or i += step otherwise
+static ir::Stmt* make_for(IRBuilder& ir, ir::Block& block, ir::Symbol* arr, int32 init, int32 end, int32 step)
+{
+	auto i = ir.sym("i", HLSVType::Int);
+	auto loop = ir.loop(block, ir::StmtKind::For, ir.bin(ir::Op::Lt, ir.var(i), ir.lit(end), HLSVType::Bool));
+	loop->symbol = i;
+	loop->init = ir.lit(init);
+	if (step == 0) {
+		auto inc = ir.module.new_stmt(ir::StmtKind::Eval, 1);
+		inc->value = ir.module.new_unary(ir::Op::PostInc, ir.var(i), HLSVType::Int, 1);
+		loop->updates.append(inc);
+	}
+	else
+		ir.assign(loop->updates, ir.var(i), ir.lit(step), ir::Op::Add);
+	ir.assign(loop->body, ir.index(ir.var(arr), ir.var(i), HLSVType::Float), ir.lit(1.0f));
+	return loop;
+}
+
+// ====================================================================================================================
+// Checks that the block is only the array assignments, with the given literal indices
+static bool check_indices(const ir::Block& block, const std::vector<int32>& indices)
+{
+	if (CountStmts(block) != indices.size())
+		return false;
+	auto stmt = block.first;
+	for (auto idx : indices) {
+		if (stmt->kind != ir::StmtKind::Assign || stmt->target->kind != ir::ExprKind::Index)
+			return false;
+		auto lit = stmt->target->args[1];
+		if (!lit->is_literal() || lit->value.si != idx)
+			return false;
+		stmt = stmt->next;
+	}
+	return true;
+}
+
+// ====================================================================================================================
+TEST(unroll_constant_increment)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 16 }, VarScope::Local);
+	make_for(ir, func->body, arr, 0, 4, 0);
+	CHECK(ir::UnrollLoops(ir.module, *func));
+	CHECK(check_indices(func->body, { 0, 1, 2, 3 }));
+}
+
+// ====================================================================================================================
+TEST(unroll_constant_step)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 16 }, VarScope::Local);
+	make_for(ir, func->body, arr, 1, 8, 3);
+	CHECK(ir::UnrollLoops(ir.module, *func));
+	CHECK(check_indices(func->body, { 1, 4, 7 }));
+}
+
+// ====================================================================================================================
+TEST(unroll_hint_limit)
+{
+	// 20 trips is over the default limit, but within the limit for [[unroll]]
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 32 }, VarScope::Local);
+	auto loop = make_for(ir, func->body, arr, 0, 20, 0);
+	CHECK(!ir::UnrollLoops(ir.module, *func));
+	CHECK(func->body.first == loop);
+
+	loop->hint = ir::LoopHint::Unroll;
+	CHECK(ir::UnrollLoops(ir.module, *func));
+	std::vector<int32> indices{ };
+	for (int32 i = 0; i < 20; ++i)
+		indices.push_back(i);
+	CHECK(check_indices(func->body, indices));
+}
+
+// ====================================================================================================================
+TEST(unroll_dont_unroll_hint)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Local);
+	auto loop = make_for(ir, func->body, arr, 0, 2, 0);
+	loop->hint = ir::LoopHint::DontUnroll;
+	CHECK(!ir::UnrollLoops(ir.module, *func));
+	CHECK(CountStmts(func->body) == 1 && func->body.first == loop);
+}
+
+// ====================================================================================================================
+TEST(unroll_skips_loop_control)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Local);
+	auto x = ir.sym("x", HLSVType::Float, VarScope::Local);
+	for (auto kind : { ir::StmtKind::Break, ir::StmtKind::Continue }) {
+		auto loop = make_for(ir, func->body, arr, 0, 2, 0);
+		auto br = ir.branch(loop->body, ir.bin(ir::Op::Gt, ir.var(x), ir.lit(0.0f), HLSVType::Bool));
+		br->body.append(ir.module.new_stmt(kind, 1));
+	}
+	CHECK(!ir::UnrollLoops(ir.module, *func));
+	CHECK(CountStmts(func->body) == 2);
+	uint32 count = 0;
+	CHECK(!ir::GetTripCount(ir.module, func->body.first, 16, count));
+}
+
+// ====================================================================================================================
+TEST(unroll_skips_modified_counter)
+{
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Local);
+	auto loop = make_for(ir, func->body, arr, 0, 2, 0);
+	ir.assign(loop->body, ir.var(loop->symbol), ir.lit(1), ir::Op::Add);
+	CHECK(!ir::UnrollLoops(ir.module, *func));
+	CHECK(func->body.first == loop);
+
+	auto loop2 = make_for(ir, func->body, arr, 0, 2, 0); // The same loop without the change has two trips
+	uint32 count = 0;
+	CHECK(ir::GetTripCount(ir.module, loop2, 16, count) && count == 2);
+}
+
+// ====================================================================================================================
+TEST(unroll_scopes_declarations)
+{
+	// for (int i = 0; i < 3; i++) { int t = i; arr[t] = 1.0; } -- each copy keeps its own 't'
+	IRBuilder ir{ };
+	auto func = ir.module.new_function(ShaderStages::Fragment);
+	auto arr = ir.sym("arr", HLSVType{ HLSVType::Float, 4 }, VarScope::Local);
+	auto loop = make_for(ir, func->body, arr, 0, 3, 0);
+	loop->body = { nullptr, nullptr };
+	auto t = ir.sym("t", HLSVType::Int);
+	ir.declare(loop->body, t, ir.var(loop->symbol));
+	ir.assign(loop->body, ir.index(ir.var(arr), ir.var(t), HLSVType::Float), ir.lit(1.0f));
+
+	CHECK(ir::UnrollLoops(ir.module, *func));
+	CHECK(CountStmts(func->body) == 3);
+	int32 idx = 0;
+	for (auto stmt = func->body.first; stmt; stmt = stmt->next, ++idx) {
+		CHECK(stmt->kind == ir::StmtKind::If && stmt->value->is_literal() && stmt->value->value.ui != 0u);
+		CHECK(stmt->else_body.empty() && CountStmts(stmt->body) == 2);
+		auto decl = stmt->body.first;
+		CHECK(decl->kind == ir::StmtKind::Declare && decl->symbol != t);
+		CHECK(decl->value->is_literal() && decl->value->value.si == idx);
+		CHECK(stmt->body.last->target->args[1]->symbol == decl->symbol);
+	}
+}
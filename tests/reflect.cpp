@@ -0,0 +1,42 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the binary reflection format
+
+#include "test.hpp"
+#include "reflect/io.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// ====================================================================================================================
+TEST(reflect_binary_header_version)
+{
+	ReflectionInfo refl{ ShaderType::Graphics, HLSV_VERSION, 100 };
+	refl.stages = ShaderStages::Vertex | ShaderStages::Fragment;
+	string err{ }, path{ "hlsvtest_reflect.bin" };
+	CHECK(ReflWriter::WriteBinary(path, refl, err));
+	std::ifstream file{ path, std::ifstream::in | std::ifstream::binary };
+	std::vector<char> data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{ } };
+	file.close();
+	std::remove(path.c_str());
+
+	CHECK(ReflectionInfo::CheckBinaryHeader(data.data(), data.size()));
+	CHECK(!ReflectionInfo::CheckBinaryHeader(data.data(), 6));
+	CHECK(!ReflectionInfo::CheckBinaryHeader(nullptr, 0));
+	auto older = data;
+	older[5] = (char)(HLSV_VERSION_MINOR - 1); // A file from before the layout change
+	CHECK(!ReflectionInfo::CheckBinaryHeader(older.data(), older.size()));
+	auto bad = data;
+	bad[0] = 'X';
+	CHECK(!ReflectionInfo::CheckBinaryHeader(bad.data(), bad.size()));
+}
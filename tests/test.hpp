@@ -0,0 +1,131 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file declares the minimal test framework used by hlsvtest, and the helpers for building IR in the tests
+
+#pragma once
+
+#include "ir/passes.hpp"
+#include <chrono>
+#include <vector>
+
+
+namespace hlsvtest
+{
+
+using namespace hlsv;
+
+// A single registered test or benchmark
+struct TestEntry final
+{
+	const char* name;
+	void (*func)();
+	bool bench; // Benchmarks are only run with '--bench'
+};
+
+// Thrown by the checks to fail the current test
+struct TestFailure final
+{
+	string message;
+};
+
+// Gets the registered tests, in registration order
+std::vector<TestEntry>& GetTests();
+
+// Registers a test at static init time
+struct TestRegistrar final
+{
+	TestRegistrar(const char* name, void (*func)(), bool bench) { GetTests().push_back({ name, func, bench }); }
+};
+
+// Runs the function the given number of times, and returns the average time of each run in nanoseconds
+template<typename Func>
+double TimeRuns(uint32 runs, Func func)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32 i = 0; i < runs; ++i)
+		func();
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / runs;
+}
+
+// Builds IR with short calls, all nodes are given line 1
+struct IRBuilder final
+{
+	ir::Module module;
+
+	inline ir::Symbol* sym(const string& name, HLSVType type, VarScope scope = VarScope::Block) {
+		return module.new_symbol(name, type, scope);
+	}
+	inline ir::Expr* var(ir::Symbol* s) { return module.new_variable(s, 1); }
+	inline ir::Expr* lit(float f) { return module.new_literal(f, 1); }
+	inline ir::Expr* lit(int32 i) { return module.new_literal(i, 1); }
+	inline ir::Expr* bin(ir::Op op, ir::Expr* l, ir::Expr* r, HLSVType type) {
+		return module.new_binary(op, l, r, type, 1);
+	}
+	inline ir::Expr* index(ir::Expr* val, ir::Expr* idx, HLSVType type) { return module.new_index(val, idx, type, 1); }
+	inline ir::Expr* call(const string& name, HLSVType type, const std::vector<ir::Expr*>& args) {
+		return module.new_call(name, name, type, args, 1);
+	}
+	inline ir::Stmt* assign(ir::Block& block, ir::Expr* target, ir::Expr* value, ir::Op op = ir::Op::None) {
+		auto stmt = module.new_stmt(ir::StmtKind::Assign, 1);
+		stmt->op = op;
+		stmt->target = target;
+		stmt->value = value;
+		block.append(stmt);
+		return stmt;
+	}
+	inline ir::Stmt* declare(ir::Block& block, ir::Symbol* s, ir::Expr* value) {
+		auto stmt = module.new_stmt(ir::StmtKind::Declare, 1);
+		stmt->symbol = s;
+		stmt->value = value;
+		block.append(stmt);
+		return stmt;
+	}
+	inline ir::Stmt* branch(ir::Block& block, ir::Expr* cond) {
+		auto stmt = module.new_stmt(ir::StmtKind::If, 1);
+		stmt->value = cond;
+		block.append(stmt);
+		return stmt;
+	}
+	inline ir::Stmt* loop(ir::Block& block, ir::StmtKind kind, ir::Expr* cond) {
+		auto stmt = module.new_stmt(kind, 1);
+		stmt->value = cond;
+		block.append(stmt);
+		return stmt;
+	}
+};
+
+// Counts the statements directly in the block
+inline uint32 CountStmts(const ir::Block& block)
+{
+	uint32 count = 0;
+	for (auto stmt = block.first; stmt; stmt = stmt->next)
+		++count;
+	return count;
+}
+
+} // namespace hlsvtest
+
+
+// Defines and registers a test function
+#define TEST(name) \
+	static void test_##name(); \
+	static const hlsvtest::TestRegistrar test_reg_##name{ #name, test_##name, false }; \
+	static void test_##name()
+// Defines and registers a benchmark function, which prints its own results
+#define BENCH(name) \
+	static void bench_##name(); \
+	static const hlsvtest::TestRegistrar bench_reg_##name{ #name, bench_##name, true }; \
+	static void bench_##name()
+// Fails the current test if the condition is false
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+			throw hlsvtest::TestFailure{ hlsv::strarg("%s:%d: CHECK(%s) failed", __FILE__, __LINE__, #cond) }; \
+	} while (false)
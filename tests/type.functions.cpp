@@ -0,0 +1,87 @@
+/*
+ * The HLSV project and all associated files and assets, including this file, are licensed under the MIT license, the
+ *    text of which can be found in the LICENSE file at the root of this project, and is available online at
+ *    (https://opensource.org/licenses/MIT). In the event of redistribution of this code, this header, or the text of
+ *    the license itself, must not be removed from the source files or assets in which they appear.
+ * Copyright (c) 2019 Sean Moss [moss.seank@gmail.com]
+ */
+
+// This file contains the tests for the builtin function lookups
+
+#include "test.hpp"
+#include "type/functions.hpp"
+#include <chrono>
+
+using namespace hlsv;
+using namespace hlsvtest;
+
+
+// A builtin call, and the expected result of checking it
+struct FunctionCase final
+{
+	const char* name;
+	std::vector<HLSVType> args;
+	HLSVType::PrimType ret; // Error if the call is invalid
+	const char* out_name;
+};
+
+// A spread of overloads from the start, middle, and end of the builtin table
+static const std::vector<FunctionCase>& get_cases()
+{
+	static const std::vector<FunctionCase> CASES = {
+		{ "sin", { HLSVType::Float }, HLSVType::Float, "sin" },
+		{ "sin", { HLSVType::Float3 }, HLSVType::Float3, "sin" },
+		{ "sqrt", { HLSVType::Float4 }, HLSVType::Float4, "sqrt" },
+		{ "max", { HLSVType::Int2, HLSVType::Int }, HLSVType::Int2, "max" },
+		{ "max", { HLSVType::Float3, HLSVType::Float3 }, HLSVType::Float3, "max" },
+		{ "clamp", { HLSVType::Float2, HLSVType::Float, HLSVType::Float }, HLSVType::Float2, "clamp" },
+		{ "clamp", { HLSVType::UInt, HLSVType::UInt, HLSVType::UInt }, HLSVType::UInt, "clamp" },
+		{ "mix", { HLSVType::Float4, HLSVType::Float4, HLSVType::Float }, HLSVType::Float4, "mix" },
+		{ "select", { HLSVType::Float, HLSVType::Float, HLSVType::Bool }, HLSVType::Float, "mix" },
+		{ "len", { HLSVType::Float3 }, HLSVType::Float, "length" },
+		{ "dot", { HLSVType::Float3, HLSVType::Float3 }, HLSVType::Float, "dot" },
+		{ "sizeof", { HLSVType::Tex2D, HLSVType::Int }, HLSVType::Int2, "textureSize" },
+		{ "levelsof", { HLSVType::Tex2D }, HLSVType::Int, "textureQueryLevels" },
+		{ "dot", { HLSVType::Float3, HLSVType::Float2 }, HLSVType::Error, "" },
+		{ "sin", { HLSVType::Bool }, HLSVType::Error, "" },
+		{ "not_a_function", { HLSVType::Float }, HLSVType::Error, "" }
+	};
+	return CASES;
+}
+
+// ====================================================================================================================
+static bool check_case(const FunctionCase& fc)
+{
+	string err{ }, out_name{ };
+	HLSVType ret{ HLSVType::Error };
+	bool valid = FunctionRegistry::CheckFunction(fc.name, fc.args, err, ret, out_name);
+	if (fc.ret == HLSVType::Error)
+		return !valid;
+	return valid && (ret == fc.ret) && (out_name == fc.out_name);
+}
+
+// ====================================================================================================================
+TEST(function_overload_lookup)
+{
+	for (const auto& fc : get_cases())
+		CHECK(check_case(fc));
+}
+
+// ====================================================================================================================
+BENCH(function_lookup)
+{
+	// The first lookup includes any lazy table setup, the rest are the per-call cost seen by the visitor
+	const auto& cases = get_cases();
+	auto start = std::chrono::high_resolution_clock::now();
+	bool first = check_case(cases[0]);
+	auto end = std::chrono::high_resolution_clock::now();
+	double first_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	bool valid = true;
+	double ns = TimeRuns(2000, [&]() {
+		for (const auto& fc : cases)
+			valid = check_case(fc) && valid;
+	});
+	std::printf("  first lookup: %.1f us, %.1f ns per lookup over %u calls\n", first_ns / 1000.0,
+		ns / cases.size(), (uint32)cases.size());
+	CHECK(first && valid);
+}